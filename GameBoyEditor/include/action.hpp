@@ -1,19 +1,127 @@
 ﻿#pragma once
 
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "change_bus.hpp"
 #include "core.hpp"
 
-#include <string>
+class ArchiveReader;
+class ArchiveWriter;
+
+// Actions that can be written to the history file, the values are stored in it
+enum class ActionKind : uint8_t
+{
+    None,
+    EditTilemap,
+    PlotPixel,
+    GraphicsAddTile,
+    GraphicsDeleteTile,
+    GraphicsMoveTile,
+    ReplaceTile
+};
+
+// Name of the actions of a kind, actions read back from the history file are only known by their kind
+_NODISCARD constexpr const char* GetActionName(const ActionKind kind)
+{
+    switch (kind)
+    {
+        case ActionKind::EditTilemap: return "Edit tilemap";
+        case ActionKind::PlotPixel: return "Edit graphics";
+        case ActionKind::GraphicsAddTile: return "Add tile";
+        case ActionKind::GraphicsDeleteTile: return "Delete tile";
+        case ActionKind::GraphicsMoveTile: return "Move tile";
+        case ActionKind::ReplaceTile: return "Replace tile";
+
+        case ActionKind::None:
+            return "";
+    }
+
+    return "";
+}
+
+// Asset written by an action, two actions without a common asset can be undone in any order
+struct AssetTag
+{
+    // Every asset of the type, for actions restoring a whole store
+    static constexpr uint32_t AnyTarget = std::numeric_limits<uint32_t>::max();
+
+    ChangeType type;
+    uint32_t target;
+
+    _NODISCARD bool_t operator==(const AssetTag& other) const = default;
+};
 
 class Action
 {
 public:
-    explicit Action(std::string n) : name(std::move(n)) {}
+    // The name is a literal, the assets are allocated from the same resource as the action
+    explicit Action(const char* const n, std::pmr::memory_resource* const resource = std::pmr::get_default_resource()) : name(n), m_Assets(resource) {}
     virtual ~Action() = default;
 
     DEFAULT_COPY_MOVE_OPERATIONS(Action)
 
-    std::string name;
+    const char* name;
 
     virtual void Do() = 0;
     virtual void Undo() = 0;
+
+    // Bytes owned by the action, used to bound the memory of the undo history
+    _NODISCARD virtual size_t GetMemoryFootprint() const = 0;
+
+    // Absorbs an action pushed right after this one, returns false if they should stay separate steps
+    virtual bool_t Merge(const Action&) { return false; }
+    // Called on the actions deep in the undo history, Do and Undo have to work with the compressed data
+    virtual void Compress() {}
+
+    // Actions of kind None only live in memory, the history kept across sessions starts after the last one of them
+    _NODISCARD virtual ActionKind GetKind() const { return ActionKind::None; }
+    // Writes what Undo needs once the action is applied, read back by a constructor taking an ArchiveReader
+    virtual void Serialize(ArchiveWriter&) const {}
+
+    _NODISCARD std::span<const AssetTag> GetAssets() const { return m_Assets; }
+
+protected:
+    void Touch(ChangeType type, uint32_t target);
+    void Touch(std::span<const AssetTag> assets);
+
+private:
+    std::pmr::vector<AssetTag> m_Assets;
+};
+
+inline void Action::Touch(const ChangeType type, const uint32_t target)
+{
+    const AssetTag asset(type, target);
+    if (!std::ranges::contains(m_Assets, asset))
+        m_Assets.push_back(asset);
+}
+
+inline void Action::Touch(const std::span<const AssetTag> assets)
+{
+    for (const AssetTag& asset : assets)
+        Touch(asset.type, asset.target);
+}
+
+// Gives an action back to the memory resource it was allocated from
+struct ActionDeleter
+{
+    std::pmr::memory_resource* resource = nullptr;
+    size_t size = 0;
+    size_t alignment = 0;
+
+    void operator()(Action* const action) const
+    {
+        // Address of the whole object, which was the one allocated
+        void* const block = dynamic_cast<void*>(action);
+        action->~Action();
+        resource->deallocate(block, size, alignment);
+    }
 };
+
+// Owning pointer to an action allocated by an ActionQueue
+template <typename T>
+using ActionHandle = std::unique_ptr<T, ActionDeleter>;
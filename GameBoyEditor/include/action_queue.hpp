@@ -1,18 +1,72 @@
 ﻿#pragma once
 
-#include <array>
+#include <chrono>
+#include <filesystem>
+#include <limits>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #include "action.hpp"
 #include "core.hpp"
+#include "history_file.hpp"
 
+// Assets a view of the history goes through, it sees the actions touching one of them
+using ActionView = std::span<const AssetTag>;
+
+// Undo history bounded by the memory used by the actions rather than by their count, the oldest actions are dropped first
 class ActionQueue
 {
-    static constexpr size_t QueueSize = 30;
+    static constexpr size_t InitialCapacity = 64;
+    // Actions pushed this soon after the previous one are merged with it when they allow it
+    static constexpr std::chrono::milliseconds CoalesceWindow { 500 };
+    // Number of recent actions left uncompressed, they are the most likely to be undone
+    static constexpr size_t UncompressedCount = 8;
+    // Number of recent actions kept in memory when the history has a file, the older ones are read back when undone
+    static constexpr size_t HotCount = 64;
 
 public:
-    void Push(Action* action, bool_t perform = false);
+    static constexpr size_t DefaultMemoryBudget = 16ull * 1024 * 1024;
+
+    ActionQueue() = default;
+    ~ActionQueue();
+
+    DELETE_COPY_MOVE_OPERATIONS(ActionQueue)
+
+    // Allocates the action from the pool of the queue, along with its edit buffers if it takes a memory resource as last argument
+    template <typename T, typename... Args>
+    _NODISCARD ActionHandle<T> Create(Args&&... args);
+
+    void Push(ActionHandle<Action> action, bool_t perform = false);
     void StepForward();
     void StepBack();
+    // Undoes the last action of a view. The actions applied after it are kept as long as none of them shares an asset with it,
+    // otherwise undoing it would lose their edits and nothing is done
+    void StepBack(ActionView view);
+    // Redoes the next action of a view, under the same conditions.
+    // Both only follow the chains of the assets of the view and of the action found, never the history itself, so they take
+    // the same time with ten actions in the history or ten thousand, and spilled actions are only read if they are the one done
+    void StepForward(ActionView view);
+    _NODISCARD bool_t CanGoBackward(const ActionView view) const { return Find(view, true) != NoEntry; }
+    _NODISCARD bool_t CanGoForward(const ActionView view) const { return Find(view, false) != NoEntry; }
+    // Changes whenever the actions or their order change, for the views to only look for what they can undo and redo then
+    _NODISCARD size_t GetVersion() const { return m_Version; }
+
+    // Compresses at most one old action and moves at most one to the history file, called every frame so that pushing never pays for it
+    void Compact();
+
+    // Replaces the history with the one kept in the file, if it still matches the project
+    void OpenHistory(const std::filesystem::path& path);
+    // Called once the project is saved, the applied actions become the history found in the file on the next session
+    void Checkpoint();
+
+    // The last action is always kept, even if it doesn't fit in the budget on its own
+    void SetMemoryBudget(size_t bytes);
+    _NODISCARD size_t GetMemoryBudget() const { return m_MemoryBudget; }
+    _NODISCARD size_t GetMemoryUsage() const { return m_MemoryUsage; }
+    _NODISCARD size_t GetSize() const { return m_Count; }
 
     _NODISCARD bool_t IsAtBeginning() const;
     _NODISCARD bool_t IsAtEnd() const;
@@ -21,9 +75,145 @@ public:
     _NODISCARD bool_t CanGoBackward() const;
 
 private:
-    std::array<Action*, QueueSize> m_Queue {};
-    size_t m_QueueIndex = 0;
+    static constexpr size_t NoEntry = std::numeric_limits<size_t>::max();
+    // Target in the key of the chain of every asset of a type, past the targets of the assets
+    static constexpr uint64_t WholeType = 1ull << 32;
+
+    struct Entry
+    {
+        ActionHandle<Action> action;
+        // Measured when the action is pushed
+        size_t footprint;
+        // Record of the action in the history file, reset when the action changes
+        uint64_t offset = HistoryFile::NoOffset;
+        // Only the record is left, the action is a SpilledAction
+        bool_t spilled = false;
+
+        // Neighbors in the order of the history
+        size_t previous = NoEntry;
+        size_t next = NoEntry;
+
+        // Applied actions get increasing orders and unapplied ones decreasing orders, so each side compares in the order of the history
+        uint64_t order = 0;
+        // Links of the action in the chains of its assets, chained by sibling
+        size_t firstLink = NoEntry;
+    };
+
+    // Actions touching an asset, in the order of the history. The applied ones are reached from the last of them,
+    // the unapplied ones from the first of them
+    struct Chain
+    {
+        AssetTag asset;
+        // Every action touching an asset of the type, for the actions touching AnyTarget
+        bool_t wholeType;
+        size_t lastApplied = NoEntry;
+        size_t firstUnapplied = NoEntry;
+    };
+
+    // Place of an action in a chain
+    struct TagLink
+    {
+        size_t entry;
+        size_t chain;
+        size_t previous = NoEntry;
+        size_t next = NoEntry;
+        size_t sibling = NoEntry;
+    };
+
+    // Entry at a position of the history, the entry is NoEntry past the end
+    struct Location
+    {
+        size_t position;
+        size_t entry = NoEntry;
+    };
+
+    // Has to outlive the actions
+    std::pmr::unsynchronized_pool_resource m_Pool;
 
-    void ShiftActions();
+    // Linked in the order of the history from m_First to m_Last, so an action is moved without shifting the others.
+    // The first m_Index of the m_Count actions are applied, m_LastApplied is the last of them
+    std::vector<Entry> m_Entries;
+    std::vector<size_t> m_FreeEntries;
+    size_t m_First = NoEntry;
+    size_t m_Last = NoEntry;
+    size_t m_LastApplied = NoEntry;
+    size_t m_Count = 0;
+    size_t m_Index = 0;
+    // Actions before this location have been compressed
+    Location m_NextToCompress { 0 };
+    // Actions before this location are only in the history file, or couldn't be written to it
+    Location m_NextToSpill { 0 };
+    uint64_t m_NextAppliedOrder = 0;
+    uint64_t m_NextUnappliedOrder = std::numeric_limits<uint64_t>::max();
+
+    // Chains of every asset touched by an action of the history, they are kept until the history is cleared
+    std::vector<Chain> m_Chains;
+    std::unordered_map<uint64_t, size_t> m_ChainIndices;
+    std::vector<TagLink> m_Links;
+    std::vector<size_t> m_FreeLinks;
+
+    size_t m_Version = 0;
+
+    HistoryFile m_History;
+
+    std::chrono::steady_clock::time_point m_LastPush;
+
+    size_t m_MemoryBudget = DefaultMemoryBudget;
+    size_t m_MemoryUsage = 0;
+
+    _NODISCARD size_t GetFirstUnapplied() const { return m_LastApplied == NoEntry ? m_First : m_Entries[m_LastApplied].next; }
+
+    // Last applied action of a view, or first unapplied one, NoEntry if there is none or it can't be moved to the boundary
+    _NODISCARD size_t Find(ActionView view, bool_t applied) const;
+    // Whether an action between this one and the boundary shares an asset with it
+    _NODISCARD bool_t IsBlocked(size_t entry, bool_t applied) const;
+    // Action of a chain nearest to the boundary on one side of it
+    _NODISCARD size_t GetNearest(size_t chain, bool_t applied) const;
+    _NODISCARD bool_t IsNearer(size_t entry, size_t other, bool_t applied) const;
+    // Makes an applied action the last applied one, or an unapplied action the first unapplied one
+    void MoveToBoundary(size_t entry, bool_t applied);
+    // Keeps a location on the same action, or on the position it has to resume from, when the action moves to the boundary
+    void MoveCursor(Location& cursor, size_t entry, bool_t applied, size_t next) const;
+
+    _NODISCARD static uint64_t GetChainKey(ChangeType type, uint64_t target) { return static_cast<uint64_t>(type) << 33 | target; }
+    _NODISCARD size_t FindChain(uint64_t key) const;
+    _NODISCARD size_t FindLink(size_t entry, size_t chain) const;
+    // Adds the action to the chains of its assets, next to the boundary on its side
+    void LinkTags(size_t entry, bool_t applied);
+    void UnlinkTags(size_t entry, bool_t applied);
+    // Moves the action next to the boundary in the chains of its assets, for when it moves there in the history
+    void MoveTags(size_t entry, bool_t wasApplied, bool_t applied);
+    void Attach(size_t link, bool_t applied);
+    void Detach(size_t link, bool_t applied);
+
+    // The action comes after the others, applied
+    _NODISCARD size_t Append(Entry entry);
+    void Unlink(size_t entry);
+    void Link(size_t entry, size_t before);
+    void Release(size_t entry);
+
+    void Spill(Entry& entry);
+    // Reads the action back from the history file, returns false if the record is unusable
+    bool_t Restore(Entry& entry);
+    _NODISCARD ActionHandle<Action> Load(ActionKind kind, ArchiveReader& reader);
+
+    void Clear();
+    void Remeasure(Entry& entry);
+    void Trim();
+    void DropOldest();
     void RerouteQueue();
 };
+
+template <typename T, typename... Args>
+ActionHandle<T> ActionQueue::Create(Args&&... args)
+{
+    void* const block = m_Pool.allocate(sizeof(T), alignof(T));
+
+    T* action;
+    if constexpr (std::is_constructible_v<T, Args..., std::pmr::memory_resource*>)
+        action = new (block) T(std::forward<Args>(args)..., &m_Pool);
+    else
+        action = new (block) T(std::forward<Args>(args)...);
+
+    return ActionHandle<T>(action, ActionDeleter(&m_Pool, sizeof(T), alignof(T)));
+}
@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include <memory_resource>
 #include <vector>
 
 #include "action.hpp"
@@ -8,14 +9,33 @@
 class EditTilemapAction : public Action
 {
 public:
-    explicit EditTilemapAction(Tilemap* const tilemap) : Action("Edit tilemap"), m_Tilemap(tilemap) {}
+    explicit EditTilemapAction(const TilemapHandle tilemap, std::pmr::memory_resource* const resource = std::pmr::get_default_resource())
+        : Action(GetActionName(ActionKind::EditTilemap), resource), m_Edits(resource), m_Touched(resource), m_Tilemap(tilemap), m_Compressed(resource)
+    {
+        Touch(ChangeType::Tilemap, tilemap.index);
+    }
+
+    // Read back from the history file, the cell bitmap isn't kept so the action can't be merged anymore
+    explicit EditTilemapAction(ArchiveReader& reader, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     void Do() override;
     void Undo() override;
+    _NODISCARD size_t GetMemoryFootprint() const override;
+
+    // Strokes on the same tilemap close to each other
+    bool_t Merge(const Action& next) override;
+    void Compress() override;
+
+    _NODISCARD ActionKind GetKind() const override { return ActionKind::EditTilemap; }
+    void Serialize(ArchiveWriter& writer) const override;
 
-    void AddEdit(uint8_t x, uint8_t y, uint8_t oldValue, uint8_t newValue);
+    // Only the first edit of a cell is kept, the new values are read back from the tilemap when undoing
+    void AddEdit(uint8_t x, uint8_t y, uint8_t oldValue);
 
 private:
+    // Distance in cells under which two strokes are merged
+    static constexpr int32_t MergeDistance = 2;
+
     struct BlockEdit
     {
         uint8_t x;
@@ -24,6 +44,24 @@ private:
         uint8_t newValue;
     };
 
-    std::vector<BlockEdit> m_Edits {};
-    Tilemap* m_Tilemap;
+    // Returns false if the compressed data is shorter than the edits need
+    bool_t Decompress();
+    // Checks the edits read back from the history file against the tilemap as it is now
+    _NODISCARD bool_t Validate();
+
+    std::pmr::vector<BlockEdit> m_Edits;
+    // One bit per cell of the tilemap, set once the cell has an edit
+    std::pmr::vector<bool_t> m_Touched;
+    size_t m_Width = 0;
+    TilemapHandle m_Tilemap;
+
+    // Bounding box of the edits
+    uint8_t m_MinX = 0xFF;
+    uint8_t m_MinY = 0xFF;
+    uint8_t m_MaxX = 0;
+    uint8_t m_MaxY = 0;
+
+    // Once compressed, the edits are sorted by cell and each of their fields is run-length encoded separately
+    std::pmr::vector<uint8_t> m_Compressed;
+    size_t m_CompressedCount = 0;
 };
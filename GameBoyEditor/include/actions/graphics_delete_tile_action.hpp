@@ -1,18 +1,30 @@
 ﻿#pragma once
 
+#include <memory_resource>
+
 #include "action.hpp"
 #include "parser.hpp"
+#include "tile_remap.hpp"
 
+// Deletes a tile, the references to the tiles after it follow them and the ones to the deleted tile use tile 0
 class GraphicsDeleteTileAction : public Action
 {
 public:
-    explicit GraphicsDeleteTileAction(Graphics* graphics, size_t position);
+    explicit GraphicsDeleteTileAction(GraphicsHandle graphics, size_t position, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Read back from the history file
+    explicit GraphicsDeleteTileAction(ArchiveReader& reader, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     void Do() override;
     void Undo() override;
+    _NODISCARD size_t GetMemoryFootprint() const override;
+
+    _NODISCARD ActionKind GetKind() const override { return ActionKind::GraphicsDeleteTile; }
+    void Serialize(ArchiveWriter& writer) const override;
 
 private:
-    Graphics* m_Graphics;
+    GraphicsHandle m_Graphics;
     size_t m_Position;
-    std::array<uint8_t, 16> m_Tile;
+    Tile m_Tile;
+    TileRemap m_Remap;
 };
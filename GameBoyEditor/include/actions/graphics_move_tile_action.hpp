@@ -0,0 +1,32 @@
+﻿#pragma once
+
+#include <memory_resource>
+
+#include "action.hpp"
+#include "parser.hpp"
+#include "tile_remap.hpp"
+
+// Moves a tile to another index, every reference follows the tiles that move
+class GraphicsMoveTileAction : public Action
+{
+public:
+    explicit GraphicsMoveTileAction(GraphicsHandle graphics, size_t from, size_t to, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Read back from the history file
+    explicit GraphicsMoveTileAction(ArchiveReader& reader, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void Do() override;
+    void Undo() override;
+    _NODISCARD size_t GetMemoryFootprint() const override;
+
+    _NODISCARD ActionKind GetKind() const override { return ActionKind::GraphicsMoveTile; }
+    void Serialize(ArchiveWriter& writer) const override;
+
+private:
+    void Move(size_t from, size_t to) const;
+
+    GraphicsHandle m_Graphics;
+    size_t m_From;
+    size_t m_To;
+    TileRemap m_Remap;
+};
@@ -1,7 +1,7 @@
 ﻿#pragma once
 
-#pragma once
-
+#include <bitset>
+#include <memory_resource>
 #include <vector>
 
 #include "action.hpp"
@@ -10,25 +10,40 @@
 class PlotPixelAction : public Action
 {
 public:
-    explicit PlotPixelAction(Graphics* const graphics) : Action("Edit graphics"), m_Graphics(graphics) {}
+    explicit PlotPixelAction(const GraphicsHandle graphics, std::pmr::memory_resource* const resource = std::pmr::get_default_resource())
+        : Action(GetActionName(ActionKind::PlotPixel), resource), m_Rows(resource), m_OldPlanes(resource), m_NewPlanes(resource), m_Graphics(graphics)
+    {
+        Touch(ChangeType::Graphics, graphics.index);
+    }
+
+    // Read back from the history file
+    explicit PlotPixelAction(ArchiveReader& reader, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     void Do() override;
     void Undo() override;
+    _NODISCARD size_t GetMemoryFootprint() const override;
 
-    void AddEdit(uint8_t tile, uint8_t row, uint8_t oldPlane0, uint8_t oldPlane1, uint8_t newPlane0, uint8_t newPlane1);
+    // Strokes on the same or neighbouring tiles of a graphics set
+    bool_t Merge(const Action& next) override;
+
+    _NODISCARD ActionKind GetKind() const override { return ActionKind::PlotPixel; }
+    void Serialize(ArchiveWriter& writer) const override;
+
+    // Only the first edit of a row is kept, the new planes are read back from the graphics when undoing
+    void AddEdit(uint8_t tile, uint8_t row, uint8_t oldPlane0, uint8_t oldPlane1);
 
 private:
-    struct PixelEdit
-    {
-        uint8_t tile;
-        uint8_t row;
-        uint8_t oldPlane0;
-        uint8_t oldPlane1;
-        uint8_t newPlane0;
-        uint8_t newPlane1;
-    };
-
-    std::vector<PixelEdit> m_Edits {};
-    Graphics* m_Graphics;
+    static constexpr size_t MaxRows = 256 * 8;
+
+    void PublishChange() const;
+
+    // Structure of arrays indexed by edit, a row is tile * 8 + row and its 2 planes are packed like in Tile::data
+    std::pmr::vector<uint16_t> m_Rows;
+    std::pmr::vector<uint16_t> m_OldPlanes;
+    std::pmr::vector<uint16_t> m_NewPlanes;
+    std::bitset<MaxRows> m_Touched;
+    uint8_t m_FirstTile = 0xFF;
+    uint8_t m_LastTile = 0;
+    GraphicsHandle m_Graphics;
 };
 
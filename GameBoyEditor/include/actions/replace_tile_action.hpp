@@ -0,0 +1,30 @@
+﻿#pragma once
+
+#include <memory_resource>
+
+#include "action.hpp"
+#include "parser.hpp"
+#include "tile_remap.hpp"
+
+// Replaces a tile with another one in every tilemap and animation using the graphics set
+class ReplaceTileAction : public Action
+{
+public:
+    explicit ReplaceTileAction(GraphicsHandle graphics, uint8_t oldTile, uint8_t newTile, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Read back from the history file
+    explicit ReplaceTileAction(ArchiveReader& reader, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void Do() override;
+    void Undo() override;
+    _NODISCARD size_t GetMemoryFootprint() const override;
+
+    _NODISCARD ActionKind GetKind() const override { return ActionKind::ReplaceTile; }
+    void Serialize(ArchiveWriter& writer) const override;
+
+    _NODISCARD size_t GetReferenceCount() const { return m_Remap.GetReferenceCount(); }
+
+private:
+    GraphicsHandle m_Graphics;
+    TileRemap m_Remap;
+};
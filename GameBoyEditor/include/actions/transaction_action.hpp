@@ -0,0 +1,31 @@
+﻿#pragma once
+
+#include <functional>
+#include <memory_resource>
+#include <vector>
+
+#include "action.hpp"
+#include "change_bus.hpp"
+#include "parser.hpp"
+
+// Edits grouped by a Transaction, undone and redone by putting back only the parts of the project they changed
+class TransactionAction : public Action
+{
+public:
+    explicit TransactionAction(const char* name, ProjectPatch undo, ProjectPatch redo, std::vector<ChangeEvent> events,
+        std::vector<std::function<void()>> effects, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void Do() override;
+    void Undo() override;
+    _NODISCARD size_t GetMemoryFootprint() const override;
+
+private:
+    ProjectPatch m_Undo;
+    ProjectPatch m_Redo;
+    std::vector<ChangeEvent> m_Events;
+    // Deferred effects of the transaction, they write from the current state of the project so they also follow undo and redo
+    std::vector<std::function<void()>> m_Effects;
+
+    void Apply(const ProjectPatch& patch) const;
+    void TouchPatch(const ProjectPatch& patch);
+};
@@ -0,0 +1,124 @@
+﻿#pragma once
+
+#include <cstring>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "asset_store.hpp"
+#include "core.hpp"
+
+// Binary writer for the data the editor keeps outside of the project sources, values are stored in the native byte order
+class ArchiveWriter
+{
+public:
+    explicit ArchiveWriter(std::vector<uint8_t>& buffer) : m_Buffer(buffer) {}
+
+    template <typename T>
+    void Write(const T& value);
+    // Writes the count then the values
+    template <typename T>
+    void WriteSpan(std::span<const T> values);
+    void WriteString(const std::string& value);
+    // Assets are written by name, their handles change between sessions
+    template <typename T>
+    void WriteHandle(const AssetStore<T>& store, AssetHandle<T> handle);
+
+private:
+    std::vector<uint8_t>& m_Buffer;
+
+    void WriteBytes(const void* source, size_t size);
+};
+
+class ArchiveReader
+{
+public:
+    explicit ArchiveReader(const std::span<const uint8_t> data) : m_Data(data) {}
+
+    template <typename T>
+    _NODISCARD T Read();
+    // Resizes the container to the count that was written
+    template <typename Container>
+    void ReadSpan(Container& values);
+    _NODISCARD std::string ReadString();
+    // Null if the asset doesn't exist anymore, which sets the failure since what was read can't be applied to it
+    template <typename T>
+    _NODISCARD AssetHandle<T> ReadHandle(const AssetStore<T>& store);
+
+    // Reading past the end gives zeroes and sets this
+    _NODISCARD bool_t HasFailed() const { return m_Failed; }
+    _NODISCARD size_t GetPosition() const { return m_Position; }
+    // For the values that were read fine but don't make sense
+    void Fail() { m_Failed = true; }
+
+private:
+    std::span<const uint8_t> m_Data;
+    size_t m_Position = 0;
+    bool_t m_Failed = false;
+
+    void ReadBytes(void* destination, size_t size);
+};
+
+template <typename T>
+void ArchiveWriter::Write(const T& value)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be written as is");
+    WriteBytes(&value, sizeof(T));
+}
+
+template <typename T>
+void ArchiveWriter::WriteSpan(const std::span<const T> values)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be written as is");
+    Write<uint32_t>(static_cast<uint32_t>(values.size()));
+    WriteBytes(values.data(), values.size_bytes());
+}
+
+template <typename T>
+void ArchiveWriter::WriteHandle(const AssetStore<T>& store, const AssetHandle<T> handle)
+{
+    WriteString(store.IsValid(handle) ? store.GetName(handle) : std::string());
+}
+
+template <typename T>
+T ArchiveReader::Read()
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be read as is");
+    T value {};
+    ReadBytes(&value, sizeof(T));
+    return value;
+}
+
+template <typename Container>
+void ArchiveReader::ReadSpan(Container& values)
+{
+    using T = typename Container::value_type;
+    static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be read as is");
+
+    const size_t count = Read<uint32_t>();
+    // A corrupted count would otherwise allocate a huge buffer
+    if (count * sizeof(T) > m_Data.size() - m_Position)
+    {
+        m_Failed = true;
+        values.clear();
+        return;
+    }
+
+    values.resize(count);
+    ReadBytes(values.data(), count * sizeof(T));
+}
+
+template <typename T>
+AssetHandle<T> ArchiveReader::ReadHandle(const AssetStore<T>& store)
+{
+    const std::string name = ReadString();
+    if (name.empty())
+        return AssetHandle<T>();
+
+    const AssetHandle<T> handle = store.Find(name);
+    if (handle.IsNull())
+        m_Failed = true;
+
+    return handle;
+}
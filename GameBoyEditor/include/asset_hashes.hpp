@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "change_bus.hpp"
+#include "content_hash.hpp"
+#include "core.hpp"
+#include "parser.hpp"
+
+// Content hash of every asset, computed on demand and kept up to date from the ChangeBus.
+// Each asset is split in leaves (tiles, tilemap rows, animation frames, sprites, clipdata) combined in a binary tree,
+// an edit only rehashes the leaves it touched and their parents
+class AssetHashes
+{
+    STATIC_CLASS(AssetHashes)
+
+public:
+    // Forgets every hash, called when a project is loaded
+    static void Reset();
+
+    // Edits are only seen once the ChangeBus has been flushed
+    _NODISCARD static ContentHash Get(GraphicsHandle graphics);
+    _NODISCARD static ContentHash Get(TilemapHandle tilemap);
+    _NODISCARD static ContentHash Get(AnimationHandle animation);
+    _NODISCARD static ContentHash Get(SpriteDataHandle spriteData);
+    _NODISCARD static ContentHash Get(CollisionTableHandle collisionTable);
+
+private:
+    struct Tree
+    {
+        bool_t valid = false;
+        uint32_t generation = 0;
+        size_t leafCount = 0;
+        // Heap layout, the root is node 1 and the leaves start at the first power of 2 >= leafCount
+        std::vector<ContentHash> nodes;
+        std::vector<size_t> dirtyLeaves;
+    };
+
+    static constexpr size_t NoSubscription = std::numeric_limits<size_t>::max();
+
+    static inline std::vector<Tree> m_Graphics;
+    static inline std::vector<Tree> m_Tilemaps;
+    static inline std::vector<Tree> m_Animations;
+    static inline std::vector<Tree> m_SpriteData;
+    static inline std::vector<Tree> m_CollisionTables;
+
+    static inline size_t m_Subscription = NoSubscription;
+
+    static void OnChange(const ChangeEvent& event);
+    static void MarkDirty(std::vector<Tree>& trees, uint32_t index, size_t first, size_t last);
+
+    // Brings the tree up to date and returns its root, size is mixed in so that differently shaped assets don't collide
+    _NODISCARD static ContentHash Resolve(std::vector<Tree>& trees, uint32_t index, uint32_t generation, size_t leafCount, size_t size,
+        const std::function<ContentHash(size_t)>& hashLeaf);
+};
@@ -0,0 +1,386 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <ranges>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core.hpp"
+#include "state_patch.hpp"
+
+// Index of an asset in an AssetStore, the generation tells apart the assets that reused the same slot
+template <typename T>
+struct AssetHandle
+{
+    static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index = InvalidIndex;
+    uint32_t generation = 0;
+
+    _NODISCARD bool_t IsNull() const { return index == InvalidIndex; }
+    _NODISCARD bool_t operator==(const AssetHandle& other) const = default;
+};
+
+// Assets stored in a dense array, names are only looked up when resolving a handle.
+// Copying a store is O(1): the copies share the assets, and an asset is only duplicated when one of them writes to it through GetMutable.
+// A store only writes in place to what it created since it was last copied or journaled, which no other store can see, so a copy can be
+// read from another thread while the store is edited
+template <typename T>
+class AssetStore
+{
+public:
+    using Handle = AssetHandle<T>;
+
+    AssetStore() = default;
+    // Both stores duplicate what they share before writing to it
+    AssetStore(const AssetStore& other);
+    AssetStore(AssetStore&& other) noexcept;
+    ~AssetStore() = default;
+
+    AssetStore& operator=(const AssetStore& other);
+    AssetStore& operator=(AssetStore&& other) noexcept;
+
+    // Content of a slot, put back as is by the transactions
+    struct SlotState
+    {
+        uint32_t index;
+        bool_t alive;
+        std::string name;
+        std::shared_ptr<T> asset;
+    };
+
+    // Replaces the asset if the name already exists
+    Handle Add(const std::string& name, T asset);
+    // Returns the handle of the asset, adding an empty one if it doesn't exist yet.
+    // Meant for the parser, which can find a reference to an asset before the asset itself
+    Handle Acquire(const std::string& name);
+
+    _NODISCARD Handle Find(const std::string& name) const;
+    _NODISCARD bool_t IsValid(Handle handle) const;
+
+    // For writing to the asset, duplicates it first if a copy of the store still uses it. Null or stale handles give nullptr
+    _NODISCARD T* GetMutable(Handle handle);
+    // Never duplicates the asset. Null or stale handles give an empty asset
+    _NODISCARD const T& Get(Handle handle) const;
+    _NODISCARD const T& Get(const std::string& name) const { return Get(Find(name)); }
+    _NODISCARD const std::string& GetName(Handle handle) const;
+
+    _NODISCARD size_t GetSize() const { return static_cast<size_t>(std::ranges::count(m_Slots->alive, true)); }
+    // True if neither store was written to since one was copied from the other
+    _NODISCARD bool_t IsSharedWith(const AssetStore& other) const { return m_Assets == other.m_Assets && m_Slots == other.m_Slots; }
+
+    // Puts the slots back in the given states, without touching the others
+    void Restore(const std::vector<SlotState>& slotStates);
+
+    // While a journal is open, each slot is recorded as it was before its first write, so that a transaction only keeps and compares
+    // the slots it wrote to. Journals nest like the transactions. The journal isn't copied along with the store
+    void OpenJournal() { m_Journal.Open(); }
+    // Hands the slots of the innermost journal to the enclosing one
+    void MergeJournal() { m_Journal.Merge(); }
+    // Ends the outermost journal, giving the slots that changed as they were before and as they are now. Shares the assets,
+    // the store duplicates them before writing to them again
+    void CloseJournal(std::vector<SlotState>& before, std::vector<SlotState>& after);
+    // Ends the innermost journal and puts its slots back, returns them
+    std::vector<SlotState> RollbackJournal();
+
+    _NODISCARD auto GetHandles() const
+    {
+        return std::views::iota(static_cast<uint32_t>(0), static_cast<uint32_t>(m_Slots->names.size()))
+            | std::views::filter([this](const uint32_t i) { return m_Slots->alive[i]; })
+            | std::views::transform([this](const uint32_t i) { return Handle(i, m_Slots->generations[i]); });
+    }
+
+private:
+    static constexpr uint64_t NoOwner = 0;
+
+    struct Slots
+    {
+        std::vector<std::string> names;
+        std::vector<uint32_t> generations;
+        // Slots emptied by undoing the transaction that filled them aren't reused, redoing it fills them again
+        std::vector<bool_t> alive;
+
+        std::unordered_map<std::string, uint32_t> indices;
+        uint64_t owner = NoOwner;
+    };
+
+    struct Assets
+    {
+        std::vector<std::shared_ptr<T>> assets;
+        // Owner token of the store each asset was created by, only that store writes to it in place
+        std::vector<uint64_t> owners;
+        uint64_t owner = NoOwner;
+    };
+
+    static inline std::atomic<uint64_t> m_NextOwner = NoOwner + 1;
+
+    StateJournal<SlotState, &SlotState::index> m_Journal;
+
+    // Both are shared between the copies of the store until one of them changes
+    std::shared_ptr<Assets> m_Assets = std::make_shared<Assets>();
+    std::shared_ptr<Slots> m_Slots = std::make_shared<Slots>();
+    // Replaced each time the store is shared, so nothing it shared matches it anymore. Copying a snapshot from another thread
+    // replaces the token of the snapshot, hence the atomic
+    mutable std::atomic<uint64_t> m_Owner = NewOwner();
+
+    _NODISCARD static uint64_t NewOwner() { return m_NextOwner.fetch_add(1, std::memory_order_relaxed); }
+
+    _NODISCARD Assets& GetMutableAssets();
+    _NODISCARD Slots& GetMutableSlots();
+
+    // Called before the slot is written to. The journal shares the asset, so it is marked as shared too
+    void Record(uint32_t index);
+    // Shares the asset like Record
+    _NODISCARD SlotState GetState(uint32_t index);
+    void Put(const std::vector<SlotState>& slotStates);
+};
+
+template <typename T>
+AssetStore<T>::AssetStore(const AssetStore& other)
+    : m_Assets(other.m_Assets), m_Slots(other.m_Slots)
+{
+    other.m_Owner.store(NewOwner(), std::memory_order_relaxed);
+}
+
+template <typename T>
+AssetStore<T>::AssetStore(AssetStore&& other) noexcept
+    : m_Assets(std::move(other.m_Assets)), m_Slots(std::move(other.m_Slots)), m_Owner(other.m_Owner.load(std::memory_order_relaxed))
+{
+    // Nothing is shared, the other store is left empty
+    other.m_Assets = std::make_shared<Assets>();
+    other.m_Slots = std::make_shared<Slots>();
+    other.m_Owner.store(NewOwner(), std::memory_order_relaxed);
+}
+
+template <typename T>
+AssetStore<T>& AssetStore<T>::operator=(const AssetStore& other)
+{
+    if (this == &other)
+        return *this;
+
+    m_Assets = other.m_Assets;
+    m_Slots = other.m_Slots;
+    m_Owner.store(NewOwner(), std::memory_order_relaxed);
+    other.m_Owner.store(NewOwner(), std::memory_order_relaxed);
+    return *this;
+}
+
+template <typename T>
+AssetStore<T>& AssetStore<T>::operator=(AssetStore&& other) noexcept
+{
+    if (this == &other)
+        return *this;
+
+    m_Assets = std::move(other.m_Assets);
+    m_Slots = std::move(other.m_Slots);
+    m_Owner.store(other.m_Owner.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    other.m_Assets = std::make_shared<Assets>();
+    other.m_Slots = std::make_shared<Slots>();
+    other.m_Owner.store(NewOwner(), std::memory_order_relaxed);
+    return *this;
+}
+
+template <typename T>
+typename AssetStore<T>::Handle AssetStore<T>::Add(const std::string& name, T asset)
+{
+    const Handle handle = Acquire(name);
+    Record(handle.index);
+
+    Assets& assets = GetMutableAssets();
+    assets.assets[handle.index] = std::make_shared<T>(std::move(asset));
+    assets.owners[handle.index] = assets.owner;
+    return handle;
+}
+
+template <typename T>
+typename AssetStore<T>::Handle AssetStore<T>::Acquire(const std::string& name)
+{
+    const Handle existing = Find(name);
+    if (!existing.IsNull())
+        return existing;
+
+    const uint32_t index = static_cast<uint32_t>(m_Assets->assets.size());
+    Record(index);
+
+    Assets& assets = GetMutableAssets();
+    Slots& slots = GetMutableSlots();
+
+    assets.assets.push_back(std::make_shared<T>());
+    assets.owners.push_back(assets.owner);
+    slots.names.push_back(name);
+    slots.generations.push_back(0);
+    slots.alive.push_back(true);
+
+    slots.indices.emplace(name, index);
+    return Handle(index, slots.generations[index]);
+}
+
+template <typename T>
+void AssetStore<T>::Restore(const std::vector<SlotState>& slotStates)
+{
+    for (const SlotState& state : slotStates)
+        Record(state.index);
+
+    Put(slotStates);
+}
+
+template <typename T>
+void AssetStore<T>::CloseJournal(std::vector<SlotState>& before, std::vector<SlotState>& after)
+{
+    for (SlotState& state : m_Journal.Close())
+    {
+        SlotState current = GetState(state.index);
+        if (state.alive == current.alive && (!state.alive || (state.asset == current.asset && state.name == current.name)))
+            continue;
+
+        before.push_back(std::move(state));
+        after.push_back(std::move(current));
+    }
+}
+
+template <typename T>
+std::vector<typename AssetStore<T>::SlotState> AssetStore<T>::RollbackJournal()
+{
+    // Not recorded again, the enclosing journal either has these slots already or never saw them written to
+    std::vector<SlotState> slotStates = m_Journal.Close();
+    Put(slotStates);
+    return slotStates;
+}
+
+template <typename T>
+void AssetStore<T>::Put(const std::vector<SlotState>& slotStates)
+{
+    if (slotStates.empty())
+        return;
+
+    Assets& assets = GetMutableAssets();
+    Slots& slots = GetMutableSlots();
+
+    for (const SlotState& state : slotStates)
+    {
+        if (state.index >= assets.assets.size())
+        {
+            assets.assets.resize(state.index + 1);
+            assets.owners.resize(state.index + 1, NoOwner);
+            slots.names.resize(state.index + 1);
+            slots.generations.resize(state.index + 1, 0);
+            slots.alive.resize(state.index + 1, false);
+        }
+
+        // Another asset may have taken the name since
+        if (slots.alive[state.index])
+        {
+            const std::unordered_map<std::string, uint32_t>::const_iterator it = slots.indices.find(slots.names[state.index]);
+            if (it != slots.indices.end() && it->second == state.index)
+                slots.indices.erase(it);
+        }
+
+        // Shared with the state, written to in place by neither
+        assets.assets[state.index] = state.asset;
+        assets.owners[state.index] = NoOwner;
+        slots.names[state.index] = state.name;
+        slots.alive[state.index] = state.alive;
+
+        if (state.alive)
+            slots.indices[state.name] = state.index;
+    }
+}
+
+template <typename T>
+typename AssetStore<T>::Handle AssetStore<T>::Find(const std::string& name) const
+{
+    const std::unordered_map<std::string, uint32_t>::const_iterator it = m_Slots->indices.find(name);
+    if (it == m_Slots->indices.end())
+        return Handle();
+
+    return Handle(it->second, m_Slots->generations[it->second]);
+}
+
+template <typename T>
+bool_t AssetStore<T>::IsValid(const Handle handle) const
+{
+    return handle.index < m_Slots->names.size() && m_Slots->alive[handle.index] && m_Slots->generations[handle.index] == handle.generation;
+}
+
+template <typename T>
+T* AssetStore<T>::GetMutable(const Handle handle)
+{
+    if (!IsValid(handle))
+        return nullptr;
+
+    Record(handle.index);
+
+    Assets& assets = GetMutableAssets();
+    std::shared_ptr<T>& asset = assets.assets[handle.index];
+
+    // Created before the store was last shared, another store may be reading it
+    if (assets.owners[handle.index] != assets.owner)
+    {
+        asset = std::make_shared<T>(*asset);
+        assets.owners[handle.index] = assets.owner;
+    }
+
+    return asset.get();
+}
+
+template <typename T>
+const T& AssetStore<T>::Get(const Handle handle) const
+{
+    static const T empty {};
+    return IsValid(handle) ? *m_Assets->assets[handle.index] : empty;
+}
+
+template <typename T>
+const std::string& AssetStore<T>::GetName(const Handle handle) const
+{
+    static const std::string none = "<None>";
+    return IsValid(handle) ? m_Slots->names[handle.index] : none;
+}
+
+template <typename T>
+typename AssetStore<T>::Assets& AssetStore<T>::GetMutableAssets()
+{
+    // The assets keep their owners, so they are duplicated too before being written to
+    const uint64_t owner = m_Owner.load(std::memory_order_relaxed);
+    if (m_Assets->owner != owner)
+        m_Assets = std::make_shared<Assets>(m_Assets->assets, m_Assets->owners, owner);
+
+    return *m_Assets;
+}
+
+template <typename T>
+typename AssetStore<T>::Slots& AssetStore<T>::GetMutableSlots()
+{
+    const uint64_t owner = m_Owner.load(std::memory_order_relaxed);
+    if (m_Slots->owner != owner)
+    {
+        m_Slots = std::make_shared<Slots>(*m_Slots);
+        m_Slots->owner = owner;
+    }
+
+    return *m_Slots;
+}
+
+template <typename T>
+void AssetStore<T>::Record(const uint32_t index)
+{
+    if (m_Journal.ShouldRecord(index))
+        m_Journal.Record(GetState(index));
+}
+
+template <typename T>
+typename AssetStore<T>::SlotState AssetStore<T>::GetState(const uint32_t index)
+{
+    // Slots past the end are empty
+    if (index >= m_Slots->names.size() || !m_Slots->alive[index])
+        return SlotState(index, false, std::string(), nullptr);
+
+    Assets& assets = GetMutableAssets();
+    assets.owners[index] = NoOwner;
+    return SlotState(index, true, m_Slots->names[index], assets.assets[index]);
+}
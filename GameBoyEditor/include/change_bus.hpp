@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "core.hpp"
+#include "parser.hpp"
+
+enum class ChangeType : uint8_t
+{
+    Graphics,
+    Tilemap,
+    Door,
+    RoomPalette,
+    SpriteData,
+    Animation,
+    CollisionTable
+};
+
+struct ChangeEvent
+{
+    static constexpr uint16_t All = std::numeric_limits<uint16_t>::max();
+
+    ChangeType type;
+    // Handle index for assets, id for doors and rooms
+    uint32_t target;
+    // Inclusive range of tiles for graphics (only x is used), rectangle of cells for tilemaps
+    uint16_t x0 = 0;
+    uint16_t y0 = 0;
+    uint16_t x1 = All;
+    uint16_t y1 = All;
+
+    _NODISCARD static ChangeEvent GraphicsTiles(GraphicsHandle graphics, size_t first = 0, size_t last = All);
+    _NODISCARD static ChangeEvent TilemapRect(TilemapHandle tilemap, size_t x0 = 0, size_t y0 = 0, size_t x1 = All, size_t y1 = All);
+    _NODISCARD static ChangeEvent Door(size_t doorId);
+    _NODISCARD static ChangeEvent RoomPalette(size_t roomId);
+    _NODISCARD static ChangeEvent SpriteData(SpriteDataHandle spriteData);
+    _NODISCARD static ChangeEvent Animation(AnimationHandle animation);
+    _NODISCARD static ChangeEvent CollisionTable(CollisionTableHandle collisionTable);
+};
+
+using ChangeCallback = std::function<void(const ChangeEvent&)>;
+
+// Tells the renderers, caches and other listeners what changed in the project.
+// Events are merged per target and delivered once per frame, the buffers are reused so publishing doesn't allocate
+class ChangeBus
+{
+    STATIC_CLASS(ChangeBus)
+
+public:
+    // A mask of 0 listens to every type
+    static size_t Subscribe(ChangeCallback callback, uint32_t typeMask = 0);
+    static void Unsubscribe(size_t subscription);
+
+    static void Publish(const ChangeEvent& event);
+    // Called by the application at the end of each frame
+    static void Flush();
+
+    // Holds back the events published until the batch ends, merged the same way. Batches can be nested, the events of an inner
+    // batch go to the outer one
+    static void BeginBatch();
+    // Publishes the events of the batch and swaps them into events, the buffer given back is reused by the next batch
+    static void CommitBatch(std::vector<ChangeEvent>& events);
+    // Drops the events of the batch, for edits that were rolled back
+    static void DiscardBatch();
+    _NODISCARD static bool_t IsBatching() { return m_BatchDepth != 0; }
+
+    _NODISCARD static constexpr uint32_t MaskOf(const ChangeType type) { return 1u << static_cast<uint32_t>(type); }
+
+private:
+    struct Subscriber
+    {
+        ChangeCallback callback;
+        uint32_t typeMask;
+    };
+
+    static constexpr size_t InitialCapacity = 64;
+
+    static inline std::vector<Subscriber> m_Subscribers;
+    static inline std::vector<ChangeEvent> m_Pending;
+    static inline std::vector<ChangeEvent> m_Delivering;
+    // Buffers of the batches, kept once a batch ends so nesting the same depth again doesn't allocate
+    static inline std::vector<std::vector<ChangeEvent>> m_Batches;
+    static inline size_t m_BatchDepth = 0;
+
+    static void Merge(std::vector<ChangeEvent>& events, const ChangeEvent& event);
+};
@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "change_bus.hpp"
+#include "core.hpp"
+#include "parser.hpp"
+
+struct CollisionGrid
+{
+    uint8_t width = 0;
+    uint8_t height = 0;
+    // Deduplicated clipdata of the room, may contain values that aren't used anymore after incremental updates
+    std::vector<std::string> values;
+    // Index in values of each tile, row-major
+    std::vector<uint8_t> cells;
+    // Assets the grid was built from, the room may point to others since
+    TilemapHandle tilemap;
+    CollisionTableHandle collisionTable;
+
+    _NODISCARD std::vector<std::string> GetUsedValues() const;
+    _NODISCARD static uint8_t GetBitsPerTile(size_t valueCount);
+    _NODISCARD std::vector<uint8_t> Pack(const std::vector<std::string>& usedValues) const;
+};
+
+class CollisionGridCache
+{
+    STATIC_CLASS(CollisionGridCache)
+
+public:
+    static const CollisionGrid& Get(size_t roomId);
+
+    static void UpdateTile(TilemapHandle tilemap, size_t x, size_t y);
+    static void InvalidateTilemap(TilemapHandle tilemap);
+    static void InvalidateCollisionTable(CollisionTableHandle collisionTable);
+    // Also called when the rooms change, starts listening to the collision table edits the first time
+    static void InvalidateAll();
+
+    static void SetExport(bool_t value);
+    _NODISCARD static bool_t IsExported() { return m_Export; }
+    // Called by the parser when a project already contains collision grids
+    static void MarkExported() { m_Export = true; }
+
+    _NODISCARD static std::string GetSymbolName(size_t roomId);
+
+private:
+    static constexpr size_t NoSubscription = std::numeric_limits<size_t>::max();
+
+    static void OnChange(const ChangeEvent& event);
+    static void IndexRooms();
+    static void Rebuild(size_t roomId);
+    _NODISCARD static CollisionTableHandle GetCollisionTable(const Room& room);
+    _NODISCARD static const std::string& GetClipdata(const CollisionTable& collisionTable, uint8_t tile);
+
+    static inline std::vector<CollisionGrid> m_Grids;
+    static inline std::vector<bool_t> m_Dirty;
+    // Tilemap handle index -> rooms drawn with it
+    static inline std::unordered_map<uint32_t, std::vector<size_t>> m_TilemapRooms;
+
+    static inline size_t m_Subscription = NoSubscription;
+
+    static inline bool_t m_Export = false;
+};
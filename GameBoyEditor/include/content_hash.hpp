@@ -0,0 +1,36 @@
+﻿#pragma once
+
+#include <functional>
+#include <span>
+#include <string>
+
+#include "core.hpp"
+
+// 128-bit hash of some data, used to tell whether two pieces of content are identical without comparing them.
+// Calls can be chained by passing the previous hash as the seed
+struct ContentHash
+{
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    _NODISCARD static ContentHash Of(std::span<const uint8_t> data, ContentHash seed);
+    _NODISCARD static ContentHash Of(const std::string& value, ContentHash seed);
+    _NODISCARD static ContentHash Of(uint64_t value, ContentHash seed);
+
+    _NODISCARD static ContentHash Of(const std::span<const uint8_t> data) { return Of(data, ContentHash()); }
+    _NODISCARD static ContentHash Of(const std::string& value) { return Of(value, ContentHash()); }
+    _NODISCARD static ContentHash Of(const uint64_t value) { return Of(value, ContentHash()); }
+    // Order dependent, Combine(a, b) != Combine(b, a)
+    _NODISCARD static ContentHash Combine(const ContentHash& left, const ContentHash& right);
+
+    _NODISCARD bool_t operator==(const ContentHash& other) const = default;
+
+private:
+    _NODISCARD static uint64_t Mix(uint64_t value);
+};
+
+template <>
+struct std::hash<ContentHash>
+{
+    size_t operator()(const ContentHash& hash) const noexcept { return static_cast<size_t>(hash.low); }
+};
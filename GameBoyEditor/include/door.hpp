@@ -1,5 +1,8 @@
 ﻿#pragma once
 
+#include <limits>
+#include <vector>
+
 #include "core.hpp"
 
 struct Door
@@ -20,3 +23,16 @@ struct Door
             targetDoor == other.targetDoor && exitX == other.exitX && exitY == other.exitY && tileset == other.tileset;
     }
 };
+
+// Keeps referring to the same door when other doors are deleted and renumbered
+struct DoorHandle
+{
+    static constexpr uint32_t InvalidId = std::numeric_limits<uint32_t>::max();
+
+    uint32_t id = InvalidId;
+
+    _NODISCARD bool_t IsNull() const { return id == InvalidId; }
+    _NODISCARD bool_t operator==(const DoorHandle& other) const = default;
+};
+
+using DoorData = std::vector<uint8_t>;
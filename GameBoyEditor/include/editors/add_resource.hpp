@@ -31,7 +31,7 @@ private:
     void CreateRoom() const;
 
     static void RegenerateRoomIncludeFile();
-    static void CreateRoomHeaderFile();
+    static void CreateRoomHeaderFile(const std::string& roomIndex);
 
     static void RegenerateCollisionTableIncludeFile();
 
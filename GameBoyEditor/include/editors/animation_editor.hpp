@@ -2,6 +2,7 @@
 
 #include "animation.hpp"
 #include "color.hpp"
+#include "parser.hpp"
 #include "render_target.hpp"
 #include "ui_window.hpp"
 
@@ -12,22 +13,30 @@ public:
 
     void Update() override;
 
-    void Setup(const std::string& animation, const std::string& graphics);
+    void Setup(AnimationHandle animation, GraphicsHandle graphics);
     
+protected:
+    // Tile remaps of the graphics editor edit the animations too
+    void GetView(std::vector<AssetTag>& view) const override;
+    _NODISCARD size_t GetViewKey() const override { return m_SelectedAnimation.index; }
+
 private:
     void DrawAnimationSelector();
     void DrawGraphicsSelector();
     void DrawPlaybackControls();
     void DrawFrameInfo();
     void DrawPartInfo();
+    // Called after any edit of the selected animation
+    void OnAnimationEdited() const;
 
     void DrawGraphics();
     void DrawOam();
+    void DrawScanlineHeatmap(ImVec2 origin) const;
 
     void UpdatePlayback();
 
-    std::string m_SelectedAnimation = "<None>";
-    std::string m_SelectedGraphics = "<None>";
+    AnimationHandle m_SelectedAnimation;
+    GraphicsHandle m_SelectedGraphics;
 
     uint8_t m_CurrentFrame = 0;
     uint8_t m_SelectedPart = 0;
@@ -40,6 +49,7 @@ private:
     Palette m_ColorPalette = Palette{ Transparent, LightGrey, DarkGrey, Black };
     float_t m_OamPixelSize = 5.f;
     bool_t m_DrawOrigin = true;
+    bool_t m_DrawScanlines = false;
 
     RenderTarget m_GraphicsRenderTarget;
 
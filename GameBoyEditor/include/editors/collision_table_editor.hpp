@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include "color.hpp"
+#include "parser.hpp"
 #include "render_target.hpp"
 #include "ui_window.hpp"
 
@@ -11,16 +12,21 @@ public:
 
     void Update() override;
 
+protected:
+    void GetView(std::vector<AssetTag>& view) const override;
+    _NODISCARD size_t GetViewKey() const override { return m_SelectedCollisionTable.index; }
+
 private:
     void DrawTilesetSelector();
     void DrawCollisionInfo();
     void DrawCollisionTableSelector();
     void DrawTileset();
 
-    static void DrawClipdataSelector(std::string& clipdata);
+    // Returns the clipdata picked by the user, nullptr if it didn't change
+    _NODISCARD static const std::string* DrawClipdataSelector(const std::string& clipdata);
 
-    std::string m_SelectedTileset = "<None>";
-    std::string m_SelectedCollisionTable = "<None>";
+    GraphicsHandle m_SelectedTileset;
+    CollisionTableHandle m_SelectedCollisionTable;
     size_t m_SelectedTile = 0;
 
     RenderTarget m_TilesetRenderTarget;
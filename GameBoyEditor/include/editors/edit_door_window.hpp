@@ -8,10 +8,14 @@ class EditDoorWindow : public UiWindow
 public:
     explicit EditDoorWindow() { name = "Edit door"; }
 
-    void Setup(Door* door);
+    void Setup(DoorHandle door);
 
     void Update() override;
 
+protected:
+    void GetView(std::vector<AssetTag>& view) const override;
+    _NODISCARD size_t GetViewKey() const override { return m_Door.id; }
+
 private:
-    Door* m_Door = nullptr;
+    DoorHandle m_Door;
 };
@@ -9,10 +9,15 @@ class EditSpriteWindow : public UiWindow
 public:
     explicit EditSpriteWindow() { name = "Edit sprite"; }
 
-    void Setup(SpriteData* sprite);
+    void Setup(SpriteDataHandle spriteData, size_t index);
 
     void Update() override;
 
+protected:
+    void GetView(std::vector<AssetTag>& view) const override;
+    _NODISCARD size_t GetViewKey() const override { return m_SpriteData.index; }
+
 private:
-    SpriteData* m_Sprite = nullptr;
+    SpriteDataHandle m_SpriteData;
+    size_t m_Index = 0;
 };
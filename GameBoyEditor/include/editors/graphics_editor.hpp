@@ -12,21 +12,28 @@ public:
 
     void Update() override;
 
+protected:
+    // Selected graphics set
+    void GetView(std::vector<AssetTag>& view) const override;
+    _NODISCARD size_t GetViewKey() const override { return m_SelectedGraphics.index; }
+
 private:
     void DrawGraphicsSelector();
     void DrawPalette();
     void DrawGraphics();
     void DrawCurrentTile();
+    void DrawTileUsages();
 
     void PerformFill(size_t pixelIndex);
 
-    std::string m_SelectedGraphics = "<None>";
+    GraphicsHandle m_SelectedGraphics;
     Palette m_ColorPalette = { White, LightGrey, DarkGrey, Black };
 
     size_t m_SelectedColor = 0;
     size_t m_SelectedTile = 0;
+    uint8_t m_ReplacementTile = 0;
 
-    PlotPixelAction* m_PlotPixelAction = nullptr;
+    ActionHandle<PlotPixelAction> m_PlotPixelAction;
 
     RenderTarget m_GraphicsRenderTarget;
     RenderTarget m_TileRenderTarget;
@@ -0,0 +1,14 @@
+﻿#pragma once
+
+#include "ui_window.hpp"
+
+class OamProfilerWindow : public UiWindow
+{
+public:
+    explicit OamProfilerWindow() { name = "OAM profiler"; hasUndoRedo = false; }
+
+    void Update() override;
+
+private:
+    bool_t m_OnlyOverLimit = false;
+};
@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include <limits>
+
 #include "parser.hpp"
 #include "render_target.hpp"
 #include "ui_window.hpp"
@@ -13,6 +15,11 @@ public:
     void Update() override;
     void OnProjectLoaded() override;
 
+protected:
+    // Tilemap, sprites and palette of the current room
+    void GetView(std::vector<AssetTag>& view) const override;
+    _NODISCARD size_t GetViewKey() const override { return m_RoomId; }
+
 private:
     enum class EditingMode : uint8_t
     {
@@ -41,14 +48,18 @@ private:
     
     void DrawOptions();
     void DrawRoomId();
+    void DrawIncomingDoors() const;
     void DrawEditingMode();
+    void DrawCollisionGrid();
     void DrawResize();
     void DrawTileset();
+    void DrawMetatiles();
     void DrawRoom();
     void UpdateSelection(ImVec2 position, bool_t inBounds, size_t cursorX, size_t cursorY, bool_t onGraphics);
 
     void DrawSprites(ImVec2 position, bool_t inBounds, size_t cursorX, size_t cursorY);
     void DrawDoors(ImVec2 position, bool_t inBounds, size_t cursorX, size_t cursorY);
+    void DrawScanlineHeatmap(ImVec2 position) const;
     void DrawObjectContextMenu(size_t cursorX, size_t cursorY);
 
     void LoadRoom();
@@ -62,15 +73,26 @@ private:
     size_t m_RoomId = 0;
     Selection m_Selection;
 
-    std::string m_SelectedGraphics = "<None>";
+    GraphicsHandle m_SelectedGraphics;
 
     EditingMode m_EditingMode = EditingMode::Tile;
-
-    SpriteData* m_SelectedSprite = nullptr;
-    SpriteData* m_HoveredSprite = nullptr;
-
-    Door* m_SelectedDoor = nullptr;
-    Door* m_HoveredDoor = nullptr;
+    bool_t m_PaintMetatiles = false;
+    size_t m_SelectedMetatile = 0;
+    size_t m_MetatileRows = 0;
+    // Metatiles laid out 8 per row, built again only when the dictionary it was built from changes
+    Metatiles m_MetatileLayoutSource;
+    Tilemap m_MetatileLayout;
+    uint64_t m_MetatileLayoutVersion = 0;
+    bool_t m_DrawScanlines = false;
+
+    static constexpr size_t NoSprite = std::numeric_limits<size_t>::max();
+
+    // Indices in the sprite data of the room
+    size_t m_SelectedSprite = NoSprite;
+    size_t m_HoveredSprite = NoSprite;
+
+    DoorHandle m_SelectedDoor;
+    DoorHandle m_HoveredDoor;
     uint8_t m_SelectedDoorAnchorX = 0;
     uint8_t m_SelectedDoorAnchorY = 0;
 
@@ -78,8 +100,9 @@ private:
     size_t m_BackupCursorX = 0;
     size_t m_BackupCursorY = 0;
 
-    EditTilemapAction* m_EditTilemapAction = nullptr;
+    ActionHandle<EditTilemapAction> m_EditTilemapAction;
 
     RenderTarget m_GraphicsRenderTarget;
     RenderTarget m_TilemapRenderTarget;
+    RenderTarget m_MetatileRenderTarget;
 };
@@ -0,0 +1,17 @@
+﻿#pragma once
+
+#include "ui_window.hpp"
+
+class SpriteVramWindow : public UiWindow
+{
+public:
+    explicit SpriteVramWindow() { name = "Sprite VRAM planner"; hasUndoRedo = false; }
+
+    void Update() override;
+    void OnProjectLoaded() override;
+
+private:
+    void DrawGraphicsSelector();
+    void DrawSpriteAnimations();
+    void DrawRoomUsage();
+};
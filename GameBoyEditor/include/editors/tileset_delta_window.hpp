@@ -0,0 +1,15 @@
+﻿#pragma once
+
+#include "ui_window.hpp"
+
+class TilesetDeltaWindow : public UiWindow
+{
+public:
+    explicit TilesetDeltaWindow() { name = "Tileset delta planner"; hasUndoRedo = false; }
+
+    void Update() override;
+
+private:
+    void DrawDeltas();
+    void DrawOrdering();
+};
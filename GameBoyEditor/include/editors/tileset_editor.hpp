@@ -1,15 +1,19 @@
 ﻿#pragma once
 
 #include "door.hpp"
+#include "parser.hpp"
 #include "ui_window.hpp"
 
 class TilesetEditor : public UiWindow
 {
 public:
-    explicit TilesetEditor() { name = "Tileset editor"; }
+    explicit TilesetEditor() { name = "Tileset editor"; hasUndoRedo = false; }
 
     void Update() override;
 
 private:
-    std::string m_SelectedGraphics = "<None>";
+    // Lists what is drawn with the tileset, since deleting it unsets it from the doors loading it
+    static void DrawUsages(GraphicsHandle tileset);
+
+    GraphicsHandle m_SelectedGraphics;
 };
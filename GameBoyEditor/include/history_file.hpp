@@ -0,0 +1,92 @@
+﻿#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "action.hpp"
+#include "archive.hpp"
+#include "content_hash.hpp"
+#include "core.hpp"
+
+// Stands in the undo history for an action only kept in the history file, it is read back before being done or undone
+class SpilledAction : public Action
+{
+public:
+    explicit SpilledAction(const std::span<const AssetTag> assets, const ActionKind kind, std::pmr::memory_resource* const resource = std::pmr::get_default_resource())
+        : Action(GetActionName(kind), resource), m_Kind(kind)
+    {
+        Touch(assets);
+    }
+
+    void Do() override {}
+    void Undo() override {}
+    _NODISCARD size_t GetMemoryFootprint() const override { return sizeof(*this) + GetAssets().size() * sizeof(AssetTag); }
+
+    _NODISCARD ActionKind GetKind() const override { return m_Kind; }
+
+private:
+    ActionKind m_Kind;
+};
+
+struct HistoryRecord
+{
+    uint64_t offset;
+    ActionKind kind;
+    std::vector<AssetTag> assets;
+};
+
+// Append-only file next to the project holding the actions of the undo history, so that old actions can leave memory and the
+// history survives a restart. Each save appends a checkpoint listing the applied actions and the content hash of the assets they touch
+class HistoryFile
+{
+public:
+    static constexpr uint64_t NoOffset = std::numeric_limits<uint64_t>::max();
+
+    // Returns the actions of the last checkpoint if the assets they touch still have the content they had then,
+    // otherwise the file is started over. The file is rewritten with only these actions so it doesn't grow across sessions
+    std::vector<HistoryRecord> Open(const std::filesystem::path& path);
+    void Close();
+    _NODISCARD bool_t IsOpen() const { return m_File.is_open(); }
+
+    // Returns NoOffset if the action can't be written
+    uint64_t Append(const Action& action);
+    // The actions are the applied ones, oldest first. Nothing is written if one of the assets can't be described
+    void AppendCheckpoint(std::span<const uint64_t> offsets, std::span<const AssetTag> assets);
+    // Fills the data to construct the action from, returns ActionKind::None if the record can't be read
+    ActionKind Read(uint64_t offset, std::vector<uint8_t>& data);
+
+    // False for the assets that don't exist anymore or can't be hashed
+    _NODISCARD static bool_t DescribeAsset(const AssetTag& asset, std::string& name, ContentHash& hash);
+
+private:
+    enum class RecordType : uint8_t
+    {
+        Action,
+        Checkpoint
+    };
+
+    static constexpr uint32_t Magic = 0x48454247; // "GBEH"
+    static constexpr uint32_t Version = 2;
+    static constexpr size_t HeaderSize = 2 * sizeof(uint32_t);
+    static constexpr size_t RecordHeaderSize = sizeof(uint8_t) + sizeof(uint32_t);
+
+    std::fstream m_File;
+    // Where the next record goes, a record cut short by a crash is past it
+    uint64_t m_End = 0;
+    std::vector<uint8_t> m_Buffer;
+
+    void Create(const std::filesystem::path& path);
+    uint64_t AppendRecord(RecordType type, std::span<const uint8_t> data);
+    bool_t ReadRecord(uint64_t offset, RecordType& type, std::vector<uint8_t>& data);
+
+    // Splits an action record between what the queue needs to list it and the data of the action
+    _NODISCARD static bool_t ParseAction(std::span<const uint8_t> record, HistoryRecord& info, std::vector<uint8_t>& data);
+    _NODISCARD static bool_t ResolveAsset(ChangeType type, const std::string& name, AssetTag& asset);
+    template <typename T>
+    _NODISCARD static bool_t DescribeAsset(const AssetStore<T>& store, uint32_t index, std::string& name, ContentHash& hash);
+};
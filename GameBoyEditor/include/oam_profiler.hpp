@@ -0,0 +1,70 @@
+﻿#pragma once
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "animation.hpp"
+#include "change_bus.hpp"
+#include "core.hpp"
+
+struct ScanlineProfile
+{
+    // Scanline of counts[0], relative to the origin of the profiled object
+    int32_t top = 0;
+    // Rooms add up the objects of all their sprites, so a line can go well past what a byte holds
+    std::vector<size_t> counts;
+    size_t objects = 0;
+    // Horizontal extent of the objects in pixels, right is exclusive
+    int32_t left = 0;
+    int32_t right = 0;
+    // Horizontal scroll of the screen the objects were counted on, only used by rooms
+    int32_t scroll = 0;
+
+    _NODISCARD size_t GetPeak() const;
+    _NODISCARD int32_t GetPeakLine() const;
+};
+
+struct OamWorstCase
+{
+    std::string name;
+    size_t peak;
+    int32_t line;
+    size_t objects;
+    // Horizontal scroll of the worst screen for rooms, -1 for animation frames
+    int32_t scroll = -1;
+};
+
+class OamProfiler
+{
+    STATIC_CLASS(OamProfiler)
+
+public:
+    static constexpr size_t MaxObjectsPerLine = 10;
+    static constexpr size_t MaxObjects = 40;
+    static constexpr int32_t ScreenWidth = 160;
+
+    static ScanlineProfile ProfileFrame(const AnimationFrame& frame);
+    static ScanlineProfile ProfileSprite(const std::string& spriteId);
+    // Only the sprites on screen together count against the limits, gives the profile of the worst screen along the room
+    static ScanlineProfile ProfileRoom(size_t roomId);
+
+    // Drops the worst cases of the previous project, called when a project is loaded
+    static void Reset();
+    static void ComputeWorstCases();
+    // Computes the worst cases again if an animation or the sprites of a room changed since the last time
+    static void UpdateWorstCases();
+
+    _NODISCARD static uint32_t GetHeatColor(size_t count);
+
+    static inline std::vector<OamWorstCase> worstCases;
+
+private:
+    static constexpr size_t NoSubscription = std::numeric_limits<size_t>::max();
+
+    static inline size_t m_Subscription = NoSubscription;
+    static inline bool_t m_WorstCasesDirty = true;
+
+    static void Merge(ScanlineProfile& profile, const ScanlineProfile& other, int32_t offsetX, int32_t offsetY, bool_t accumulate);
+    _NODISCARD static bool_t IsWorse(const ScanlineProfile& profile, const ScanlineProfile& other);
+};
@@ -1,35 +1,88 @@
 ﻿#pragma once
 
+#include <array>
+#include <atomic>
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "animation.hpp"
+#include "asset_store.hpp"
+#include "content_hash.hpp"
 #include "core.hpp"
 #include "door.hpp"
 #include "room.hpp"
+#include "state_patch.hpp"
+#include "symbol_registry.hpp"
+#include "tile.hpp"
+#include "tilemap.hpp"
 
-using Tilemap = std::vector<std::vector<uint8_t>>;
-using Graphics = std::vector<uint8_t>;
-using DoorData = std::vector<uint8_t>;
+using Graphics = TileSet;
 using CollisionTable = std::vector<std::string>;
+// Top left, top right, bottom left, bottom right
+using Metatile = std::array<uint8_t, 4>;
+using Metatiles = std::vector<Metatile>;
 
-enum class SymbolType : uint8_t
+using GraphicsHandle = AssetHandle<Graphics>;
+using AnimationHandle = AssetHandle<Animation>;
+using CollisionTableHandle = AssetHandle<CollisionTable>;
+
+// Copy of the project data, cheap to take thanks to the copy-on-write stores and safe to read from any thread
+struct ProjectSnapshot
 {
-    Graphics,
-    Tilemap,
-    SpriteData,
-    DoorData,
-    Animation,
-    RoomData,
-    Doors,
-    Tilesets,
-    CollisionTable,
-    CollisionTableArray
+    AssetStore<Graphics> graphics;
+    AssetStore<Tilemap> tilemaps;
+    AssetStore<std::vector<SpriteData>> sprites;
+    AssetStore<DoorData> roomsDoorData;
+    AssetStore<Animation> animations;
+    AssetStore<CollisionTable> collisionTables;
+    // These are capped at 255 entries, they are simply copied
+    std::vector<GraphicsHandle> tilesets;
+    std::vector<Room> rooms;
+    std::vector<Door> doors;
+    std::vector<CollisionTableHandle> collisionTableArray;
 };
 
-using SymbolInfo = std::pair<SymbolType, std::string>;
+// Parts of the project a transaction copies whole, they are capped at 255 entries. The stores, the symbols and the metatiles are
+// journaled instead, only the parts written to are kept
+struct ProjectState
+{
+    std::vector<GraphicsHandle> tilesets;
+    std::vector<Room> rooms;
+    std::vector<Door> doors;
+    std::vector<CollisionTableHandle> collisionTableArray;
+    std::vector<uint32_t> doorHandleIds;
+    std::vector<uint32_t> doorIds;
+    std::vector<std::vector<uint8_t>> doorTargeters;
+};
+
+// Parts of the project that differ between two states, with their values in one of them. Applying it leaves the rest of the project
+// as it is, so edits made since to other assets are kept
+struct ProjectPatch
+{
+    std::vector<AssetStore<Graphics>::SlotState> graphics;
+    std::vector<AssetStore<Tilemap>::SlotState> tilemaps;
+    std::vector<AssetStore<std::vector<SpriteData>>::SlotState> sprites;
+    std::vector<AssetStore<DoorData>::SlotState> roomsDoorData;
+    std::vector<AssetStore<Animation>::SlotState> animations;
+    std::vector<AssetStore<CollisionTable>::SlotState> collisionTables;
+    VectorPatch<GraphicsHandle> tilesets;
+    VectorPatch<Room> rooms;
+    VectorPatch<Door> doors;
+    VectorPatch<CollisionTableHandle> collisionTableArray;
+    std::vector<SymbolRegistry::SymbolState> symbols;
+    MapPatch<std::string, Metatiles> metatiles;
+    MapPatch<std::string, std::string> metatileTilemaps;
+    VectorPatch<uint32_t> doorHandleIds;
+    VectorPatch<uint32_t> doorIds;
+    VectorPatch<std::vector<uint8_t>> doorTargeters;
+
+    _NODISCARD bool_t IsEmpty() const;
+    // Counts the assets in full, the patch may be the last owner of the ones that were replaced or removed
+    _NODISCARD size_t GetMemoryFootprint() const;
+};
 
 class Parser
 {
@@ -40,28 +93,93 @@ public:
     static bool_t Save();
 
     static void RegisterSymbol(const std::string& file, const std::string& symbolName, SymbolType type);
-    _NODISCARD static size_t GetDoorId(const Door& door);
-    static void DeleteDoor(const Door& door);
+    static DoorHandle AddDoor(const Door& door);
+    static void DeleteDoor(DoorHandle handle);
+    static void SetDoorTarget(DoorHandle handle, uint8_t targetDoor);
+    _NODISCARD static DoorHandle GetDoorHandle(size_t doorId);
+    // Returns doors.size() if the door was deleted
+    _NODISCARD static size_t GetDoorId(DoorHandle handle);
+    _NODISCARD static Door* GetDoor(DoorHandle handle);
+    _NODISCARD static const std::vector<uint8_t>& GetDoorsTargeting(size_t doorId);
+    static void AddTileset(GraphicsHandle graphics);
     static void DeleteTileset(size_t index);
-
-    static inline std::unordered_map<std::string, Graphics> graphics;
-    static inline std::unordered_map<std::string, Tilemap> tilemaps;
-    static inline std::vector<std::string> tilesets;
+    _NODISCARD static bool_t IsTileset(GraphicsHandle graphics);
+    // Returns tilesets.size() if the graphics aren't a tileset
+    _NODISCARD static size_t GetTilesetIndex(GraphicsHandle graphics);
+    static bool_t BuildMetatiles(const std::string& tilemap, const std::string& graphics);
+    _NODISCARD static std::string GetSymbolFile(const std::string& symbolName);
+
+    _NODISCARD static bool_t HasUnsavedChanges() { return m_UnsavedChanges; }
+    static void MarkUnsaved() { m_UnsavedChanges = true; }
+
+    // Snapshots the project and makes it the one returned by GetSnapshot, called by the application once per frame between two edits.
+    // Kept as is if nothing changed since the last one
+    static void PublishSnapshot();
+    // Latest published snapshot, for save, export or validation work done off the UI thread
+    _NODISCARD static std::shared_ptr<const ProjectSnapshot> GetSnapshot();
+
+    // Starts journaling what is written to the project, for a transaction. Captures nest like the transactions, so the cost of one
+    // only depends on what it writes to
+    _NODISCARD static ProjectState BeginCapture();
+    // Hands what the innermost capture recorded to the enclosing one
+    static void MergeCapture();
+    // Ends the outermost capture, with the patches turning what was written to back to how it was and forth to how it is
+    static void EndCapture(const ProjectState& before, ProjectPatch& undo, ProjectPatch& redo);
+    // Ends the innermost capture and puts back what was written to since it began
+    static void RollbackCapture(const ProjectState& before);
+    // Publishes an event for each asset it puts back, the caches are rebuilt afterward
+    static void ApplyPatch(const ProjectPatch& patch);
+
+    static constexpr size_t MaxMetatiles = 255;
+
+    static inline AssetStore<Graphics> graphics;
+    static inline AssetStore<Tilemap> tilemaps;
+    static inline std::vector<GraphicsHandle> tilesets;
     static inline std::vector<Room> rooms;
     static inline std::vector<Door> doors;
-    static inline std::unordered_map<std::string, std::vector<SpriteData>> sprites;
-    static inline std::unordered_map<std::string, DoorData> roomsDoorData;
-    static inline std::unordered_map<std::string, Animation> animations;
-    static inline std::unordered_map<std::string, CollisionTable> collisionTables;
-    static inline std::vector<std::string> collisionTableArray;
+    static inline AssetStore<std::vector<SpriteData>> sprites;
+    static inline AssetStore<DoorData> roomsDoorData;
+    static inline AssetStore<Animation> animations;
+    static inline AssetStore<CollisionTable> collisionTables;
+    static inline std::vector<CollisionTableHandle> collisionTableArray;
+    // Metatiles of each tileset, and the tilemaps saved as metatiles with the tileset they use
+    static inline std::unordered_map<std::string, Metatiles> metatiles;
+    static inline std::unordered_map<std::string, std::string> metatileTilemaps;
 
-    static inline std::unordered_map<std::string, std::vector<SymbolInfo>> fileAssociations;
-    static inline std::vector<std::string> existingSymbols;
+    static inline SymbolRegistry symbols;
 
     static inline std::vector<std::string> spriteIds;
     static inline std::vector<std::string> clipdataNames;
 
+    // Problems found while loading or saving the project, shown to the user until dismissed
+    static inline std::vector<std::string> warnings;
+
 private:
+    struct PendingMetatileTilemap
+    {
+        std::string name;
+        int32_t width;
+        int32_t height;
+        int32_t tileset;
+        std::vector<uint8_t> data;
+    };
+
+    static inline std::vector<PendingMetatileTilemap> m_PendingMetatileTilemaps;
+
+    static inline std::atomic<std::shared_ptr<const ProjectSnapshot>> m_Snapshot;
+
+    static inline MapJournal<std::string, Metatiles> m_MetatilesJournal;
+    static inline MapJournal<std::string, std::string> m_MetatileTilemapsJournal;
+
+    static inline bool_t m_UnsavedChanges = false;
+    // Hash of the symbols of each file when it was last loaded or written, unchanged files are skipped when saving
+    static inline std::unordered_map<std::string, ContentHash> m_SavedFileHashes;
+
+    // Door id -> handle id, handle id -> door id, and door id -> ids of the doors leading to it
+    static inline std::vector<uint32_t> m_DoorHandleIds;
+    static inline std::vector<uint32_t> m_DoorIds;
+    static inline std::vector<std::vector<uint8_t>> m_DoorTargeters;
+
     static bool_t ParseFileContents(const std::filesystem::path& filePath);
 
     static bool_t ParseGraphicsArray(std::ifstream& file, const std::filesystem::path& filePath, std::string& line);
@@ -73,6 +191,22 @@ private:
     static bool_t ParseTilesets(std::ifstream& file, const std::filesystem::path& filePath, std::string& line);
     static bool_t ParseCollisionTable(std::ifstream& file, const std::filesystem::path& filePath, std::string& line);
     static bool_t ParseCollisionTableArray(std::ifstream& file, const std::filesystem::path& filePath, std::string& line);
+    static bool_t ParseMetatiles(std::ifstream& file, const std::filesystem::path& filePath, std::string& line);
+    static bool_t ParseCollisionGrid(std::ifstream& file, const std::filesystem::path& filePath, std::string& line);
+
+    static void BuildDoorIndex();
+    _NODISCARD static DoorData& GetOwnerDoorData(const Door& door);
+
+    _NODISCARD static ProjectState CaptureState();
+    // Publishes the events of the assets a patch put back and rebuilds the caches
+    static void OnPatchApplied(const ProjectPatch& patch);
+
+    // Fails if a tilemap can't be expanded, loading it anyway would lose its tiles on the next save
+    static bool_t ExpandMetatileTilemaps();
+    static void SyncMetatiles();
+    _NODISCARD static Metatile GetMetatile(const Tilemap& tilemap, size_t x, size_t y);
+    // Empty if the graphics have no metatiles, doesn't add an entry for them unlike metatiles[graphicsName]
+    _NODISCARD static const Metatiles& FindMetatiles(const std::string& graphicsName);
 
     static void ParseEnums();
 
@@ -82,6 +216,9 @@ private:
     static std::fstream RemoveExistingSymbol(std::fstream& file, const std::filesystem::path& fileName, const SymbolInfo& symbol);
     static void RemoveDuplicateIncludes(std::fstream& file, const std::filesystem::path& fileName);
 
+    _NODISCARD static ContentHash HashFile(const std::vector<SymbolInfo>& fileSymbols);
+    _NODISCARD static ContentHash HashSymbol(const SymbolInfo& symbol);
+
     static void SaveGraphics(std::fstream& file, const std::string& symbolName);
     static void SaveTilemap(std::fstream& file, const std::string& symbolName);
     static void SaveSpriteData(std::fstream& file, const std::string& symbolName);
@@ -92,6 +229,8 @@ private:
     static void SaveTilesets(std::fstream& file, const std::string& symbolName);
     static void SaveCollisionTable(std::fstream& file, const std::string& symbolName);
     static void SaveCollisionTableArray(std::fstream& file, const std::string& symbolName);
+    static void SaveMetatiles(std::fstream& file, const std::string& symbolName);
+    static void SaveCollisionGrid(std::fstream& file, const std::string& symbolName);
 
     static std::string ToHex(size_t value);
 };
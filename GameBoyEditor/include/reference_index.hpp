@@ -0,0 +1,102 @@
+﻿#pragma once
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+#include "core.hpp"
+#include "parser.hpp"
+
+struct OamReference
+{
+    AnimationHandle animation;
+    uint16_t frame;
+    uint8_t entry;
+
+    _NODISCARD bool_t operator==(const OamReference& other) const = default;
+};
+
+struct GraphicsUsages
+{
+    // Indices in Parser::tilesets
+    std::vector<size_t> tilesets;
+    std::vector<TilemapHandle> tilemaps;
+    std::vector<AnimationHandle> animations;
+
+    _NODISCARD bool_t IsEmpty() const { return tilesets.empty() && tilemaps.empty() && animations.empty(); }
+};
+
+// Reverse lookups over the parser data, kept up to date by the editors and actions as they edit it
+class ReferenceIndex
+{
+    STATIC_CLASS(ReferenceIndex)
+
+public:
+    static void Rebuild();
+
+    static void UpdateTile(TilemapHandle tilemap, size_t x, size_t y);
+    // Indexes the whole tilemap again, needed after a resize
+    static void InvalidateTilemap(TilemapHandle tilemap);
+    static void SetTilemapGraphics(TilemapHandle tilemap, GraphicsHandle graphics, bool_t guessed = false);
+    _NODISCARD static GraphicsHandle GetTilemapGraphics(TilemapHandle tilemap);
+    // The graphics were guessed from the tilesets loaded by the doors leading to the room, and not confirmed by painting it since
+    _NODISCARD static bool_t IsTilemapGraphicsGuessed(TilemapHandle tilemap);
+
+    static void UpdateAnimation(AnimationHandle animation);
+    static void SetAnimationGraphics(AnimationHandle animation, GraphicsHandle graphics);
+    // Falls back to the graphics set of the sprite VRAM planner
+    _NODISCARD static GraphicsHandle GetAnimationGraphics(AnimationHandle animation);
+
+    static void AddRoom(size_t roomId);
+
+    // Row-major index of every cell of the tilemap using the tile
+    _NODISCARD static const std::vector<uint32_t>& GetTileCells(TilemapHandle tilemap, uint8_t tile);
+    _NODISCARD static std::vector<TilemapHandle> GetTilemapsUsingTile(GraphicsHandle graphics, uint8_t tile);
+    _NODISCARD static std::vector<OamReference> GetOamUsingTile(GraphicsHandle graphics, uint8_t tile);
+    _NODISCARD static GraphicsUsages GetGraphicsUsages(GraphicsHandle graphics);
+    _NODISCARD static const std::vector<uint8_t>& GetRoomsUsingCollisionTable(size_t collisionTable);
+    _NODISCARD static std::vector<uint8_t> GetDoorsTargetingRoom(size_t roomId);
+
+private:
+    struct TilemapUsage
+    {
+        TilemapHandle tilemap;
+        GraphicsHandle graphics;
+        bool_t graphicsGuessed = false;
+        // Copy of the indexed tiles, to know which list a cell leaves when it changes
+        std::vector<uint8_t> tiles;
+        // Position of each cell in the list of its tile
+        std::vector<uint32_t> slots;
+        std::array<std::vector<uint32_t>, 256> cells;
+    };
+
+    struct AnimationUsage
+    {
+        AnimationHandle animation;
+        // Graphics set the animation was last edited with
+        GraphicsHandle graphics;
+        // Tiles the animation is indexed under
+        std::vector<uint8_t> tiles;
+    };
+
+    _NODISCARD static TilemapUsage& GetUsage(TilemapHandle tilemap);
+    static void IndexTilemap(TilemapUsage& usage);
+    static void RemoveCell(TilemapUsage& usage, uint32_t cell);
+    static void AddCell(TilemapUsage& usage, uint32_t cell, uint8_t tile);
+
+    static void LinkGraphics(TilemapHandle tilemap, GraphicsHandle graphics);
+    static void UnlinkGraphics(TilemapHandle tilemap, GraphicsHandle graphics);
+
+    // By tilemap handle index
+    static inline std::vector<TilemapUsage> m_Tilemaps;
+    // Graphics handle index -> tilemaps drawn with it
+    static inline std::unordered_map<uint32_t, std::vector<TilemapHandle>> m_GraphicsTilemaps;
+
+    // Tile index -> sprite parts using it, whatever their graphics set
+    static inline std::array<std::vector<OamReference>, 256> m_OamReferences;
+    // By animation handle index
+    static inline std::unordered_map<uint32_t, AnimationUsage> m_Animations;
+
+    // Collision table index -> rooms using it
+    static inline std::vector<std::vector<uint8_t>> m_CollisionTableRooms;
+};
@@ -2,6 +2,7 @@
 
 #include <cmath>
 
+#include "content_hash.hpp"
 #include "core.hpp"
 #include "texture.hpp"
 #include "imgui/imgui.h"
@@ -14,12 +15,21 @@ public:
     void SetSize(int32_t width, int32_t height);
     void Bind() const;
     void Unbind() const;
+    // Remembers the inputs of the next pass, returns false if the target already holds their render so the pass can be skipped.
+    // The inputs are forgotten when the target is resized
+    _NODISCARD bool_t UpdateInputs(const ContentHash& inputs) const;
     void Render() const;
     void Draw() const;
 
     _NODISCARD const Texture& GetTexture() const;
     _NODISCARD ImVec2 GetSize() const;
 
+    // Moves the pass counters of the frame to the ones given by the getters
+    static void EndFrame();
+    // Over every render target during the last frame
+    _NODISCARD static size_t GetPassesExecuted() { return m_LastPassesExecuted; }
+    _NODISCARD static size_t GetPassesSkipped() { return m_LastPassesSkipped; }
+
     float_t scale = 1.f;
 
 private:
@@ -33,4 +43,12 @@ private:
 
     int32_t m_Width = 0;
     int32_t m_Height = 0;
+
+    mutable ContentHash m_Inputs;
+    mutable bool_t m_HasInputs = false;
+
+    static inline size_t m_PassesExecuted = 0;
+    static inline size_t m_PassesSkipped = 0;
+    static inline size_t m_LastPassesExecuted = 0;
+    static inline size_t m_LastPassesSkipped = 0;
 };
@@ -0,0 +1,19 @@
+﻿#pragma once
+
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "core.hpp"
+
+// Run-length encoding as (count, value) byte pairs, like the tilemaps of the game
+class Rle
+{
+    STATIC_CLASS(Rle)
+
+public:
+    // Appends the encoded values to output
+    static void Encode(std::span<const uint8_t> values, std::pmr::vector<uint8_t>& output);
+    // Fills values entirely, returns the number of bytes read from input
+    static size_t Decode(std::span<const uint8_t> input, std::span<uint8_t> values);
+};
@@ -1,17 +1,12 @@
 ﻿#pragma once
 
 #include <string>
+#include <vector>
 
+#include "asset_store.hpp"
 #include "color.hpp"
-
-struct Room
-{
-    std::string tilemap;
-    Palette colorPalette;
-    std::string spriteData;
-    std::string doorData;
-    uint8_t collisionTable;
-};
+#include "door.hpp"
+#include "tilemap.hpp"
 
 struct SpriteData
 {
@@ -25,3 +20,18 @@ struct SpriteData
 
     _NODISCARD bool_t operator==(const SpriteData& other) const { return x == other.x && y == other.y && part == other.part && id == other.id; }
 };
+
+using TilemapHandle = AssetHandle<Tilemap>;
+using SpriteDataHandle = AssetHandle<std::vector<SpriteData>>;
+using DoorDataHandle = AssetHandle<DoorData>;
+
+struct Room
+{
+    TilemapHandle tilemap;
+    Palette colorPalette;
+    SpriteDataHandle spriteData;
+    DoorDataHandle doorData;
+    uint8_t collisionTable;
+
+    _NODISCARD bool_t operator==(const Room& other) const = default;
+};
@@ -0,0 +1,33 @@
+﻿#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core.hpp"
+#include "parser.hpp"
+
+class SpriteVramPlanner
+{
+    STATIC_CLASS(SpriteVramPlanner)
+
+public:
+    static void GuessSpriteAnimations();
+    static void Compute();
+    static void Export();
+
+    // Animations that can be played by each sprite type
+    static inline std::unordered_map<std::string, std::vector<AnimationHandle>> spriteAnimations;
+    // Graphics set every animation takes its tiles from
+    static inline GraphicsHandle graphics;
+
+    // VRAM slot of each tile of the graphics set, 0xFF if the tile is never used
+    static inline std::vector<uint8_t> tileSlots;
+    // For each room, the tile of the graphics set to load in each VRAM slot, 0xFF for unused slots
+    static inline std::vector<std::vector<uint8_t>> roomTiles;
+
+    static inline bool_t exportOnSave = false;
+
+private:
+    static std::vector<uint8_t> ComputeCanonicalTiles();
+};
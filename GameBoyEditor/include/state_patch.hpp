@@ -0,0 +1,236 @@
+﻿#pragma once
+
+#include <iterator>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "core.hpp"
+
+// Entries of a vector that differ between two versions of it, with their values in one of them.
+// Applying it only writes these entries, the others keep any edit made since
+template <typename T>
+struct VectorPatch
+{
+    size_t size = 0;
+    bool_t resized = false;
+    std::vector<std::pair<size_t, T>> entries;
+
+    // Turns current back into target
+    _NODISCARD static VectorPatch Diff(const std::vector<T>& target, const std::vector<T>& current);
+    void Apply(std::vector<T>& values) const;
+
+    _NODISCARD bool_t IsEmpty() const { return !resized && entries.empty(); }
+};
+
+// Keys of a map that differ between two versions of it, with their values in one of them, or nothing if the key is absent from it
+template <typename K, typename V>
+struct MapPatch
+{
+    using Entry = std::pair<K, std::optional<V>>;
+
+    std::vector<Entry> entries;
+
+    // Turns current back into target
+    _NODISCARD static MapPatch Diff(const std::unordered_map<K, V>& target, const std::unordered_map<K, V>& current);
+    void Apply(std::unordered_map<K, V>& values) const;
+
+    _NODISCARD bool_t IsEmpty() const { return entries.empty(); }
+};
+
+// Entries of a container as they were before being first written to, recorded while a transaction is open so that it only keeps
+// and compares what it wrote to. Levels nest like the transactions, each one records the entries it is the first to write to
+template <typename State, auto Key>
+class StateJournal
+{
+public:
+    void Open() { m_Levels.push_back(m_States.size()); }
+
+    // False if no level is open or the innermost one already has the entry
+    template <typename K>
+    _NODISCARD bool_t ShouldRecord(const K& key) const { return !m_Levels.empty() && !Contains(m_Levels.back(), m_States.size(), key); }
+    void Record(State state) { m_States.push_back(std::move(state)); }
+
+    // Hands the entries of the innermost level to the enclosing one, which keeps its older state of the ones it also has
+    void Merge();
+    // Ends the innermost level and returns its entries
+    _NODISCARD std::vector<State> Close();
+
+private:
+    std::vector<State> m_States;
+    // Index of the first entry of each level
+    std::vector<size_t> m_Levels;
+
+    template <typename K>
+    _NODISCARD bool_t Contains(size_t first, size_t last, const K& key) const;
+};
+
+// Keys of a map written to during a transaction, as MapPatch entries
+template <typename K, typename V>
+class MapJournal
+{
+public:
+    using Entry = typename MapPatch<K, V>::Entry;
+
+    void Open() { m_Journal.Open(); }
+    void Merge() { m_Journal.Merge(); }
+    // Called before the key is written to or erased
+    void Record(const std::unordered_map<K, V>& values, const K& key);
+    // Ends the outermost level, giving the keys that changed as they were before and as they are now
+    void Close(const std::unordered_map<K, V>& values, MapPatch<K, V>& before, MapPatch<K, V>& after);
+    // Ends the innermost level and puts its keys back, returns them
+    MapPatch<K, V> Rollback(std::unordered_map<K, V>& values);
+
+private:
+    StateJournal<Entry, &Entry::first> m_Journal;
+
+    _NODISCARD static Entry GetEntry(const std::unordered_map<K, V>& values, const K& key);
+};
+
+template <typename T>
+VectorPatch<T> VectorPatch<T>::Diff(const std::vector<T>& target, const std::vector<T>& current)
+{
+    VectorPatch patch;
+    patch.size = target.size();
+    patch.resized = target.size() != current.size();
+
+    for (size_t i = 0; i < target.size(); i++)
+    {
+        if (i >= current.size() || target[i] != current[i])
+            patch.entries.emplace_back(i, target[i]);
+    }
+
+    return patch;
+}
+
+template <typename T>
+void VectorPatch<T>::Apply(std::vector<T>& values) const
+{
+    if (resized)
+        values.resize(size);
+
+    for (const std::pair<size_t, T>& entry : entries)
+    {
+        if (entry.first < values.size())
+            values[entry.first] = entry.second;
+    }
+}
+
+template <typename K, typename V>
+MapPatch<K, V> MapPatch<K, V>::Diff(const std::unordered_map<K, V>& target, const std::unordered_map<K, V>& current)
+{
+    MapPatch patch;
+
+    for (const std::pair<const K, V>& entry : target)
+    {
+        const typename std::unordered_map<K, V>::const_iterator it = current.find(entry.first);
+        if (it == current.end() || it->second != entry.second)
+            patch.entries.emplace_back(entry.first, entry.second);
+    }
+
+    for (const std::pair<const K, V>& entry : current)
+    {
+        if (!target.contains(entry.first))
+            patch.entries.emplace_back(entry.first, std::nullopt);
+    }
+
+    return patch;
+}
+
+template <typename K, typename V>
+void MapPatch<K, V>::Apply(std::unordered_map<K, V>& values) const
+{
+    for (const std::pair<K, std::optional<V>>& entry : entries)
+    {
+        if (entry.second)
+            values[entry.first] = *entry.second;
+        else
+            values.erase(entry.first);
+    }
+}
+
+template <typename State, auto Key>
+void StateJournal<State, Key>::Merge()
+{
+    const size_t first = m_Levels.back();
+    m_Levels.pop_back();
+
+    size_t kept = first;
+    for (size_t i = first; i < m_States.size(); i++)
+    {
+        // The enclosing level recorded these before the inner one began
+        if (m_Levels.empty() || Contains(m_Levels.back(), first, m_States[i].*Key))
+            continue;
+
+        if (kept != i)
+            m_States[kept] = std::move(m_States[i]);
+        kept++;
+    }
+
+    m_States.erase(m_States.begin() + kept, m_States.end());
+}
+
+template <typename State, auto Key>
+std::vector<State> StateJournal<State, Key>::Close()
+{
+    const size_t first = m_Levels.back();
+    m_Levels.pop_back();
+
+    std::vector<State> states(std::make_move_iterator(m_States.begin() + first), std::make_move_iterator(m_States.end()));
+    m_States.erase(m_States.begin() + first, m_States.end());
+    return states;
+}
+
+template <typename State, auto Key>
+template <typename K>
+bool_t StateJournal<State, Key>::Contains(const size_t first, const size_t last, const K& key) const
+{
+    // Transactions write to a handful of entries, a linear search beats hashing them
+    for (size_t i = first; i < last; i++)
+    {
+        if (m_States[i].*Key == key)
+            return true;
+    }
+
+    return false;
+}
+
+template <typename K, typename V>
+void MapJournal<K, V>::Record(const std::unordered_map<K, V>& values, const K& key)
+{
+    if (m_Journal.ShouldRecord(key))
+        m_Journal.Record(GetEntry(values, key));
+}
+
+template <typename K, typename V>
+void MapJournal<K, V>::Close(const std::unordered_map<K, V>& values, MapPatch<K, V>& before, MapPatch<K, V>& after)
+{
+    for (Entry& entry : m_Journal.Close())
+    {
+        Entry current = GetEntry(values, entry.first);
+        if (current.second == entry.second)
+            continue;
+
+        before.entries.push_back(std::move(entry));
+        after.entries.push_back(std::move(current));
+    }
+}
+
+template <typename K, typename V>
+MapPatch<K, V> MapJournal<K, V>::Rollback(std::unordered_map<K, V>& values)
+{
+    MapPatch<K, V> patch { m_Journal.Close() };
+    patch.Apply(values);
+    return patch;
+}
+
+template <typename K, typename V>
+typename MapJournal<K, V>::Entry MapJournal<K, V>::GetEntry(const std::unordered_map<K, V>& values, const K& key)
+{
+    const typename std::unordered_map<K, V>::const_iterator it = values.find(key);
+    if (it == values.end())
+        return Entry(key, std::nullopt);
+
+    return Entry(key, it->second);
+}
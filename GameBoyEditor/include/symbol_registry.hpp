@@ -0,0 +1,86 @@
+﻿#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "core.hpp"
+#include "state_patch.hpp"
+
+enum class SymbolType : uint8_t
+{
+    Graphics,
+    Tilemap,
+    SpriteData,
+    DoorData,
+    Animation,
+    RoomData,
+    Doors,
+    Tilesets,
+    CollisionTable,
+    CollisionTableArray,
+    Metatiles,
+    CollisionGrid
+};
+
+constexpr size_t SymbolTypeCount = static_cast<size_t>(SymbolType::CollisionGrid) + 1;
+
+using SymbolInfo = std::pair<SymbolType, std::string>;
+
+// Every symbol of the project, with the file it is saved in
+class SymbolRegistry
+{
+public:
+    // A symbol as it is in a registry, the file is empty if the registry doesn't have it
+    struct SymbolState
+    {
+        std::string name;
+        std::string file;
+        SymbolType type;
+    };
+
+    // Returns false if a symbol with this name already exists
+    bool_t Add(const std::string& file, const std::string& symbolName, SymbolType type);
+    bool_t Remove(const std::string& symbolName);
+    void Clear();
+
+    _NODISCARD bool_t Contains(const std::string& symbolName) const;
+    // Returns an empty string if the symbol doesn't exist
+    _NODISCARD const std::string& GetFile(const std::string& symbolName) const;
+    // Sorted by name
+    _NODISCARD const std::vector<std::string>& GetSymbols(SymbolType type) const;
+    // File -> symbols saved in it, in the order they were added
+    _NODISCARD const std::unordered_map<std::string, std::vector<SymbolInfo>>& GetFiles() const;
+    _NODISCARD size_t GetSize() const;
+
+    // Adds or removes the symbols to match the given states
+    void Restore(const std::vector<SymbolState>& symbols);
+
+    // Same as the journal of an AssetStore, for the symbols added or removed during a transaction
+    void OpenJournal() { m_Journal.Open(); }
+    void MergeJournal() { m_Journal.Merge(); }
+    void CloseJournal(std::vector<SymbolState>& before, std::vector<SymbolState>& after);
+    std::vector<SymbolState> RollbackJournal();
+
+private:
+    struct Entry
+    {
+        std::string file;
+        SymbolType type;
+    };
+
+    std::unordered_map<std::string, Entry> m_Symbols;
+    std::unordered_map<std::string, std::vector<SymbolInfo>> m_Files;
+    std::array<std::vector<std::string>, SymbolTypeCount> m_SortedSymbols;
+
+    StateJournal<SymbolState, &SymbolState::name> m_Journal;
+
+    // Called before the symbol is added or removed
+    void Record(const std::string& symbolName, SymbolType type);
+    _NODISCARD SymbolState GetState(const std::string& symbolName, SymbolType type) const;
+    bool_t AddSymbol(const std::string& file, const std::string& symbolName, SymbolType type);
+    bool_t RemoveSymbol(const std::string& symbolName);
+    void Put(const std::vector<SymbolState>& symbols);
+};
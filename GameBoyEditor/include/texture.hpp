@@ -7,6 +7,9 @@ class Texture
 public:
     void Create();
     void SetData(int32_t internalFormat, int32_t inputFormat, int32_t width, int32_t height, const void* data) const;
+    // Updates a part of the texture without reallocating it, data is an offset in the bound pixel unpack buffer if there is one
+    void SetSubData(int32_t inputFormat, int32_t x, int32_t y, int32_t width, int32_t height, const void* data) const;
+    void Destroy();
 
     void Bind() const;
     void Unbind() const;
@@ -0,0 +1,91 @@
+﻿#pragma once
+
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "change_bus.hpp"
+#include "core.hpp"
+#include "parser.hpp"
+#include "texture.hpp"
+
+// Texture of each graphics set and tilemap, kept between frames and only uploaded again where the ChangeBus says they changed.
+// Edits show up on the frame after they are made, once the bus has been flushed.
+// The textures that weren't drawn for the longest time are deleted at the end of the frame when the cache goes over its memory budget
+class TextureCache
+{
+    STATIC_CLASS(TextureCache)
+
+public:
+    static constexpr size_t DefaultMemoryBudget = 16ull * 1024 * 1024;
+
+    // Needs the OpenGL context
+    static void Init();
+    // Deletes every texture, called when a project is loaded since the handles start over
+    static void Clear();
+
+    // One RG texel per tile row, the texture is as wide as the graphics are long in bytes like the shaders expect
+    _NODISCARD static const Texture& Get(GraphicsHandle graphics);
+    // One R texel per cell, row after row
+    _NODISCARD static const Texture& Get(TilemapHandle tilemap);
+
+    // Changes each time the texture is uploaded to, 0 if it isn't in the cache. Unique across every texture, even after a Clear
+    _NODISCARD static uint64_t GetVersion(GraphicsHandle graphics);
+    _NODISCARD static uint64_t GetVersion(TilemapHandle tilemap);
+
+    // The textures drawn during the frame are always kept, even if they don't fit in the budget on their own
+    static void SetMemoryBudget(size_t bytes);
+    _NODISCARD static size_t GetMemoryBudget() { return m_MemoryBudget; }
+    _NODISCARD static size_t GetMemoryUsage() { return m_MemoryUsage; }
+
+    // Called by the application at the end of each frame, a texture given by Get stays valid until then
+    static void EndFrame();
+
+private:
+    struct Entry
+    {
+        Texture texture;
+        bool_t allocated = false;
+        uint32_t generation = 0;
+        int32_t width = 0;
+        size_t bytes = 0;
+        // Texels in a row of the asset: 8 for a tile, the width for a tilemap
+        size_t rowLength = 0;
+        // Inclusive range of texels to upload
+        size_t firstDirty = NotDirty;
+        size_t lastDirty = 0;
+        // Frame the texture was last given in
+        uint64_t lastUse = 0;
+        uint64_t version = 0;
+    };
+
+    static constexpr size_t NotDirty = std::numeric_limits<size_t>::max();
+    // Uploads at least this large go through the pixel buffer, so the copy to the GPU doesn't stall the draw calls
+    static constexpr size_t PixelBufferThreshold = 4096;
+
+    // By handle index
+    static inline std::vector<Entry> m_Graphics;
+    static inline std::vector<Entry> m_Tilemaps;
+
+    // Given for the assets that don't exist, its single texel is never read since the size given to the shaders is 0
+    static inline Texture m_Empty;
+    static inline uint32_t m_PixelBuffer = 0;
+    static inline uint64_t m_Frame = 0;
+    static inline uint64_t m_VersionCounter = 0;
+
+    static inline size_t m_MemoryBudget = DefaultMemoryBudget;
+    static inline size_t m_MemoryUsage = 0;
+
+    _NODISCARD static uint64_t GetVersion(const std::vector<Entry>& entries, uint32_t index);
+
+    static void OnChange(const ChangeEvent& event);
+    static void MarkDirty(std::vector<Entry>& entries, uint32_t index, size_t firstRow, size_t firstColumn, size_t lastRow, size_t lastColumn);
+
+    // Reallocates the texture if its size changed, otherwise only uploads the dirty texels
+    static const Texture& Update(std::vector<Entry>& entries, uint32_t index, uint32_t generation, int32_t width, size_t rowLength,
+        int32_t internalFormat, int32_t format, size_t texelSize, std::span<const uint8_t> data);
+    static void Upload(const Texture& texture, int32_t format, size_t texelSize, size_t firstTexel, std::span<const uint8_t> data);
+
+    static void Release(Entry& entry);
+    static void Evict();
+};
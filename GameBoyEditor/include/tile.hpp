@@ -0,0 +1,39 @@
+﻿#pragma once
+
+#include <array>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "color.hpp"
+#include "core.hpp"
+
+// 8x8 tile in the Game Boy format, each row is stored as 2 bit planes holding the low and high bits of the colors,
+// the leftmost pixel being the highest bit
+struct alignas(16) Tile
+{
+    std::array<uint8_t, 16> data {};
+
+    _NODISCARD uint8_t& GetPlane(const size_t row, const size_t plane) { return data[row * 2 + plane]; }
+    _NODISCARD uint8_t GetPlane(const size_t row, const size_t plane) const { return data[row * 2 + plane]; }
+
+    _NODISCARD Color GetPixel(size_t x, size_t y) const;
+    void SetPixel(size_t x, size_t y, Color color);
+
+    _NODISCARD Tile FlipX() const;
+    _NODISCARD Tile FlipY() const;
+
+    _NODISCARD size_t GetHash() const;
+
+    _NODISCARD bool_t operator==(const Tile& other) const { return std::memcmp(data.data(), other.data.data(), sizeof(data)) == 0; }
+};
+
+static_assert(sizeof(Tile) == 16, "Tiles are uploaded to the GPU as is");
+
+template <>
+struct std::hash<Tile>
+{
+    size_t operator()(const Tile& tile) const noexcept { return tile.GetHash(); }
+};
+
+using TileSet = std::vector<Tile>;
@@ -0,0 +1,59 @@
+﻿#pragma once
+
+#include <array>
+#include <vector>
+
+#include "action.hpp"
+#include "core.hpp"
+#include "parser.hpp"
+#include "reference_index.hpp"
+
+// Tile index -> new tile index
+using TileMapping = std::array<uint8_t, 256>;
+
+// Changes every tilemap cell and sprite part of a graphics set according to a mapping, keeping what is needed to revert it
+class TileRemap
+{
+public:
+    _NODISCARD static TileMapping Identity();
+
+    // Only the tiles the mapping moves are looked up in the reference index
+    void Capture(GraphicsHandle graphics, const TileMapping& mapping);
+    void Apply() const;
+    void Revert() const;
+
+    _NODISCARD size_t GetReferenceCount() const;
+    // Tilemaps and animations with captured edits
+    _NODISCARD std::vector<AssetTag> GetAssets() const;
+    // Heap memory used by the captured edits
+    _NODISCARD size_t GetMemoryFootprint() const;
+
+    void Serialize(ArchiveWriter& writer) const;
+    void Deserialize(ArchiveReader& reader);
+
+private:
+    struct CellEdit
+    {
+        uint32_t cell;
+        uint8_t oldTile;
+        uint8_t newTile;
+    };
+
+    struct TilemapEdits
+    {
+        TilemapHandle tilemap;
+        std::vector<CellEdit> edits;
+    };
+
+    struct OamEdit
+    {
+        OamReference reference;
+        uint8_t oldTile;
+        uint8_t newTile;
+    };
+
+    void Write(bool_t revert) const;
+
+    std::vector<TilemapEdits> m_Tilemaps;
+    std::vector<OamEdit> m_Oam;
+};
@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include <mdspan>
+#include <span>
+#include <vector>
+
+#include "core.hpp"
+
+// Row-major tilemap, all the rows are stored in a single contiguous buffer
+class Tilemap
+{
+public:
+    using View = std::mdspan<uint8_t, std::dextents<size_t, 2>>;
+    using ConstView = std::mdspan<const uint8_t, std::dextents<size_t, 2>>;
+
+    Tilemap() = default;
+    Tilemap(size_t width, size_t height, uint8_t value = 0);
+    Tilemap(size_t width, size_t height, std::vector<uint8_t> data);
+
+    // Keeps the top left part of the tilemap, new tiles are set to value
+    void Resize(size_t width, size_t height, uint8_t value = 0);
+
+    _NODISCARD size_t GetWidth() const { return m_Width; }
+    _NODISCARD size_t GetHeight() const { return m_Height; }
+    _NODISCARD size_t GetSize() const { return m_Data.size(); }
+    _NODISCARD bool_t IsEmpty() const { return m_Data.empty(); }
+
+    _NODISCARD uint8_t* GetData() { return m_Data.data(); }
+    _NODISCARD const uint8_t* GetData() const { return m_Data.data(); }
+
+    // Indexed with { y, x }
+    _NODISCARD View GetView() { return View(m_Data.data(), m_Height, m_Width); }
+    _NODISCARD ConstView GetView() const { return ConstView(m_Data.data(), m_Height, m_Width); }
+
+    _NODISCARD std::span<uint8_t> operator[](const size_t y) { return std::span(m_Data).subspan(y * m_Width, m_Width); }
+    _NODISCARD std::span<const uint8_t> operator[](const size_t y) const { return std::span(m_Data).subspan(y * m_Width, m_Width); }
+
+    _NODISCARD const std::vector<uint8_t>& GetTiles() const { return m_Data; }
+
+private:
+    size_t m_Width = 0;
+    size_t m_Height = 0;
+    std::vector<uint8_t> m_Data;
+};
@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "change_bus.hpp"
+#include "core.hpp"
+
+struct DoorTilesetDelta
+{
+    size_t doorId;
+    uint8_t targetTileset;
+    // Tilesets that can be loaded when standing in the owner room of the door, empty if unknown
+    std::vector<uint8_t> sourceTilesets;
+    // Tile slots that have to be uploaded when going through the door
+    std::vector<uint8_t> tiles;
+};
+
+class TilesetDeltaPlanner
+{
+    STATIC_CLASS(TilesetDeltaPlanner)
+
+public:
+    // Drops the results of the previous project, called when a project is loaded
+    static void Reset();
+    static void ComputeDeltas();
+    // Computes the deltas again if they were computed before and a door or tileset changed since then
+    static void UpdateDeltas();
+    static void ComputeOrdering();
+    static void Export();
+
+    // Tilesets that can be loaded when standing in each room
+    _NODISCARD static std::vector<std::vector<uint8_t>> ComputeRoomTilesets();
+
+    static inline std::vector<DoorTilesetDelta> deltas;
+
+    // For each tileset, new slot -> current tile index
+    static inline std::vector<std::vector<uint8_t>> ordering;
+    static inline size_t sharedSlotsBefore = 0;
+    static inline size_t sharedSlotsAfter = 0;
+
+    static inline bool_t exportOnSave = false;
+
+private:
+    static constexpr size_t NoSubscription = std::numeric_limits<size_t>::max();
+
+    static inline size_t m_Subscription = NoSubscription;
+    static inline bool_t m_DeltasComputed = false;
+    static inline bool_t m_DeltasDirty = false;
+
+    static void OnChange(const ChangeEvent& event);
+
+    _NODISCARD static bool_t TilesMatch(size_t tilesetA, size_t tileA, size_t tilesetB, size_t tileB);
+    _NODISCARD static size_t CountSharedSlots(const std::vector<std::vector<uint8_t>>& order);
+};
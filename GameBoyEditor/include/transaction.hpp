@@ -0,0 +1,45 @@
+﻿#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "action_queue.hpp"
+#include "change_bus.hpp"
+#include "core.hpp"
+#include "parser.hpp"
+
+// Groups edits of the project into a single change notification and a single undo step.
+// A transaction destroyed without being committed is rolled back, so an early return or an exception leaves the project as it was.
+// Transactions can be nested, an inner one becomes part of the outer one when committed
+class Transaction
+{
+public:
+    // The name is a literal, it is kept by the undo step
+    explicit Transaction(const char* name);
+    ~Transaction();
+
+    DELETE_COPY_MOVE_OPERATIONS(Transaction)
+
+    // Side effects that can't be rolled back, such as writing files, only run once the outermost transaction is committed.
+    // They run again when the transaction is undone or redone, so they have to write from the current state of the project
+    void Defer(std::function<void()> effect);
+
+    // Publishes the changes and pushes the undo step, nothing is pushed if nothing changed
+    void Commit(ActionQueue& queue);
+    void Rollback();
+
+    _NODISCARD bool_t IsOpen() const { return m_Open; }
+
+private:
+    static inline Transaction* m_Current = nullptr;
+    // Events of the last committed batch, swapped with the buffer of the bus so batches don't allocate
+    static inline std::vector<ChangeEvent> m_Events;
+
+    const char* m_Name;
+    ProjectState m_Before;
+    std::vector<std::function<void()>> m_Deferred;
+    Transaction* m_Parent;
+    bool_t m_Open = true;
+
+    void Close();
+};
@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include <span>
 #include <vector>
 
 #include "color.hpp"
@@ -15,9 +16,14 @@ public:
     static void DrawWindows();
     static void OnProjectLoaded();
 
-    static void DrawTile(const RenderTarget& renderTarget, const Graphics& graphics, size_t graphicsIndex, const Palette& palette, bool_t xFlip = false, bool_t yFlip = false);
-    static size_t DrawGraphics(const RenderTarget& renderTarget, const Graphics& graphics, const Palette& palette, size_t* selectedTile);
-    static void DrawTilemap(const RenderTarget& renderTarget, const Graphics& graphics, const Tilemap& tilemap, const Palette& palette);
+    // The graphics and tilemaps of the project are drawn from the textures of the TextureCache
+    static void DrawTile(const RenderTarget& renderTarget, GraphicsHandle graphics, size_t graphicsIndex, const Palette& palette, bool_t xFlip = false, bool_t yFlip = false);
+    static size_t DrawGraphics(const RenderTarget& renderTarget, GraphicsHandle graphics, const Palette& palette, size_t* selectedTile);
+    static void DrawTilemap(const RenderTarget& renderTarget, GraphicsHandle graphics, TilemapHandle tilemap, const Palette& palette);
+    // For a tilemap that isn't part of the project, it is uploaded on each call
+    static void DrawTilemap(const RenderTarget& renderTarget, GraphicsHandle graphics, const Tilemap& tilemap, const Palette& palette);
+    // For a tilemap kept by the caller, whose version changes whenever its content does so that it isn't hashed on each call
+    static void DrawTilemap(const RenderTarget& renderTarget, GraphicsHandle graphics, const Tilemap& tilemap, uint64_t version, const Palette& palette);
 
     static void DrawPalette(Palette& palette, float_t size, size_t* selectedColor);
     static void DrawCross(ImVec2 position, float_t size);
@@ -34,13 +40,18 @@ private:
     static void SetupWindow();
     static void SetupRenderer();
 
+    // The view is uploaded to the scratch texture when there is no tilemap texture, only if the pass isn't skipped
+    static void DrawTilemap(const RenderTarget& renderTarget, GraphicsHandle graphics, Tilemap::ConstView view, const Texture* tilemap,
+        const ContentHash& tilemapInputs, const Palette& palette);
+    _NODISCARD static int32_t GetGraphicsSize(GraphicsHandle graphics);
+    // Must be called after the graphics texture is taken from the TextureCache, for its version to be up to date
+    _NODISCARD static ContentHash GetGraphicsInputs(GraphicsHandle graphics, const Palette& palette);
 
     static inline std::vector<UiWindow*> m_Windows;
 
     static inline Shader m_GraphicsShader;
     static inline Shader m_TilemapShader;
 
-    static inline Texture m_GraphicsTexture;
     static inline Texture m_TilemapTexture;
 };
 
@@ -1,6 +1,8 @@
 ﻿#pragma once
 
+#include <limits>
 #include <string>
+#include <vector>
 
 #include "action_queue.hpp"
 #include "core.hpp"
@@ -19,6 +21,12 @@ public:
 
     void ProcessShortcuts();
     void DrawMenuBar();
+    // Background work on the undo history, called once per frame
+    static void CompactHistory() { m_ActionQueue.Compact(); }
+    // Picks up the undo history of the previous session, called once the project is loaded
+    static void OpenHistory();
+    // Saves the project and marks the applied actions as the history of the next session
+    static void SaveProject();
 
     std::string name;
     bool_t canBeClosed = true;
@@ -26,5 +34,22 @@ public:
     bool_t open = false;
 
 protected:
-    ActionQueue m_ActionQueue;
+    // Adds the assets whose actions the undo and redo buttons of the window go through
+    virtual void GetView(std::vector<AssetTag>&) const {}
+    // Changes whenever GetView may give other assets, along with the history, for the undo and redo buttons to be updated then
+    _NODISCARD virtual size_t GetViewKey() const { return 0; }
+
+    // Single history shared by every window, each one only sees the actions touching its assets
+    static inline ActionQueue m_ActionQueue;
+
+private:
+    // Gathers the view and the state of the undo and redo buttons again if the history or the view changed
+    void UpdateView();
+
+    std::vector<AssetTag> m_View;
+    // State of the undo and redo buttons for the history version and view key they were found with
+    size_t m_HistoryVersion = std::numeric_limits<size_t>::max();
+    size_t m_ViewKey = 0;
+    bool_t m_CanUndo = false;
+    bool_t m_CanRedo = false;
 };
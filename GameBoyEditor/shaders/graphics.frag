@@ -1,4 +1,4 @@
-#version 460
+﻿#version 460
 
 layout(origin_upper_left) in vec4 gl_FragCoord;
 
@@ -6,6 +6,8 @@ out vec4 FragColor;
 
 uniform highp sampler2D graphics;
 uniform int gfxSize;
+// First tile drawn, to draw a single tile of the graphics
+uniform int tileOffset;
 
 uniform vec4 colors[4];
 uniform int xFlip;
@@ -15,7 +17,7 @@ void main()
 {
     const ivec2 pixelPosition = ivec2(gl_FragCoord.xy);
 
-    const int tileId = pixelPosition.x / 8 + (pixelPosition.y / 8) * 16;
+    const int tileId = tileOffset + pixelPosition.x / 8 + (pixelPosition.y / 8) * 16;
 
     if (tileId >= gfxSize / 16)
         discard;
@@ -1,23 +1,51 @@
 ﻿#include "action_queue.hpp"
 
-void ActionQueue::Push(Action* action, const bool_t perform)
+#include <algorithm>
+
+#include "actions/edit_tilemap_action.hpp"
+#include "actions/graphics_add_tile_action.hpp"
+#include "actions/graphics_delete_tile_action.hpp"
+#include "actions/graphics_move_tile_action.hpp"
+#include "actions/plot_pixel_action.hpp"
+#include "actions/replace_tile_action.hpp"
+
+ActionQueue::~ActionQueue()
 {
-    if (IsAtEnd())
-    {
-        ShiftActions();
-        m_QueueIndex--;
-    }
-    else
-    {
-        RerouteQueue();
-    }
+    Clear();
+}
 
-    m_Queue[m_QueueIndex] = action;
+void ActionQueue::Push(ActionHandle<Action> action, const bool_t perform)
+{
+    RerouteQueue();
+    m_Version++;
 
     if (perform)
         action->Do();
 
-    m_QueueIndex++;
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const bool_t coalesce = m_Count > 0 && now - m_LastPush < CoalesceWindow;
+    m_LastPush = now;
+
+    // Quick successive strokes over the same area become a single step
+    if (coalesce && m_Entries[m_Last].action->Merge(*action))
+    {
+        // The record in the history file doesn't have the merged edits
+        m_Entries[m_Last].offset = HistoryFile::NoOffset;
+        Remeasure(m_Entries[m_Last]);
+        // The merged action may touch more assets
+        UnlinkTags(m_Last, true);
+        LinkTags(m_Last, true);
+        Trim();
+        return;
+    }
+
+    // Some actions only gather what they need to undo in Do, so the footprint is taken afterward
+    const size_t footprint = action->GetMemoryFootprint();
+    m_LastApplied = Append({ std::move(action), footprint });
+    m_Index++;
+    m_MemoryUsage += footprint;
+
+    Trim();
 }
 
 void ActionQueue::StepForward()
@@ -25,8 +53,24 @@ void ActionQueue::StepForward()
     if (!CanGoForward())
         return;
 
-    m_Queue[m_QueueIndex]->Do();
-    m_QueueIndex++;
+    m_Version++;
+
+    const size_t next = GetFirstUnapplied();
+    Entry& entry = m_Entries[next];
+    if (entry.spilled && !Restore(entry))
+    {
+        // The actions from this one can't be redone anymore
+        RerouteQueue();
+        return;
+    }
+
+    entry.action->Do();
+    Remeasure(entry);
+    MoveTags(next, false, true);
+    m_LastApplied = next;
+    m_Index++;
+
+    m_LastPush = {};
 }
 
 void ActionQueue::StepBack()
@@ -34,37 +78,586 @@ void ActionQueue::StepBack()
     if (!CanGoBackward())
         return;
 
-    m_QueueIndex--;
-    m_Queue[m_QueueIndex]->Undo();
+    m_Version++;
+
+    const size_t last = m_LastApplied;
+    Entry& entry = m_Entries[last];
+    if (entry.spilled && !Restore(entry))
+    {
+        // Nothing up to this action can be undone anymore
+        const size_t unusable = m_Index;
+        for (size_t i = 0; i < unusable; i++)
+            DropOldest();
+
+        return;
+    }
+
+    entry.action->Undo();
+    // Undoing may have decompressed the action
+    Remeasure(entry);
+    MoveTags(last, true, false);
+    m_LastApplied = entry.previous;
+    m_Index--;
+
+    for (Location* const cursor : { &m_NextToCompress, &m_NextToSpill })
+    {
+        if (cursor->position > m_Index)
+            *cursor = { m_Index, last };
+    }
+
+    // The next action shouldn't be merged into one the user went back to
+    m_LastPush = {};
+}
+
+void ActionQueue::StepBack(const ActionView view)
+{
+    const size_t entry = Find(view, true);
+    if (entry == NoEntry)
+        return;
+
+    // The actions after it don't depend on it, so it can be undone as if it was the last one
+    MoveToBoundary(entry, true);
+    StepBack();
+}
+
+void ActionQueue::StepForward(const ActionView view)
+{
+    const size_t entry = Find(view, false);
+    if (entry == NoEntry)
+        return;
+
+    MoveToBoundary(entry, false);
+    StepForward();
+}
+
+void ActionQueue::Compact()
+{
+    if (m_NextToCompress.position + UncompressedCount < m_Index)
+    {
+        Entry& entry = m_Entries[m_NextToCompress.entry];
+        entry.action->Compress();
+        Remeasure(entry);
+        m_NextToCompress = { m_NextToCompress.position + 1, entry.next };
+    }
+
+    if (m_History.IsOpen() && m_NextToSpill.position + HotCount < m_Index)
+    {
+        Entry& entry = m_Entries[m_NextToSpill.entry];
+        Spill(entry);
+        m_NextToSpill = { m_NextToSpill.position + 1, entry.next };
+    }
+}
+
+void ActionQueue::OpenHistory(const std::filesystem::path& path)
+{
+    Clear();
+
+    for (HistoryRecord& record : m_History.Open(path))
+    {
+        // Every action of the file is applied, they are only read when undone
+        ActionHandle<Action> stub = Create<SpilledAction>(record.assets, record.kind);
+        const size_t footprint = stub->GetMemoryFootprint();
+        m_LastApplied = Append({ std::move(stub), footprint, record.offset, true });
+        m_Index++;
+        m_MemoryUsage += footprint;
+    }
+
+    m_NextToCompress = { m_Count };
+    m_NextToSpill = { m_Count };
+    Trim();
+}
+
+void ActionQueue::Checkpoint()
+{
+    if (!m_History.IsOpen())
+        return;
+
+    // Undoing the actions before one that can't be written would require undoing it first, the kept history starts after it
+    size_t start = m_First;
+    for (size_t e = m_First, i = 0; i < m_Index; e = m_Entries[e].next, i++)
+    {
+        Entry& entry = m_Entries[e];
+        if (entry.offset == HistoryFile::NoOffset)
+            entry.offset = m_History.Append(*entry.action);
+
+        if (entry.offset == HistoryFile::NoOffset)
+            start = entry.next;
+    }
+
+    std::vector<uint64_t> offsets;
+    std::vector<AssetTag> assets;
+    for (size_t e = start; e != GetFirstUnapplied(); e = m_Entries[e].next)
+    {
+        const Entry& entry = m_Entries[e];
+        offsets.push_back(entry.offset);
+
+        for (const AssetTag& asset : entry.action->GetAssets())
+        {
+            if (!std::ranges::contains(assets, asset))
+                assets.push_back(asset);
+        }
+    }
+
+    m_History.AppendCheckpoint(offsets, assets);
+}
+
+void ActionQueue::SetMemoryBudget(const size_t bytes)
+{
+    m_MemoryBudget = bytes;
+    Trim();
 }
 
-bool_t ActionQueue::IsAtBeginning() const { return m_QueueIndex == 0; }
+bool_t ActionQueue::IsAtBeginning() const { return m_Index == 0; }
 
-bool_t ActionQueue::IsAtEnd() const { return m_QueueIndex == QueueSize; }
+bool_t ActionQueue::IsAtEnd() const { return m_Index == m_Count; }
 
-bool_t ActionQueue::CanGoForward() const { return !IsAtEnd() && m_Queue[m_QueueIndex] != nullptr; }
+bool_t ActionQueue::CanGoForward() const { return !IsAtEnd(); }
 
 bool_t ActionQueue::CanGoBackward() const { return !IsAtBeginning(); }
 
-void ActionQueue::ShiftActions()
+size_t ActionQueue::Find(const ActionView view, const bool_t applied) const
 {
-    delete m_Queue[0];
+    // The chains of the assets of the view, and of every asset of their type, end with their action nearest to the boundary.
+    // This costs a lookup per asset of the view and per asset of the action found, whatever the length of the history
+    size_t found = NoEntry;
+    for (const AssetTag& asset : view)
+    {
+        for (const uint32_t target : { asset.target, AssetTag::AnyTarget })
+        {
+            const size_t entry = GetNearest(FindChain(GetChainKey(asset.type, target)), applied);
+            if (entry != NoEntry && (found == NoEntry || IsNearer(entry, found, applied)))
+                found = entry;
+        }
+    }
 
-    for (size_t i = 0; i < QueueSize - 1; i++)
-        m_Queue[i] = m_Queue[i + 1];
+    return found == NoEntry || IsBlocked(found, applied) ? NoEntry : found;
 }
 
-void ActionQueue::RerouteQueue()
+bool_t ActionQueue::IsBlocked(const size_t entry, const bool_t applied) const
 {
-    if (m_Queue[m_QueueIndex] == nullptr)
+    for (size_t link = m_Entries[entry].firstLink; link != NoEntry; link = m_Links[link].sibling)
     {
-        // Nothing to reroute
+        const Chain& chain = m_Chains[m_Links[link].chain];
+        if (chain.wholeType)
+            continue;
+
+        // An AnyTarget asset overlaps every asset of its type, the others overlap themselves and AnyTarget
+        const bool_t anyTarget = chain.asset.target == AssetTag::AnyTarget;
+        const size_t nearer = anyTarget ? FindLink(entry, FindChain(GetChainKey(chain.asset.type, WholeType))) : link;
+        if ((applied ? m_Links[nearer].next : m_Links[nearer].previous) != NoEntry)
+            return true;
+
+        if (!anyTarget && IsNearer(GetNearest(FindChain(GetChainKey(chain.asset.type, AssetTag::AnyTarget)), applied), entry, applied))
+            return true;
+    }
+
+    return false;
+}
+
+size_t ActionQueue::GetNearest(const size_t chain, const bool_t applied) const
+{
+    if (chain == NoEntry)
+        return NoEntry;
+
+    const size_t link = applied ? m_Chains[chain].lastApplied : m_Chains[chain].firstUnapplied;
+    return link == NoEntry ? NoEntry : m_Links[link].entry;
+}
+
+bool_t ActionQueue::IsNearer(const size_t entry, const size_t other, const bool_t applied) const
+{
+    if (entry == NoEntry)
+        return false;
+
+    return applied ? m_Entries[entry].order > m_Entries[other].order : m_Entries[entry].order < m_Entries[other].order;
+}
+
+void ActionQueue::MoveToBoundary(const size_t entry, const bool_t applied)
+{
+    if (entry == (applied ? m_LastApplied : GetFirstUnapplied()))
         return;
+
+    m_Version++;
+
+    // Neither is the moved action, since it isn't already at the boundary
+    const size_t before = GetFirstUnapplied();
+    const size_t next = m_Entries[entry].next;
+
+    // Done first, the cursors compare the order the action had
+    MoveCursor(m_NextToCompress, entry, applied, next);
+    MoveCursor(m_NextToSpill, entry, applied, next);
+
+    Unlink(entry);
+    Link(entry, before);
+    if (applied)
+        m_LastApplied = entry;
+
+    MoveTags(entry, applied, applied);
+}
+
+void ActionQueue::MoveCursor(Location& cursor, const size_t entry, const bool_t applied, const size_t next) const
+{
+    // Cursors don't go past the boundary, so only applied actions can be before them
+    const bool_t processed = applied && (cursor.position >= m_Index || m_Entries[entry].order < m_Entries[cursor.entry].order);
+    const size_t to = applied ? m_Index - 1 : m_Index;
+
+    if (processed)
+    {
+        // A processed action leaves, the ones up to the cursor come one position closer
+        if (to >= cursor.position)
+            cursor.position--;
     }
+    else if (to <= cursor.position)
+    {
+        // An unprocessed action comes before the cursor, it resumes from it
+        cursor = { to, entry };
+    }
+    else if (entry == cursor.entry)
+    {
+        cursor.entry = next;
+    }
+}
+
+size_t ActionQueue::FindChain(const uint64_t key) const
+{
+    const std::unordered_map<uint64_t, size_t>::const_iterator it = m_ChainIndices.find(key);
+    return it == m_ChainIndices.end() ? NoEntry : it->second;
+}
+
+size_t ActionQueue::FindLink(const size_t entry, const size_t chain) const
+{
+    for (size_t link = m_Entries[entry].firstLink; link != NoEntry; link = m_Links[link].sibling)
+    {
+        if (m_Links[link].chain == chain)
+            return link;
+    }
+
+    return NoEntry;
+}
+
+void ActionQueue::LinkTags(const size_t entry, const bool_t applied)
+{
+    for (const AssetTag& asset : m_Entries[entry].action->GetAssets())
+    {
+        for (const uint64_t target : { static_cast<uint64_t>(asset.target), WholeType })
+        {
+            const uint64_t key = GetChainKey(asset.type, target);
+            size_t chain = FindChain(key);
+            if (chain == NoEntry)
+            {
+                chain = m_Chains.size();
+                m_Chains.push_back({ { asset.type, target == WholeType ? AssetTag::AnyTarget : asset.target }, target == WholeType });
+                m_ChainIndices.emplace(key, chain);
+            }
+            else if (target == WholeType && FindLink(entry, chain) != NoEntry)
+            {
+                // Already there for another asset of the type
+                continue;
+            }
+
+            size_t link;
+            if (m_FreeLinks.empty())
+            {
+                link = m_Links.size();
+                m_Links.push_back({ entry, chain });
+            }
+            else
+            {
+                link = m_FreeLinks.back();
+                m_FreeLinks.pop_back();
+                m_Links[link] = { entry, chain };
+            }
+
+            m_Links[link].sibling = m_Entries[entry].firstLink;
+            m_Entries[entry].firstLink = link;
+            Attach(link, applied);
+        }
+    }
+
+    m_Entries[entry].order = applied ? m_NextAppliedOrder++ : m_NextUnappliedOrder--;
+}
+
+void ActionQueue::UnlinkTags(const size_t entry, const bool_t applied)
+{
+    for (size_t link = m_Entries[entry].firstLink; link != NoEntry; link = m_Links[link].sibling)
+    {
+        Detach(link, applied);
+        m_FreeLinks.push_back(link);
+    }
+
+    m_Entries[entry].firstLink = NoEntry;
+}
+
+void ActionQueue::MoveTags(const size_t entry, const bool_t wasApplied, const bool_t applied)
+{
+    for (size_t link = m_Entries[entry].firstLink; link != NoEntry; link = m_Links[link].sibling)
+    {
+        Detach(link, wasApplied);
+        Attach(link, applied);
+    }
+
+    m_Entries[entry].order = applied ? m_NextAppliedOrder++ : m_NextUnappliedOrder--;
+}
+
+void ActionQueue::Attach(const size_t link, const bool_t applied)
+{
+    TagLink& tagLink = m_Links[link];
+    Chain& chain = m_Chains[tagLink.chain];
+
+    if (applied)
+    {
+        tagLink.previous = chain.lastApplied;
+        tagLink.next = NoEntry;
+        if (chain.lastApplied != NoEntry)
+            m_Links[chain.lastApplied].next = link;
+        chain.lastApplied = link;
+    }
+    else
+    {
+        tagLink.previous = NoEntry;
+        tagLink.next = chain.firstUnapplied;
+        if (chain.firstUnapplied != NoEntry)
+            m_Links[chain.firstUnapplied].previous = link;
+        chain.firstUnapplied = link;
+    }
+}
+
+void ActionQueue::Detach(const size_t link, const bool_t applied)
+{
+    const TagLink& tagLink = m_Links[link];
+    Chain& chain = m_Chains[tagLink.chain];
+
+    if (tagLink.previous != NoEntry)
+        m_Links[tagLink.previous].next = tagLink.next;
+    else if (!applied)
+        chain.firstUnapplied = tagLink.next;
+
+    if (tagLink.next != NoEntry)
+        m_Links[tagLink.next].previous = tagLink.previous;
+    else if (applied)
+        chain.lastApplied = tagLink.previous;
+}
+
+size_t ActionQueue::Append(Entry entry)
+{
+    if (m_Entries.empty())
+        m_Entries.reserve(InitialCapacity);
+
+    size_t index;
+    if (m_FreeEntries.empty())
+    {
+        index = m_Entries.size();
+        m_Entries.push_back(std::move(entry));
+    }
+    else
+    {
+        index = m_FreeEntries.back();
+        m_FreeEntries.pop_back();
+        m_Entries[index] = std::move(entry);
+    }
+
+    Link(index, NoEntry);
+    LinkTags(index, true);
+    m_Count++;
+
+    // Locations past the end now are at the new action
+    for (Location* const cursor : { &m_NextToCompress, &m_NextToSpill })
+    {
+        if (cursor->entry == NoEntry)
+            cursor->entry = index;
+    }
+
+    return index;
+}
+
+void ActionQueue::Unlink(const size_t entry)
+{
+    const size_t previous = m_Entries[entry].previous;
+    const size_t next = m_Entries[entry].next;
+
+    if (previous == NoEntry)
+        m_First = next;
+    else
+        m_Entries[previous].next = next;
+
+    if (next == NoEntry)
+        m_Last = previous;
+    else
+        m_Entries[next].previous = previous;
+
+    m_Entries[entry].previous = NoEntry;
+    m_Entries[entry].next = NoEntry;
+}
+
+void ActionQueue::Link(const size_t entry, const size_t before)
+{
+    const size_t previous = before == NoEntry ? m_Last : m_Entries[before].previous;
+    m_Entries[entry].previous = previous;
+    m_Entries[entry].next = before;
+
+    if (previous == NoEntry)
+        m_First = entry;
+    else
+        m_Entries[previous].next = entry;
+
+    if (before == NoEntry)
+        m_Last = entry;
+    else
+        m_Entries[before].previous = entry;
+}
+
+void ActionQueue::Release(const size_t entry)
+{
+    m_MemoryUsage -= m_Entries[entry].footprint;
+    m_Entries[entry] = {};
+    m_FreeEntries.push_back(entry);
+}
+
+void ActionQueue::Spill(Entry& entry)
+{
+    if (entry.spilled || entry.action->GetKind() == ActionKind::None)
+        return;
+
+    if (entry.offset == HistoryFile::NoOffset)
+        entry.offset = m_History.Append(*entry.action);
+
+    if (entry.offset == HistoryFile::NoOffset)
+        return;
+
+    ActionHandle<Action> stub = Create<SpilledAction>(entry.action->GetAssets(), entry.action->GetKind());
+    entry.action = std::move(stub);
+    entry.spilled = true;
+    Remeasure(entry);
+}
+
+bool_t ActionQueue::Restore(Entry& entry)
+{
+    std::vector<uint8_t> data;
+    const ActionKind kind = m_History.Read(entry.offset, data);
+
+    ArchiveReader reader(data);
+    ActionHandle<Action> action = Load(kind, reader);
+    if (!action || reader.HasFailed())
+        return false;
+
+    entry.action = std::move(action);
+    entry.spilled = false;
+    Remeasure(entry);
+    return true;
+}
+
+ActionHandle<Action> ActionQueue::Load(const ActionKind kind, ArchiveReader& reader)
+{
+    switch (kind)
+    {
+        case ActionKind::EditTilemap: return Create<EditTilemapAction>(reader);
+        case ActionKind::PlotPixel: return Create<PlotPixelAction>(reader);
+        case ActionKind::GraphicsAddTile: return Create<GraphicsAddTileAction>(reader);
+        case ActionKind::GraphicsDeleteTile: return Create<GraphicsDeleteTileAction>(reader);
+        case ActionKind::GraphicsMoveTile: return Create<GraphicsMoveTileAction>(reader);
+        case ActionKind::ReplaceTile: return Create<ReplaceTileAction>(reader);
+
+        case ActionKind::None:
+            return nullptr;
+    }
+
+    return nullptr;
+}
+
+void ActionQueue::Clear()
+{
+    // Oldest first, the way they would have been dropped
+    for (size_t e = m_First; e != NoEntry;)
+    {
+        const size_t next = m_Entries[e].next;
+        Release(e);
+        e = next;
+    }
+
+    m_Entries.clear();
+    m_FreeEntries.clear();
+    m_Chains.clear();
+    m_ChainIndices.clear();
+    m_Links.clear();
+    m_FreeLinks.clear();
+    m_NextAppliedOrder = 0;
+    m_NextUnappliedOrder = std::numeric_limits<uint64_t>::max();
+    m_First = NoEntry;
+    m_Last = NoEntry;
+    m_LastApplied = NoEntry;
+    m_Count = 0;
+    m_Index = 0;
+    m_NextToCompress = { 0 };
+    m_NextToSpill = { 0 };
+    m_MemoryUsage = 0;
+    m_Version++;
+}
+
+void ActionQueue::Remeasure(Entry& entry)
+{
+    m_MemoryUsage -= entry.footprint;
+    entry.footprint = entry.action->GetMemoryFootprint();
+    m_MemoryUsage += entry.footprint;
+}
+
+void ActionQueue::Trim()
+{
+    // Only applied actions can be dropped, redoing an action requires the ones before it
+    while (m_MemoryUsage > m_MemoryBudget && m_Index > 0 && m_Count > 1)
+        DropOldest();
+}
+
+void ActionQueue::DropOldest()
+{
+    m_Version++;
+
+    const size_t oldest = m_First;
+    const size_t next = m_Entries[oldest].next;
+    if (m_LastApplied == oldest)
+        m_LastApplied = NoEntry;
+
+    Unlink(oldest);
+    UnlinkTags(oldest, true);
+    Release(oldest);
+    m_Count--;
+    m_Index--;
+
+    for (Location* const cursor : { &m_NextToCompress, &m_NextToSpill })
+    {
+        if (cursor->position > 0)
+            cursor->position--;
+        else
+            cursor->entry = next;
+    }
+}
+
+void ActionQueue::RerouteQueue()
+{
+    if (IsAtEnd())
+        return;
+
+    m_Version++;
+
+    size_t e = GetFirstUnapplied();
+    m_Last = m_LastApplied;
+    if (m_LastApplied == NoEntry)
+        m_First = NoEntry;
+    else
+        m_Entries[m_LastApplied].next = NoEntry;
+
+    while (e != NoEntry)
+    {
+        const size_t next = m_Entries[e].next;
+        UnlinkTags(e, false);
+        Release(e);
+        e = next;
+    }
+
+    m_Count = m_Index;
 
-    for (size_t i = m_QueueIndex; i < QueueSize; i++)
+    // Locations at the first dropped action are past the end now
+    for (Location* const cursor : { &m_NextToCompress, &m_NextToSpill })
     {
-        delete m_Queue[m_QueueIndex];
-        m_Queue[m_QueueIndex] = nullptr;
+        if (cursor->position == m_Count)
+            cursor->entry = NoEntry;
     }
 }
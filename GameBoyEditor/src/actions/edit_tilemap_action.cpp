@@ -1,24 +1,219 @@
 ﻿#include "actions/edit_tilemap_action.hpp"
 
+#include <algorithm>
+
+#include "archive.hpp"
+#include "change_bus.hpp"
+#include "collision_grid.hpp"
+#include "reference_index.hpp"
+#include "rle.hpp"
+
+EditTilemapAction::EditTilemapAction(ArchiveReader& reader, std::pmr::memory_resource* const resource)
+    : Action(GetActionName(ActionKind::EditTilemap), resource), m_Edits(resource), m_Touched(resource), m_Compressed(resource)
+{
+    m_Tilemap = reader.ReadHandle(Parser::tilemaps);
+    m_Width = reader.Read<uint32_t>();
+    m_MinX = reader.Read<uint8_t>();
+    m_MinY = reader.Read<uint8_t>();
+    m_MaxX = reader.Read<uint8_t>();
+    m_MaxY = reader.Read<uint8_t>();
+    reader.ReadSpan(m_Edits);
+    reader.ReadSpan(m_Compressed);
+    m_CompressedCount = reader.Read<uint32_t>();
+
+    Touch(ChangeType::Tilemap, m_Tilemap.index);
+
+    if (!reader.HasFailed() && !Validate())
+        reader.Fail();
+}
+
 void EditTilemapAction::Do()
 {
+    Decompress();
+
+    Tilemap* const target = Parser::tilemaps.GetMutable(m_Tilemap);
+    if (target == nullptr)
+        return;
+
+    Tilemap& tilemap = *target;
+
     for (const BlockEdit& edit : m_Edits)
-        (*m_Tilemap)[edit.y][edit.x] = edit.newValue;
+    {
+        tilemap[edit.y][edit.x] = edit.newValue;
+        CollisionGridCache::UpdateTile(m_Tilemap, edit.x, edit.y);
+        ReferenceIndex::UpdateTile(m_Tilemap, edit.x, edit.y);
+        ChangeBus::Publish(ChangeEvent::TilemapRect(m_Tilemap, edit.x, edit.y, edit.x, edit.y));
+    }
 }
 
 void EditTilemapAction::Undo()
 {
-    for (const BlockEdit& edit : m_Edits)
-        (*m_Tilemap)[edit.y][edit.x] = edit.oldValue;
+    Decompress();
+
+    Tilemap* const target = Parser::tilemaps.GetMutable(m_Tilemap);
+    if (target == nullptr)
+        return;
+
+    Tilemap& tilemap = *target;
+
+    for (BlockEdit& edit : m_Edits)
+    {
+        // The tilemap is in the state the action left it in
+        edit.newValue = tilemap[edit.y][edit.x];
+        tilemap[edit.y][edit.x] = edit.oldValue;
+        CollisionGridCache::UpdateTile(m_Tilemap, edit.x, edit.y);
+        ReferenceIndex::UpdateTile(m_Tilemap, edit.x, edit.y);
+        ChangeBus::Publish(ChangeEvent::TilemapRect(m_Tilemap, edit.x, edit.y, edit.x, edit.y));
+    }
 }
 
-void EditTilemapAction::AddEdit(const uint8_t x, const uint8_t y, const uint8_t oldValue, const uint8_t newValue)
+bool_t EditTilemapAction::Merge(const Action& next)
 {
-    for (const BlockEdit& edit : m_Edits)
+    const EditTilemapAction* const other = dynamic_cast<const EditTilemapAction*>(&next);
+
+    // The cell bitmap is dropped when compressing, and a resize in between changes the meaning of the cells
+    if (other == nullptr || other->m_Tilemap != m_Tilemap || m_Touched.empty() || other->m_Touched.size() != m_Touched.size() || other->m_Width != m_Width)
+        return false;
+
+    if (other->m_MinX > m_MaxX + MergeDistance || other->m_MaxX + MergeDistance < m_MinX ||
+        other->m_MinY > m_MaxY + MergeDistance || other->m_MaxY + MergeDistance < m_MinY)
+        return false;
+
+    // The cells already edited keep their older value
+    for (const BlockEdit& edit : other->m_Edits)
+        AddEdit(edit.x, edit.y, edit.oldValue);
+
+    return true;
+}
+
+void EditTilemapAction::Compress()
+{
+    if (m_Edits.empty())
+        return;
+
+    std::ranges::sort(m_Edits, std::less(), [](const BlockEdit& edit) { return edit.y << 8 | edit.x; });
+
+    const size_t count = m_Edits.size();
+    std::pmr::vector<uint8_t> field(count, m_Compressed.get_allocator());
+    std::pmr::vector<uint8_t> compressed(m_Compressed.get_allocator());
+
+    // Rows repeat along a stroke and x mostly increases by 1, storing its delta makes it repeat as well
+    for (size_t i = 0; i < count; i++)
+        field[i] = m_Edits[i].y;
+    Rle::Encode(field, compressed);
+
+    for (size_t i = 0; i < count; i++)
+        field[i] = static_cast<uint8_t>(m_Edits[i].x - (i == 0 ? 0 : m_Edits[i - 1].x));
+    Rle::Encode(field, compressed);
+
+    for (size_t i = 0; i < count; i++)
+        field[i] = m_Edits[i].oldValue;
+    Rle::Encode(field, compressed);
+
+    for (size_t i = 0; i < count; i++)
+        field[i] = m_Edits[i].newValue;
+    Rle::Encode(field, compressed);
+
+    if (compressed.size() >= count * sizeof(BlockEdit))
+        return;
+
+    m_Compressed = std::move(compressed);
+    m_Compressed.shrink_to_fit();
+    m_CompressedCount = count;
+
+    // Assigning an empty vector would keep the capacity
+    m_Edits.clear();
+    m_Edits.shrink_to_fit();
+    m_Touched.clear();
+    m_Touched.shrink_to_fit();
+}
+
+void EditTilemapAction::Serialize(ArchiveWriter& writer) const
+{
+    writer.WriteHandle(Parser::tilemaps, m_Tilemap);
+    writer.Write<uint32_t>(static_cast<uint32_t>(m_Width));
+    writer.Write(m_MinX);
+    writer.Write(m_MinY);
+    writer.Write(m_MaxX);
+    writer.Write(m_MaxY);
+    writer.WriteSpan(std::span<const BlockEdit>(m_Edits));
+    writer.WriteSpan(std::span<const uint8_t>(m_Compressed));
+    writer.Write<uint32_t>(static_cast<uint32_t>(m_CompressedCount));
+}
+
+bool_t EditTilemapAction::Decompress()
+{
+    if (m_Compressed.empty())
+        return true;
+
+    std::pmr::vector<uint8_t> field(m_CompressedCount, m_Compressed.get_allocator());
+    m_Edits.resize(m_CompressedCount);
+
+    size_t offset = Rle::Decode(m_Compressed, field);
+    for (size_t i = 0; i < m_CompressedCount; i++)
+        m_Edits[i].y = field[i];
+
+    offset += Rle::Decode(std::span(m_Compressed).subspan(offset), field);
+    for (size_t i = 0; i < m_CompressedCount; i++)
+        m_Edits[i].x = static_cast<uint8_t>(field[i] + (i == 0 ? 0 : m_Edits[i - 1].x));
+
+    offset += Rle::Decode(std::span(m_Compressed).subspan(offset), field);
+    for (size_t i = 0; i < m_CompressedCount; i++)
+        m_Edits[i].oldValue = field[i];
+
+    offset += Rle::Decode(std::span(m_Compressed).subspan(offset), field);
+    for (size_t i = 0; i < m_CompressedCount; i++)
+        m_Edits[i].newValue = field[i];
+
+    const bool_t complete = offset == m_Compressed.size();
+
+    m_Compressed.clear();
+    m_Compressed.shrink_to_fit();
+    m_CompressedCount = 0;
+
+    return complete;
+}
+
+bool_t EditTilemapAction::Validate()
+{
+    if (!Parser::tilemaps.IsValid(m_Tilemap))
+        return false;
+
+    const Tilemap& tilemap = Parser::tilemaps.Get(m_Tilemap);
+
+    // A cell has a single edit, and there are edits exactly when there is compressed data
+    if (m_Edits.size() + m_CompressedCount > tilemap.GetSize() || m_Compressed.empty() != (m_CompressedCount == 0))
+        return false;
+
+    if (!Decompress())
+        return false;
+
+    return std::ranges::all_of(m_Edits, [&tilemap](const BlockEdit& edit) { return edit.x < tilemap.GetWidth() && edit.y < tilemap.GetHeight(); });
+}
+
+void EditTilemapAction::AddEdit(const uint8_t x, const uint8_t y, const uint8_t oldValue)
+{
+    if (m_Touched.empty())
     {
-        if (edit.x == x && edit.y == y)
-            return;
+        const Tilemap& tilemap = Parser::tilemaps.Get(m_Tilemap);
+        m_Width = tilemap.GetWidth();
+        m_Touched.resize(tilemap.GetSize());
     }
-    
-    m_Edits.emplace_back(x, y, oldValue, newValue);
+
+    const size_t cell = y * m_Width + x;
+    if (cell >= m_Touched.size() || m_Touched[cell])
+        return;
+
+    m_Touched[cell] = true;
+    m_Edits.emplace_back(x, y, oldValue, oldValue);
+
+    m_MinX = std::min(m_MinX, x);
+    m_MinY = std::min(m_MinY, y);
+    m_MaxX = std::max(m_MaxX, x);
+    m_MaxY = std::max(m_MaxY, y);
+}
+
+size_t EditTilemapAction::GetMemoryFootprint() const
+{
+    return sizeof(*this) + m_Edits.capacity() * sizeof(BlockEdit) + m_Touched.capacity() / 8 + m_Compressed.capacity();
 }
@@ -1,18 +1,70 @@
 ﻿#include "actions/graphics_add_tile_action.hpp"
 
-GraphicsAddTileAction::GraphicsAddTileAction(Graphics* const graphics, const size_t position)
-    : Action("Delete tile"), m_Graphics(graphics), m_Position(position)
+#include "archive.hpp"
+#include "change_bus.hpp"
+
+GraphicsAddTileAction::GraphicsAddTileAction(const GraphicsHandle graphics, const size_t position, const Tile& tile, std::pmr::memory_resource* const resource)
+    : Action(GetActionName(ActionKind::GraphicsAddTile), resource), m_Graphics(graphics), m_Position(position), m_Tile(tile)
+{
+    // A tile pushed past 255 can't be referenced anymore, its references are left as they are
+    TileMapping mapping = TileRemap::Identity();
+    for (size_t i = m_Position; i < mapping.size() - 1; i++)
+        mapping[i] = static_cast<uint8_t>(i + 1);
+
+    m_Remap.Capture(m_Graphics, mapping);
+
+    Touch(ChangeType::Graphics, m_Graphics.index);
+    Touch(m_Remap.GetAssets());
+}
+
+GraphicsAddTileAction::GraphicsAddTileAction(ArchiveReader& reader, std::pmr::memory_resource* const resource)
+    : Action(GetActionName(ActionKind::GraphicsAddTile), resource)
 {
-    for (size_t i = 0; i < 16; i++)
-        m_Tile[i] = (*m_Graphics)[m_Position * 16 + i];
+    m_Graphics = reader.ReadHandle(Parser::graphics);
+    m_Position = reader.Read<uint32_t>();
+    m_Tile = reader.Read<Tile>();
+    m_Remap.Deserialize(reader);
+
+    Touch(ChangeType::Graphics, m_Graphics.index);
+    Touch(m_Remap.GetAssets());
 }
 
 void GraphicsAddTileAction::Do()
 {
-    m_Graphics->insert_range(m_Graphics->begin() + static_cast<int64_t>(m_Position) * 16, m_Tile);
+    Graphics* const graphics = Parser::graphics.GetMutable(m_Graphics);
+    if (graphics == nullptr)
+        return;
+
+    graphics->insert(graphics->begin() + static_cast<int64_t>(m_Position), m_Tile);
+
+    m_Remap.Apply();
+
+    // Every tile from the position moved
+    ChangeBus::Publish(ChangeEvent::GraphicsTiles(m_Graphics, m_Position));
 }
 
 void GraphicsAddTileAction::Undo()
 {
-    m_Graphics->erase(m_Graphics->begin() + static_cast<int64_t>(m_Position) * 16, m_Graphics->begin() + static_cast<int64_t>(m_Position + 1) * 16);
+    Graphics* const graphics = Parser::graphics.GetMutable(m_Graphics);
+    if (graphics == nullptr)
+        return;
+
+    graphics->erase(graphics->begin() + static_cast<int64_t>(m_Position));
+
+    m_Remap.Revert();
+
+    ChangeBus::Publish(ChangeEvent::GraphicsTiles(m_Graphics, m_Position));
+}
+
+void GraphicsAddTileAction::Serialize(ArchiveWriter& writer) const
+{
+    writer.WriteHandle(Parser::graphics, m_Graphics);
+    writer.Write<uint32_t>(static_cast<uint32_t>(m_Position));
+    writer.Write(m_Tile);
+    m_Remap.Serialize(writer);
+}
+
+size_t GraphicsAddTileAction::GetMemoryFootprint() const
+{
+    return sizeof(*this) + m_Remap.GetMemoryFootprint();
 }
@@ -1,18 +1,75 @@
 ﻿#include "actions/graphics_delete_tile_action.hpp"
 
-GraphicsDeleteTileAction::GraphicsDeleteTileAction(Graphics* const graphics, const size_t position)
-    : Action("Delete tile"), m_Graphics(graphics), m_Position(position)
+#include "archive.hpp"
+#include "change_bus.hpp"
+
+GraphicsDeleteTileAction::GraphicsDeleteTileAction(const GraphicsHandle graphics, const size_t position, std::pmr::memory_resource* const resource)
+    : Action(GetActionName(ActionKind::GraphicsDeleteTile), resource), m_Graphics(graphics), m_Position(position)
+{
+    m_Tile = Parser::graphics.Get(m_Graphics)[m_Position];
+
+    TileMapping mapping = TileRemap::Identity();
+    if (m_Position < mapping.size())
+    {
+        mapping[m_Position] = 0;
+        for (size_t i = m_Position + 1; i < mapping.size(); i++)
+            mapping[i] = static_cast<uint8_t>(i - 1);
+    }
+
+    m_Remap.Capture(m_Graphics, mapping);
+
+    Touch(ChangeType::Graphics, m_Graphics.index);
+    Touch(m_Remap.GetAssets());
+}
+
+GraphicsDeleteTileAction::GraphicsDeleteTileAction(ArchiveReader& reader, std::pmr::memory_resource* const resource)
+    : Action(GetActionName(ActionKind::GraphicsDeleteTile), resource)
 {
-    for (size_t i = 0; i < 16; i++)
-        m_Tile[i] = (*m_Graphics)[m_Position * 16 + i];
+    m_Graphics = reader.ReadHandle(Parser::graphics);
+    m_Position = reader.Read<uint32_t>();
+    m_Tile = reader.Read<Tile>();
+    m_Remap.Deserialize(reader);
+
+    Touch(ChangeType::Graphics, m_Graphics.index);
+    Touch(m_Remap.GetAssets());
 }
 
 void GraphicsDeleteTileAction::Do()
 {
-    m_Graphics->erase(m_Graphics->begin() + static_cast<int64_t>(m_Position) * 16, m_Graphics->begin() + static_cast<int64_t>(m_Position + 1) * 16);
+    Graphics* const graphics = Parser::graphics.GetMutable(m_Graphics);
+    if (graphics == nullptr)
+        return;
+
+    graphics->erase(graphics->begin() + static_cast<int64_t>(m_Position));
+
+    m_Remap.Apply();
+
+    // Every tile from the position moved
+    ChangeBus::Publish(ChangeEvent::GraphicsTiles(m_Graphics, m_Position));
 }
 
 void GraphicsDeleteTileAction::Undo()
 {
-    m_Graphics->insert_range(m_Graphics->begin() + static_cast<int64_t>(m_Position) * 16, m_Tile);
+    Graphics* const graphics = Parser::graphics.GetMutable(m_Graphics);
+    if (graphics == nullptr)
+        return;
+
+    graphics->insert(graphics->begin() + static_cast<int64_t>(m_Position), m_Tile);
+
+    m_Remap.Revert();
+
+    ChangeBus::Publish(ChangeEvent::GraphicsTiles(m_Graphics, m_Position));
+}
+
+void GraphicsDeleteTileAction::Serialize(ArchiveWriter& writer) const
+{
+    writer.WriteHandle(Parser::graphics, m_Graphics);
+    writer.Write<uint32_t>(static_cast<uint32_t>(m_Position));
+    writer.Write(m_Tile);
+    m_Remap.Serialize(writer);
+}
+
+size_t GraphicsDeleteTileAction::GetMemoryFootprint() const
+{
+    return sizeof(*this) + m_Remap.GetMemoryFootprint();
 }
@@ -0,0 +1,85 @@
+﻿#include "actions/graphics_move_tile_action.hpp"
+
+#include <algorithm>
+
+#include "archive.hpp"
+#include "change_bus.hpp"
+
+GraphicsMoveTileAction::GraphicsMoveTileAction(const GraphicsHandle graphics, const size_t from, const size_t to, std::pmr::memory_resource* const resource)
+    : Action(GetActionName(ActionKind::GraphicsMoveTile), resource), m_Graphics(graphics), m_From(from), m_To(to)
+{
+    TileMapping mapping = TileRemap::Identity();
+
+    for (size_t i = std::min(m_From, m_To); i <= std::max(m_From, m_To) && i < mapping.size(); i++)
+    {
+        size_t target;
+        if (i == m_From)
+            target = m_To;
+        else if (m_From < m_To)
+            target = i - 1;
+        else
+            target = i + 1;
+
+        // Tiles moved past 255 can't be referenced anymore, their references are left as they are
+        if (target < mapping.size())
+            mapping[i] = static_cast<uint8_t>(target);
+    }
+
+    m_Remap.Capture(m_Graphics, mapping);
+
+    Touch(ChangeType::Graphics, m_Graphics.index);
+    Touch(m_Remap.GetAssets());
+}
+
+GraphicsMoveTileAction::GraphicsMoveTileAction(ArchiveReader& reader, std::pmr::memory_resource* const resource)
+    : Action(GetActionName(ActionKind::GraphicsMoveTile), resource)
+{
+    m_Graphics = reader.ReadHandle(Parser::graphics);
+    m_From = reader.Read<uint32_t>();
+    m_To = reader.Read<uint32_t>();
+    m_Remap.Deserialize(reader);
+
+    Touch(ChangeType::Graphics, m_Graphics.index);
+    Touch(m_Remap.GetAssets());
+}
+
+void GraphicsMoveTileAction::Do()
+{
+    Move(m_From, m_To);
+    m_Remap.Apply();
+}
+
+void GraphicsMoveTileAction::Undo()
+{
+    Move(m_To, m_From);
+    m_Remap.Revert();
+}
+
+void GraphicsMoveTileAction::Move(const size_t from, const size_t to) const
+{
+    Graphics* const target = Parser::graphics.GetMutable(m_Graphics);
+    if (target == nullptr)
+        return;
+
+    Graphics& graphics = *target;
+
+    if (from < to)
+        std::rotate(graphics.begin() + static_cast<int64_t>(from), graphics.begin() + static_cast<int64_t>(from) + 1, graphics.begin() + static_cast<int64_t>(to) + 1);
+    else
+        std::rotate(graphics.begin() + static_cast<int64_t>(to), graphics.begin() + static_cast<int64_t>(from), graphics.begin() + static_cast<int64_t>(from) + 1);
+
+    ChangeBus::Publish(ChangeEvent::GraphicsTiles(m_Graphics, std::min(from, to), std::max(from, to)));
+}
+
+void GraphicsMoveTileAction::Serialize(ArchiveWriter& writer) const
+{
+    writer.WriteHandle(Parser::graphics, m_Graphics);
+    writer.Write<uint32_t>(static_cast<uint32_t>(m_From));
+    writer.Write<uint32_t>(static_cast<uint32_t>(m_To));
+    m_Remap.Serialize(writer);
+}
+
+size_t GraphicsMoveTileAction::GetMemoryFootprint() const
+{
+    return sizeof(*this) + m_Remap.GetMemoryFootprint();
+}
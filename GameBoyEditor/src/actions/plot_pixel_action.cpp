@@ -1,34 +1,137 @@
 ﻿#include "actions/plot_pixel_action.hpp"
 
-void PlotPixelAction::Do()
+#include <algorithm>
+#include <cstring>
+
+#include "archive.hpp"
+#include "change_bus.hpp"
+
+PlotPixelAction::PlotPixelAction(ArchiveReader& reader, std::pmr::memory_resource* const resource)
+    : Action(GetActionName(ActionKind::PlotPixel), resource), m_Rows(resource), m_OldPlanes(resource), m_NewPlanes(resource)
 {
-    for (const PixelEdit& edit : m_Edits)
+    m_Graphics = reader.ReadHandle(Parser::graphics);
+    m_FirstTile = reader.Read<uint8_t>();
+    m_LastTile = reader.Read<uint8_t>();
+    reader.ReadSpan(m_Rows);
+    reader.ReadSpan(m_OldPlanes);
+    reader.ReadSpan(m_NewPlanes);
+
+    // A corrupted record could otherwise write anywhere in the graphics
+    if (m_OldPlanes.size() != m_Rows.size() || m_NewPlanes.size() != m_Rows.size()
+        || std::ranges::any_of(m_Rows, [](const uint16_t row) { return row >= MaxRows; }))
     {
-        (*m_Graphics)[edit.tile * 16 + edit.row * 2 + 0] = edit.newPlane0;
-        (*m_Graphics)[edit.tile * 16 + edit.row * 2 + 1] = edit.newPlane1;
+        m_Rows.clear();
+        m_OldPlanes.clear();
+        m_NewPlanes.clear();
     }
+
+    for (const uint16_t row : m_Rows)
+        m_Touched[row] = true;
+
+    Touch(ChangeType::Graphics, m_Graphics.index);
+}
+
+void PlotPixelAction::Do()
+{
+    Graphics* const graphics = Parser::graphics.GetMutable(m_Graphics);
+    if (graphics == nullptr)
+        return;
+
+    // Tiles are contiguous, the planes of a row are at 2 * row bytes from the start of the graphics
+    uint8_t* const data = reinterpret_cast<uint8_t*>(graphics->data());
+
+    for (size_t i = 0; i < m_Rows.size(); i++)
+        std::memcpy(data + m_Rows[i] * sizeof(uint16_t), &m_NewPlanes[i], sizeof(uint16_t));
+
+    PublishChange();
 }
 
 void PlotPixelAction::Undo()
 {
-    for (const PixelEdit& edit : m_Edits)
+    Graphics* const graphics = Parser::graphics.GetMutable(m_Graphics);
+    if (graphics == nullptr)
+        return;
+
+    uint8_t* const data = reinterpret_cast<uint8_t*>(graphics->data());
+
+    // The graphics are in the state the action left them in
+    for (size_t i = 0; i < m_Rows.size(); i++)
     {
-        (*m_Graphics)[edit.tile * 16 + edit.row * 2 + 0] = edit.oldPlane0;
-        (*m_Graphics)[edit.tile * 16 + edit.row * 2 + 1] = edit.oldPlane1;
+        std::memcpy(&m_NewPlanes[i], data + m_Rows[i] * sizeof(uint16_t), sizeof(uint16_t));
+        std::memcpy(data + m_Rows[i] * sizeof(uint16_t), &m_OldPlanes[i], sizeof(uint16_t));
     }
+
+    PublishChange();
 }
 
-void PlotPixelAction::AddEdit(const uint8_t tile, const uint8_t row, const uint8_t oldPlane0, const uint8_t oldPlane1, const uint8_t newPlane0, const uint8_t newPlane1)
+bool_t PlotPixelAction::Merge(const Action& next)
 {
-    for (PixelEdit& edit : m_Edits)
+    const PlotPixelAction* const other = dynamic_cast<const PlotPixelAction*>(&next);
+
+    if (other == nullptr || other->m_Graphics != m_Graphics || other->m_Rows.empty())
+        return false;
+
+    if (other->m_FirstTile > m_LastTile + 1 || other->m_LastTile + 1 < m_FirstTile)
+        return false;
+
+    // The rows already edited keep their older planes
+    for (size_t i = 0; i < other->m_Rows.size(); i++)
     {
-        if (edit.tile == tile && edit.row == row)
-        {
-            edit.newPlane0 = newPlane0;
-            edit.newPlane1 = newPlane1;
-            return;
-        }
+        const uint16_t index = other->m_Rows[i];
+        if (m_Touched[index])
+            continue;
+
+        m_Touched[index] = true;
+        m_Rows.push_back(index);
+        m_OldPlanes.push_back(other->m_OldPlanes[i]);
+        m_NewPlanes.push_back(other->m_NewPlanes[i]);
     }
 
-    m_Edits.emplace_back(tile, row, oldPlane0, oldPlane1, newPlane0, newPlane1);
+    m_FirstTile = std::min(m_FirstTile, other->m_FirstTile);
+    m_LastTile = std::max(m_LastTile, other->m_LastTile);
+
+    return true;
+}
+
+void PlotPixelAction::Serialize(ArchiveWriter& writer) const
+{
+    writer.WriteHandle(Parser::graphics, m_Graphics);
+    writer.Write(m_FirstTile);
+    writer.Write(m_LastTile);
+    writer.WriteSpan(std::span<const uint16_t>(m_Rows));
+    writer.WriteSpan(std::span<const uint16_t>(m_OldPlanes));
+    writer.WriteSpan(std::span<const uint16_t>(m_NewPlanes));
+}
+
+void PlotPixelAction::PublishChange() const
+{
+    if (m_Rows.empty())
+        return;
+
+    ChangeBus::Publish(ChangeEvent::GraphicsTiles(m_Graphics, m_FirstTile, m_LastTile));
+}
+
+void PlotPixelAction::AddEdit(const uint8_t tile, const uint8_t row, const uint8_t oldPlane0, const uint8_t oldPlane1)
+{
+    const uint16_t index = static_cast<uint16_t>(tile * 8 + row);
+    if (m_Touched[index])
+        return;
+
+    m_Touched[index] = true;
+
+    const uint8_t planes[2] = { oldPlane0, oldPlane1 };
+    uint16_t packed;
+    std::memcpy(&packed, planes, sizeof(packed));
+
+    m_Rows.push_back(index);
+    m_OldPlanes.push_back(packed);
+    m_NewPlanes.push_back(packed);
+
+    m_FirstTile = std::min(m_FirstTile, tile);
+    m_LastTile = std::max(m_LastTile, tile);
+}
+
+size_t PlotPixelAction::GetMemoryFootprint() const
+{
+    return sizeof(*this) + (m_Rows.capacity() + m_OldPlanes.capacity() + m_NewPlanes.capacity()) * sizeof(uint16_t);
 }
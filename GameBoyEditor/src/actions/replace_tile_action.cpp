@@ -0,0 +1,46 @@
+﻿#include "actions/replace_tile_action.hpp"
+
+#include "archive.hpp"
+
+ReplaceTileAction::ReplaceTileAction(const GraphicsHandle graphics, const uint8_t oldTile, const uint8_t newTile, std::pmr::memory_resource* const resource)
+    : Action(GetActionName(ActionKind::ReplaceTile), resource), m_Graphics(graphics)
+{
+    TileMapping mapping = TileRemap::Identity();
+    mapping[oldTile] = newTile;
+
+    m_Remap.Capture(graphics, mapping);
+
+    Touch(ChangeType::Graphics, graphics.index);
+    Touch(m_Remap.GetAssets());
+}
+
+ReplaceTileAction::ReplaceTileAction(ArchiveReader& reader, std::pmr::memory_resource* const resource)
+    : Action(GetActionName(ActionKind::ReplaceTile), resource)
+{
+    m_Graphics = reader.ReadHandle(Parser::graphics);
+    m_Remap.Deserialize(reader);
+
+    Touch(ChangeType::Graphics, m_Graphics.index);
+    Touch(m_Remap.GetAssets());
+}
+
+void ReplaceTileAction::Do()
+{
+    m_Remap.Apply();
+}
+
+void ReplaceTileAction::Undo()
+{
+    m_Remap.Revert();
+}
+
+void ReplaceTileAction::Serialize(ArchiveWriter& writer) const
+{
+    writer.WriteHandle(Parser::graphics, m_Graphics);
+    m_Remap.Serialize(writer);
+}
+
+size_t ReplaceTileAction::GetMemoryFootprint() const
+{
+    return sizeof(*this) + m_Remap.GetMemoryFootprint();
+}
@@ -0,0 +1,91 @@
+﻿#include "actions/transaction_action.hpp"
+
+TransactionAction::TransactionAction(const char* const name, ProjectPatch undo, ProjectPatch redo, std::vector<ChangeEvent> events,
+    std::vector<std::function<void()>> effects, std::pmr::memory_resource* const resource)
+    : Action(name, resource), m_Undo(std::move(undo)), m_Redo(std::move(redo)), m_Events(std::move(events)), m_Effects(std::move(effects))
+{
+    // Both patches cover the same entries, the values tell which assets they refer to
+    TouchPatch(m_Undo);
+    TouchPatch(m_Redo);
+
+    for (const ChangeEvent& event : m_Events)
+        Touch(event.type, event.target);
+}
+
+void TransactionAction::Do()
+{
+    Apply(m_Redo);
+}
+
+void TransactionAction::Undo()
+{
+    Apply(m_Undo);
+}
+
+size_t TransactionAction::GetMemoryFootprint() const
+{
+    return sizeof(*this) + m_Undo.GetMemoryFootprint() + m_Redo.GetMemoryFootprint() + m_Events.capacity() * sizeof(ChangeEvent)
+        + m_Effects.capacity() * sizeof(std::function<void()>) + GetAssets().size() * sizeof(AssetTag);
+}
+
+void TransactionAction::Apply(const ProjectPatch& patch) const
+{
+    Parser::ApplyPatch(patch);
+
+    for (const ChangeEvent& event : m_Events)
+        ChangeBus::Publish(event);
+
+    for (const std::function<void()>& effect : m_Effects)
+        effect();
+
+    Parser::MarkUnsaved();
+}
+
+void TransactionAction::TouchPatch(const ProjectPatch& patch)
+{
+    for (const AssetStore<Graphics>::SlotState& state : patch.graphics)
+        Touch(ChangeType::Graphics, state.index);
+    for (const AssetStore<Tilemap>::SlotState& state : patch.tilemaps)
+        Touch(ChangeType::Tilemap, state.index);
+    for (const AssetStore<std::vector<SpriteData>>::SlotState& state : patch.sprites)
+        Touch(ChangeType::SpriteData, state.index);
+    for (const AssetStore<Animation>::SlotState& state : patch.animations)
+        Touch(ChangeType::Animation, state.index);
+    for (const AssetStore<CollisionTable>::SlotState& state : patch.collisionTables)
+        Touch(ChangeType::CollisionTable, state.index);
+
+    // The door data belongs to the doors it lists
+    for (const AssetStore<DoorData>::SlotState& state : patch.roomsDoorData)
+    {
+        if (!state.asset)
+            continue;
+
+        for (const uint8_t doorId : *state.asset)
+            Touch(ChangeType::Door, doorId);
+    }
+
+    for (const std::pair<size_t, GraphicsHandle>& entry : patch.tilesets.entries)
+        Touch(ChangeType::Graphics, entry.second.index);
+    for (const std::pair<size_t, CollisionTableHandle>& entry : patch.collisionTableArray.entries)
+        Touch(ChangeType::CollisionTable, entry.second.index);
+    for (const std::pair<size_t, Room>& entry : patch.rooms.entries)
+        Touch(ChangeType::RoomPalette, static_cast<uint32_t>(entry.first));
+    for (const std::pair<size_t, Door>& entry : patch.doors.entries)
+        Touch(ChangeType::Door, static_cast<uint32_t>(entry.first));
+    for (const std::pair<size_t, std::vector<uint8_t>>& entry : patch.doorTargeters.entries)
+        Touch(ChangeType::Door, static_cast<uint32_t>(entry.first));
+
+    for (const std::pair<std::string, std::optional<Metatiles>>& entry : patch.metatiles.entries)
+    {
+        const GraphicsHandle graphics = Parser::graphics.Find(entry.first);
+        if (!graphics.IsNull())
+            Touch(ChangeType::Graphics, graphics.index);
+    }
+
+    for (const std::pair<std::string, std::optional<std::string>>& entry : patch.metatileTilemaps.entries)
+    {
+        const TilemapHandle tilemap = Parser::tilemaps.Find(entry.first);
+        if (!tilemap.IsNull())
+            Touch(ChangeType::Tilemap, tilemap.index);
+    }
+}
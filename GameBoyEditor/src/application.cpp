@@ -3,7 +3,10 @@
 #include <filesystem>
 #include <iostream>
 
+#include "change_bus.hpp"
 #include "parser.hpp"
+#include "render_target.hpp"
+#include "texture_cache.hpp"
 #include "ui.hpp"
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
@@ -45,6 +48,9 @@ bool_t Application::Init()
 
     Ui::Init();
 
+    // Any edit made to a loaded project needs to be saved, whichever project it is
+    ChangeBus::Subscribe([](const ChangeEvent&) { Parser::MarkUnsaved(); });
+
     return true;
 }
 
@@ -56,6 +62,11 @@ void Application::Update()
 
         Ui::MainMenuBar();
         Ui::DrawWindows();
+        ChangeBus::Flush();
+        if (m_ProjectLoaded)
+            Parser::PublishSnapshot();
+        RenderTarget::EndFrame();
+        TextureCache::EndFrame();
 
         PostLoop();
     }
@@ -91,6 +102,7 @@ bool_t Application::TryParseProject()
         return false;
 
     m_ProjectLoaded = true;
+
     Ui::OnProjectLoaded();
     return true;
 }
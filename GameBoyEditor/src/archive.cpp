@@ -0,0 +1,44 @@
+﻿#include "archive.hpp"
+
+void ArchiveWriter::WriteString(const std::string& value)
+{
+    Write<uint32_t>(static_cast<uint32_t>(value.size()));
+    WriteBytes(value.data(), value.size());
+}
+
+void ArchiveWriter::WriteBytes(const void* const source, const size_t size)
+{
+    const size_t offset = m_Buffer.size();
+    m_Buffer.resize(offset + size);
+    if (size != 0)
+        std::memcpy(m_Buffer.data() + offset, source, size);
+}
+
+std::string ArchiveReader::ReadString()
+{
+    const size_t size = Read<uint32_t>();
+    if (size > m_Data.size() - m_Position)
+    {
+        m_Failed = true;
+        return {};
+    }
+
+    std::string value(size, '\0');
+    ReadBytes(value.data(), size);
+    return value;
+}
+
+void ArchiveReader::ReadBytes(void* const destination, const size_t size)
+{
+    if (size > m_Data.size() - m_Position)
+    {
+        m_Failed = true;
+        m_Position = m_Data.size();
+        std::memset(destination, 0, size);
+        return;
+    }
+
+    if (size != 0)
+        std::memcpy(destination, m_Data.data() + m_Position, size);
+    m_Position += size;
+}
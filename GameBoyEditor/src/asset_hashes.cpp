@@ -0,0 +1,145 @@
+﻿#include "asset_hashes.hpp"
+
+#include <algorithm>
+#include <bit>
+
+void AssetHashes::Reset()
+{
+    m_Graphics.clear();
+    m_Tilemaps.clear();
+    m_Animations.clear();
+    m_SpriteData.clear();
+    m_CollisionTables.clear();
+
+    if (m_Subscription == NoSubscription)
+        m_Subscription = ChangeBus::Subscribe(OnChange);
+}
+
+ContentHash AssetHashes::Get(const GraphicsHandle graphics)
+{
+    const Graphics& tiles = Parser::graphics.Get(graphics);
+
+    return Resolve(m_Graphics, graphics.index, graphics.generation, tiles.size(), tiles.size(), [&tiles](const size_t tile)
+    {
+        return ContentHash::Of(tiles[tile].data);
+    });
+}
+
+ContentHash AssetHashes::Get(const TilemapHandle tilemap)
+{
+    const Tilemap& map = Parser::tilemaps.Get(tilemap);
+
+    return Resolve(m_Tilemaps, tilemap.index, tilemap.generation, map.GetHeight(), map.GetWidth(), [&map](const size_t row)
+    {
+        return ContentHash::Of(map[row]);
+    });
+}
+
+ContentHash AssetHashes::Get(const AnimationHandle animation)
+{
+    const Animation& frames = Parser::animations.Get(animation);
+
+    return Resolve(m_Animations, animation.index, animation.generation, frames.size(), frames.size(), [&frames](const size_t frame)
+    {
+        const std::vector<OamEntry>& oam = frames[frame].oam;
+        const ContentHash hash = ContentHash::Of(std::span(reinterpret_cast<const uint8_t*>(oam.data()), oam.size() * sizeof(OamEntry)));
+        return ContentHash::Of(frames[frame].duration, hash);
+    });
+}
+
+ContentHash AssetHashes::Get(const SpriteDataHandle spriteData)
+{
+    const std::vector<SpriteData>& sprites = Parser::sprites.Get(spriteData);
+
+    return Resolve(m_SpriteData, spriteData.index, spriteData.generation, sprites.size(), sprites.size(), [&sprites](const size_t i)
+    {
+        const SpriteData& sprite = sprites[i];
+        return ContentHash::Of(sprite.id, ContentHash::Of(static_cast<uint64_t>(sprite.x | sprite.y << 8 | sprite.part << 16)));
+    });
+}
+
+ContentHash AssetHashes::Get(const CollisionTableHandle collisionTable)
+{
+    const CollisionTable& table = Parser::collisionTables.Get(collisionTable);
+
+    return Resolve(m_CollisionTables, collisionTable.index, collisionTable.generation, table.size(), table.size(), [&table](const size_t tile)
+    {
+        return ContentHash::Of(table[tile]);
+    });
+}
+
+void AssetHashes::OnChange(const ChangeEvent& event)
+{
+    switch (event.type)
+    {
+        case ChangeType::Graphics: MarkDirty(m_Graphics, event.target, event.x0, event.x1); break;
+        case ChangeType::Tilemap: MarkDirty(m_Tilemaps, event.target, event.y0, event.y1); break;
+        case ChangeType::Animation: MarkDirty(m_Animations, event.target, 0, ChangeEvent::All); break;
+        case ChangeType::SpriteData: MarkDirty(m_SpriteData, event.target, 0, ChangeEvent::All); break;
+        case ChangeType::CollisionTable: MarkDirty(m_CollisionTables, event.target, 0, ChangeEvent::All); break;
+        default: break;
+    }
+}
+
+void AssetHashes::MarkDirty(std::vector<Tree>& trees, const uint32_t index, const size_t first, const size_t last)
+{
+    if (index >= trees.size() || !trees[index].valid)
+        return;
+
+    Tree& tree = trees[index];
+
+    // Rebuilding is cheaper than walking up from most of the leaves, this also covers edits changing the leaf count
+    if (last >= tree.leafCount || tree.dirtyLeaves.size() + last - first >= tree.leafCount / 2)
+    {
+        tree.valid = false;
+        tree.dirtyLeaves.clear();
+        return;
+    }
+
+    for (size_t leaf = first; leaf <= last; leaf++)
+        tree.dirtyLeaves.push_back(leaf);
+}
+
+ContentHash AssetHashes::Resolve(std::vector<Tree>& trees, const uint32_t index, const uint32_t generation, const size_t leafCount, const size_t size,
+    const std::function<ContentHash(size_t)>& hashLeaf)
+{
+    if (index >= trees.size())
+        trees.resize(index + 1);
+
+    Tree& tree = trees[index];
+    const size_t firstLeaf = std::bit_ceil(std::max<size_t>(leafCount, 1));
+
+    if (!tree.valid || tree.generation != generation || tree.leafCount != leafCount)
+    {
+        tree.nodes.assign(firstLeaf * 2, ContentHash());
+
+        for (size_t leaf = 0; leaf < leafCount; leaf++)
+            tree.nodes[firstLeaf + leaf] = hashLeaf(leaf);
+
+        for (size_t node = firstLeaf - 1; node > 0; node--)
+            tree.nodes[node] = ContentHash::Combine(tree.nodes[node * 2], tree.nodes[node * 2 + 1]);
+
+        tree.valid = true;
+        tree.generation = generation;
+        tree.leafCount = leafCount;
+        tree.dirtyLeaves.clear();
+    }
+    else if (!tree.dirtyLeaves.empty())
+    {
+        std::ranges::sort(tree.dirtyLeaves);
+        tree.dirtyLeaves.erase(std::ranges::unique(tree.dirtyLeaves).begin(), tree.dirtyLeaves.end());
+
+        for (const size_t leaf : tree.dirtyLeaves)
+        {
+            size_t node = firstLeaf + leaf;
+            tree.nodes[node] = hashLeaf(leaf);
+
+            for (node /= 2; node > 0; node /= 2)
+                tree.nodes[node] = ContentHash::Combine(tree.nodes[node * 2], tree.nodes[node * 2 + 1]);
+        }
+
+        tree.dirtyLeaves.clear();
+    }
+
+    return ContentHash::Of(size, ContentHash::Of(leafCount, tree.nodes[1]));
+}
@@ -0,0 +1,152 @@
+﻿#include "change_bus.hpp"
+
+#include <algorithm>
+
+ChangeEvent ChangeEvent::GraphicsTiles(const GraphicsHandle graphics, const size_t first, const size_t last)
+{
+    return { ChangeType::Graphics, graphics.index, static_cast<uint16_t>(std::min<size_t>(first, All)), 0,
+        static_cast<uint16_t>(std::min<size_t>(last, All)), 0 };
+}
+
+ChangeEvent ChangeEvent::TilemapRect(const TilemapHandle tilemap, const size_t x0, const size_t y0, const size_t x1, const size_t y1)
+{
+    return { ChangeType::Tilemap, tilemap.index, static_cast<uint16_t>(std::min<size_t>(x0, All)), static_cast<uint16_t>(std::min<size_t>(y0, All)),
+        static_cast<uint16_t>(std::min<size_t>(x1, All)), static_cast<uint16_t>(std::min<size_t>(y1, All)) };
+}
+
+ChangeEvent ChangeEvent::Door(const size_t doorId)
+{
+    return { ChangeType::Door, static_cast<uint32_t>(doorId) };
+}
+
+ChangeEvent ChangeEvent::RoomPalette(const size_t roomId)
+{
+    return { ChangeType::RoomPalette, static_cast<uint32_t>(roomId) };
+}
+
+ChangeEvent ChangeEvent::SpriteData(const SpriteDataHandle spriteData)
+{
+    return { ChangeType::SpriteData, spriteData.index };
+}
+
+ChangeEvent ChangeEvent::Animation(const AnimationHandle animation)
+{
+    return { ChangeType::Animation, animation.index };
+}
+
+ChangeEvent ChangeEvent::CollisionTable(const CollisionTableHandle collisionTable)
+{
+    return { ChangeType::CollisionTable, collisionTable.index };
+}
+
+size_t ChangeBus::Subscribe(ChangeCallback callback, const uint32_t typeMask)
+{
+    // Reuse the slot of a previous subscriber if possible, so the ids stay valid
+    for (size_t i = 0; i < m_Subscribers.size(); i++)
+    {
+        if (!m_Subscribers[i].callback)
+        {
+            m_Subscribers[i] = { std::move(callback), typeMask };
+            return i;
+        }
+    }
+
+    m_Subscribers.emplace_back(std::move(callback), typeMask);
+    return m_Subscribers.size() - 1;
+}
+
+void ChangeBus::Unsubscribe(const size_t subscription)
+{
+    if (subscription < m_Subscribers.size())
+        m_Subscribers[subscription].callback = nullptr;
+}
+
+void ChangeBus::Publish(const ChangeEvent& event)
+{
+    if (m_BatchDepth != 0)
+    {
+        Merge(m_Batches[m_BatchDepth - 1], event);
+        return;
+    }
+
+    if (m_Pending.capacity() == 0)
+    {
+        m_Pending.reserve(InitialCapacity);
+        m_Delivering.reserve(InitialCapacity);
+    }
+
+    Merge(m_Pending, event);
+}
+
+void ChangeBus::Flush()
+{
+    if (m_Pending.empty())
+        return;
+
+    // Listeners may publish while being notified, those events go to the next frame
+    std::swap(m_Pending, m_Delivering);
+
+    for (const ChangeEvent& event : m_Delivering)
+    {
+        // Indices, a listener may subscribe another one while being notified
+        for (size_t i = 0; i < m_Subscribers.size(); i++)
+        {
+            const Subscriber& subscriber = m_Subscribers[i];
+            if (!subscriber.callback || (subscriber.typeMask != 0 && !(subscriber.typeMask & MaskOf(event.type))))
+                continue;
+
+            // Subscribing may move the subscribers, the callback has to outlive the call
+            const ChangeCallback callback = subscriber.callback;
+            callback(event);
+        }
+    }
+
+    m_Delivering.clear();
+}
+
+void ChangeBus::BeginBatch()
+{
+    if (m_BatchDepth == m_Batches.size())
+        m_Batches.emplace_back();
+
+    std::vector<ChangeEvent>& batch = m_Batches[m_BatchDepth++];
+    batch.clear();
+    batch.reserve(InitialCapacity);
+}
+
+void ChangeBus::CommitBatch(std::vector<ChangeEvent>& events)
+{
+    events.clear();
+
+    if (m_BatchDepth == 0)
+        return;
+
+    std::swap(events, m_Batches[--m_BatchDepth]);
+
+    for (const ChangeEvent& event : events)
+        Publish(event);
+}
+
+void ChangeBus::DiscardBatch()
+{
+    if (m_BatchDepth != 0)
+        m_Batches[--m_BatchDepth].clear();
+}
+
+void ChangeBus::Merge(std::vector<ChangeEvent>& events, const ChangeEvent& event)
+{
+    // Only a few targets change in a frame, so a linear search is enough to merge with a previous event
+    for (ChangeEvent& pending : events)
+    {
+        if (pending.type != event.type || pending.target != event.target)
+            continue;
+
+        pending.x0 = std::min(pending.x0, event.x0);
+        pending.y0 = std::min(pending.y0, event.y0);
+        pending.x1 = std::max(pending.x1, event.x1);
+        pending.y1 = std::max(pending.y1, event.y1);
+        return;
+    }
+
+    events.push_back(event);
+}
@@ -0,0 +1,230 @@
+﻿#include "collision_grid.hpp"
+
+#include <algorithm>
+#include <ranges>
+
+std::vector<std::string> CollisionGrid::GetUsedValues() const
+{
+    std::vector<bool_t> used(values.size(), false);
+    for (const uint8_t cell : cells)
+        used[cell] = true;
+
+    std::vector<std::string> result;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        if (used[i])
+            result.push_back(values[i]);
+    }
+
+    return result;
+}
+
+uint8_t CollisionGrid::GetBitsPerTile(const size_t valueCount)
+{
+    if (valueCount <= 4)
+        return 2;
+
+    if (valueCount <= 16)
+        return 4;
+
+    return 8;
+}
+
+std::vector<uint8_t> CollisionGrid::Pack(const std::vector<std::string>& usedValues) const
+{
+    const uint8_t bits = GetBitsPerTile(usedValues.size());
+    const size_t tilesPerByte = 8 / bits;
+
+    std::vector<uint8_t> remap(values.size(), 0);
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        const std::vector<std::string>::const_iterator it = std::ranges::find(usedValues, values[i]);
+        if (it != usedValues.end())
+            remap[i] = static_cast<uint8_t>(it - usedValues.begin());
+    }
+
+    // The first tile of each byte is stored in the highest bits
+    std::vector<uint8_t> packed((cells.size() + tilesPerByte - 1) / tilesPerByte, 0);
+    for (size_t i = 0; i < cells.size(); i++)
+    {
+        const size_t shift = 8 - bits * (i % tilesPerByte + 1);
+        packed[i / tilesPerByte] |= static_cast<uint8_t>(remap[cells[i]] << shift);
+    }
+
+    return packed;
+}
+
+const CollisionGrid& CollisionGridCache::Get(const size_t roomId)
+{
+    if (m_Grids.size() != Parser::rooms.size())
+        InvalidateAll();
+
+    const Room& room = Parser::rooms[roomId];
+    const CollisionGrid& grid = m_Grids[roomId];
+
+    // The room was pointed to another tilemap or collision table since the grid was built
+    if (grid.tilemap != room.tilemap)
+        IndexRooms();
+
+    if (m_Dirty[roomId] || grid.tilemap != room.tilemap || grid.collisionTable != GetCollisionTable(room))
+        Rebuild(roomId);
+
+    return m_Grids[roomId];
+}
+
+void CollisionGridCache::UpdateTile(const TilemapHandle tilemap, const size_t x, const size_t y)
+{
+    const std::unordered_map<uint32_t, std::vector<size_t>>::const_iterator rooms = m_TilemapRooms.find(tilemap.index);
+    if (rooms == m_TilemapRooms.end())
+        return;
+
+    const Tilemap& tiles = Parser::tilemaps.Get(tilemap);
+
+    for (const size_t i : rooms->second)
+    {
+        if (i >= m_Grids.size() || m_Dirty[i] || Parser::rooms[i].tilemap != tilemap || m_Grids[i].tilemap != tilemap)
+            continue;
+
+        CollisionGrid& grid = m_Grids[i];
+        if (x >= grid.width || y >= grid.height)
+        {
+            m_Dirty[i] = true;
+            continue;
+        }
+
+        const Room& room = Parser::rooms[i];
+        const std::string& clipdata = GetClipdata(Parser::collisionTables.Get(GetCollisionTable(room)), tiles[y][x]);
+
+        std::vector<std::string>::const_iterator it = std::ranges::find(grid.values, clipdata);
+        if (it == grid.values.end())
+        {
+            grid.values.push_back(clipdata);
+            it = grid.values.end() - 1;
+        }
+
+        grid.cells[y * grid.width + x] = static_cast<uint8_t>(it - grid.values.begin());
+    }
+}
+
+void CollisionGridCache::InvalidateTilemap(const TilemapHandle tilemap)
+{
+    const std::unordered_map<uint32_t, std::vector<size_t>>::const_iterator rooms = m_TilemapRooms.find(tilemap.index);
+    if (rooms == m_TilemapRooms.end())
+        return;
+
+    for (const size_t i : rooms->second)
+    {
+        if (i < m_Dirty.size())
+            m_Dirty[i] = true;
+    }
+}
+
+void CollisionGridCache::InvalidateCollisionTable(const CollisionTableHandle collisionTable)
+{
+    for (size_t i = 0; i < m_Grids.size(); i++)
+    {
+        if (GetCollisionTable(Parser::rooms[i]) == collisionTable)
+            m_Dirty[i] = true;
+    }
+}
+
+void CollisionGridCache::InvalidateAll()
+{
+    m_Grids.resize(Parser::rooms.size());
+    m_Dirty.assign(Parser::rooms.size(), true);
+    IndexRooms();
+
+    if (m_Subscription == NoSubscription)
+        m_Subscription = ChangeBus::Subscribe(OnChange, ChangeBus::MaskOf(ChangeType::CollisionTable));
+}
+
+void CollisionGridCache::SetExport(const bool_t value)
+{
+    m_Export = value;
+
+    if (!m_Export)
+        return;
+
+    // The grids are put next to the tilemap of their room
+    for (size_t i = 0; i < Parser::rooms.size(); i++)
+    {
+        const std::string symbolName = GetSymbolName(i);
+        if (Parser::symbols.Contains(symbolName))
+            continue;
+
+        const std::string file = Parser::GetSymbolFile(Parser::tilemaps.GetName(Parser::rooms[i].tilemap));
+        if (!file.empty())
+            Parser::RegisterSymbol(file, symbolName, SymbolType::CollisionGrid);
+    }
+}
+
+std::string CollisionGridCache::GetSymbolName(const size_t roomId)
+{
+    std::string name = Parser::tilemaps.GetName(Parser::rooms[roomId].tilemap);
+
+    if (name.ends_with("_Tilemap"))
+        name.resize(name.size() - sizeof("_Tilemap") + 1);
+
+    return name + "_CollisionGrid";
+}
+
+void CollisionGridCache::OnChange(const ChangeEvent& event)
+{
+    // Covers the edits made by undo and redo, or by any other editor than the collision table one
+    for (size_t i = 0; i < m_Grids.size(); i++)
+    {
+        if (GetCollisionTable(Parser::rooms[i]).index == event.target)
+            m_Dirty[i] = true;
+    }
+}
+
+void CollisionGridCache::IndexRooms()
+{
+    m_TilemapRooms.clear();
+
+    for (size_t i = 0; i < Parser::rooms.size(); i++)
+        m_TilemapRooms[Parser::rooms[i].tilemap.index].push_back(i);
+}
+
+void CollisionGridCache::Rebuild(const size_t roomId)
+{
+    const Room& room = Parser::rooms[roomId];
+    const Tilemap& tilemap = Parser::tilemaps.Get(room.tilemap);
+    const CollisionTable& collisionTable = Parser::collisionTables.Get(GetCollisionTable(room));
+
+    CollisionGrid& grid = m_Grids[roomId];
+    grid.tilemap = room.tilemap;
+    grid.collisionTable = GetCollisionTable(room);
+    grid.width = static_cast<uint8_t>(tilemap.GetWidth());
+    grid.height = static_cast<uint8_t>(tilemap.GetHeight());
+    grid.values.clear();
+    grid.cells.clear();
+
+    // Both are row-major, so the cells follow the order of the tiles
+    for (const uint8_t tile : tilemap.GetTiles())
+    {
+        const std::string& clipdata = GetClipdata(collisionTable, tile);
+
+        std::vector<std::string>::const_iterator it = std::ranges::find(grid.values, clipdata);
+        if (it == grid.values.end())
+        {
+            grid.values.push_back(clipdata);
+            it = grid.values.end() - 1;
+        }
+
+        grid.cells.push_back(static_cast<uint8_t>(it - grid.values.begin()));
+    }
+
+    m_Dirty[roomId] = false;
+}
+
+CollisionTableHandle CollisionGridCache::GetCollisionTable(const Room& room)
+{
+    return room.collisionTable < Parser::collisionTableArray.size() ? Parser::collisionTableArray[room.collisionTable] : CollisionTableHandle();
+}
+
+const std::string& CollisionGridCache::GetClipdata(const CollisionTable& collisionTable, const uint8_t tile)
+{
+    static const std::string air = "CLIPDATA_AIR";
+    return tile < collisionTable.size() ? collisionTable[tile] : air;
+}
@@ -0,0 +1,60 @@
+﻿#include "content_hash.hpp"
+
+#include <bit>
+#include <cstring>
+
+ContentHash ContentHash::Of(const std::span<const uint8_t> data, const ContentHash seed)
+{
+    constexpr uint64_t prime0 = 0x9E3779B97F4A7C15ull;
+    constexpr uint64_t prime1 = 0xC2B2AE3D27D4EB4Full;
+
+    // Two lanes with different multipliers, each one sees every word
+    uint64_t low = seed.low ^ data.size() * prime0;
+    uint64_t high = seed.high ^ std::rotl(data.size() * prime1, 29);
+
+    size_t offset = 0;
+    for (; offset + sizeof(uint64_t) <= data.size(); offset += sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, data.data() + offset, sizeof(word));
+
+        low = std::rotl(low ^ word * prime1, 31) * prime0;
+        high = std::rotl(high ^ word * prime0, 27) * prime1;
+    }
+
+    if (offset < data.size())
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, data.data() + offset, data.size() - offset);
+
+        low = std::rotl(low ^ word * prime1, 31) * prime0;
+        high = std::rotl(high ^ word * prime0, 27) * prime1;
+    }
+
+    return { Mix(low ^ high >> 17), Mix(high + low) };
+}
+
+ContentHash ContentHash::Of(const std::string& value, const ContentHash seed)
+{
+    return Of(std::span(reinterpret_cast<const uint8_t*>(value.data()), value.size()), seed);
+}
+
+ContentHash ContentHash::Of(const uint64_t value, const ContentHash seed)
+{
+    return Of(std::span(reinterpret_cast<const uint8_t*>(&value), sizeof(value)), seed);
+}
+
+ContentHash ContentHash::Combine(const ContentHash& left, const ContentHash& right)
+{
+    return { Mix(left.low ^ (std::rotl(right.low, 23) + right.high)), Mix((left.high + std::rotl(right.high, 41)) ^ right.low) };
+}
+
+uint64_t ContentHash::Mix(uint64_t value)
+{
+    // Finalizer of splitmix64
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ull;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBull;
+    return value ^ value >> 31;
+}
@@ -4,6 +4,9 @@
 #include <ranges>
 
 #include "application.hpp"
+#include "change_bus.hpp"
+#include "reference_index.hpp"
+#include "transaction.hpp"
 #include "imgui/imgui_stdlib.h"
 #include "magic_enum/magic_enum.hpp"
 
@@ -39,7 +42,7 @@ void AddResource::NormalSymbolFields()
 
     const bool_t fileExists = std::filesystem::exists(m_FullFilePath) && std::filesystem::is_regular_file(m_FullFilePath);
 
-    const bool_t symbolAlreadyExists = std::ranges::contains(Parser::existingSymbols, m_SymbolName);
+    const bool_t symbolAlreadyExists = Parser::symbols.Contains(m_SymbolName);
     const bool_t symbolPrefix = m_SymbolName[0] == 's';
     const bool_t nameValid = !m_SymbolName.empty() && symbolPrefix && !symbolAlreadyExists;
 
@@ -66,11 +69,11 @@ void AddResource::RoomFields()
     ImGui::SameLine();
     ImGui::Text("%d", static_cast<int32_t>(Parser::rooms.size()));
 
-    if (ImGui::BeginCombo("Collision table", Parser::collisionTableArray[m_RoomCollisionTable].c_str()))
+    if (ImGui::BeginCombo("Collision table", Parser::collisionTables.GetName(Parser::collisionTableArray[m_RoomCollisionTable]).c_str()))
     {
         for (size_t i = 0; i < Parser::collisionTableArray.size(); i++)
         {
-            if (ImGui::MenuItem(Parser::collisionTableArray[i].c_str()))
+            if (ImGui::MenuItem(Parser::collisionTables.GetName(Parser::collisionTableArray[i]).c_str()))
                 m_RoomCollisionTable = i;
         }
 
@@ -114,6 +117,8 @@ void AddResource::CreateResource() const
         case SymbolType::Doors:
         case SymbolType::Tilesets:
         case SymbolType::CollisionTableArray:
+        case SymbolType::Metatiles:
+        case SymbolType::CollisionGrid:
             return;
     }
 
@@ -122,8 +127,7 @@ void AddResource::CreateResource() const
 
 void AddResource::CreateGraphics() const
 {
-    const std::vector<uint8_t> dummyGraphics(16);
-    Parser::graphics[m_SymbolName] = dummyGraphics;
+    Parser::graphics.Add(m_SymbolName, Graphics(1));
 }
 
 void AddResource::CreateAnimation() const
@@ -131,17 +135,14 @@ void AddResource::CreateAnimation() const
     Animation dummyAnimation(1);
     dummyAnimation[0].oam.emplace_back(0, 0, 0, 0);
     dummyAnimation[0].duration = 60;
-    Parser::animations[m_SymbolName] = dummyAnimation;
+    ReferenceIndex::UpdateAnimation(Parser::animations.Add(m_SymbolName, dummyAnimation));
 }
 
 void AddResource::CreateCollisionTable() const
 {
     const std::string sourceFile = Application::projectPath + R"(\src\data\collision_tables.c)";
 
-    Parser::collisionTables[m_SymbolName] = {};
-    Parser::collisionTables[m_SymbolName].emplace_back("CLIPDATA_AIR");
-
-    Parser::collisionTableArray.push_back(m_SymbolName);
+    Parser::collisionTableArray.push_back(Parser::collisionTables.Add(m_SymbolName, { "CLIPDATA_AIR" }));
     Parser::RegisterSymbol(sourceFile, m_SymbolName, SymbolType::CollisionTable);
 
     RegenerateCollisionTableIncludeFile();
@@ -149,29 +150,42 @@ void AddResource::CreateCollisionTable() const
 
 void AddResource::CreateRoom() const
 {
-    const std::string roomIndex = std::to_string(Parser::rooms.size());
+    const size_t roomId = Parser::rooms.size();
+    const std::string roomIndex = std::to_string(roomId);
     const std::string sourceFile = Application::projectPath + R"(\src\data\rooms\room)" + roomIndex + ".c";
 
-    CreateRoomHeaderFile();
+    // The room spans several stores and files, it is created at once or not at all
+    Transaction transaction("Add room");
 
     const std::string tilemapName = std::string("sRoom") + roomIndex + "_Tilemap";
-    Tilemap dummyTilemap;
-    dummyTilemap.emplace_back(1);
-    Parser::tilemaps[tilemapName] = dummyTilemap;
+    const TilemapHandle tilemap = Parser::tilemaps.Add(tilemapName, Tilemap(1, 1));
     Parser::RegisterSymbol(sourceFile, tilemapName, SymbolType::Tilemap);
 
     const std::string spriteDataName = std::string("sRoom") + roomIndex + "_SpriteData";
-    Parser::sprites[spriteDataName] = {};
+    const SpriteDataHandle spriteData = Parser::sprites.Add(spriteDataName, {});
     Parser::RegisterSymbol(sourceFile, spriteDataName, SymbolType::SpriteData);
 
     const std::string doorDataName = std::string("sRoom") + roomIndex + "_DoorData";
-    Parser::roomsDoorData[doorDataName] = {};
+    const DoorDataHandle doorData = Parser::roomsDoorData.Add(doorDataName, {});
     Parser::RegisterSymbol(sourceFile, doorDataName, SymbolType::DoorData);
 
     constexpr Palette dummyPalette = { White, LightGrey, DarkGrey, Black };
-    Parser::rooms.emplace_back(tilemapName, dummyPalette, spriteDataName, doorDataName, m_RoomCollisionTable);
+    Parser::rooms.emplace_back(tilemap, dummyPalette, spriteData, doorData, m_RoomCollisionTable);
+    ReferenceIndex::AddRoom(Parser::rooms.size() - 1);
+
+    ChangeBus::Publish(ChangeEvent::TilemapRect(tilemap));
+    ChangeBus::Publish(ChangeEvent::SpriteData(spriteData));
+    ChangeBus::Publish(ChangeEvent::RoomPalette(Parser::rooms.size() - 1));
+
+    // Undoing leaves the header of the room, the include file no longer lists it
+    transaction.Defer([roomId, roomIndex]
+    {
+        if (roomId < Parser::rooms.size())
+            CreateRoomHeaderFile(roomIndex);
+        RegenerateRoomIncludeFile();
+    });
 
-    RegenerateRoomIncludeFile();
+    transaction.Commit(m_ActionQueue);
 }
 
 void AddResource::RegenerateRoomIncludeFile()
@@ -191,9 +205,8 @@ void AddResource::RegenerateRoomIncludeFile()
     file.close();
 }
 
-void AddResource::CreateRoomHeaderFile()
+void AddResource::CreateRoomHeaderFile(const std::string& roomIndex)
 {
-    const std::string roomIndex = std::to_string(Parser::rooms.size());
     const std::string headerFile = Application::projectPath + R"(\include\data\rooms\room)" + roomIndex + ".h";
 
     std::ofstream file;
@@ -216,8 +229,8 @@ void AddResource::RegenerateCollisionTableIncludeFile()
 
     file << "#ifndef COLLISION_TABLES_H\n#define COLLISION_TABLES_H\n\n#include \"types.h\"\n\n";
 
-    for (const std::string& collisionTable : Parser::collisionTableArray)
-        file << "extern const u8 " << collisionTable << "[];\n";
+    for (const CollisionTableHandle collisionTable : Parser::collisionTableArray)
+        file << "extern const u8 " << Parser::collisionTables.GetName(collisionTable) << "[];\n";
 
     file << "extern const u8* const sCollisionTables[];\n";
 
@@ -4,7 +4,10 @@
 #include <iostream>
 #include <ranges>
 
+#include "change_bus.hpp"
+#include "oam_profiler.hpp"
 #include "parser.hpp"
+#include "reference_index.hpp"
 #include "ui.hpp"
 
 AnimationEditor::AnimationEditor()
@@ -21,13 +24,18 @@ AnimationEditor::AnimationEditor()
     m_GraphicsRenderTarget.scale = 4;
 }
 
+void AnimationEditor::GetView(std::vector<AssetTag>& view) const
+{
+    view.emplace_back(ChangeType::Animation, m_SelectedAnimation.index);
+}
+
 void AnimationEditor::Update()
 {
     ImGui::SeparatorText("Selection");
     DrawAnimationSelector();
     DrawGraphicsSelector();
 
-    if (m_SelectedAnimation == "<None>" || m_SelectedGraphics == "<None>")
+    if (!Parser::animations.IsValid(m_SelectedAnimation) || !Parser::graphics.IsValid(m_SelectedGraphics))
         return;
 
     Ui::CreateSubWindow("options", ImGuiChildFlags_ResizeX | ImGuiChildFlags_AutoResizeY, ImVec2(ImGui::GetContentRegionAvail().x / 2, 0));
@@ -48,7 +56,7 @@ void AnimationEditor::Update()
     ImGui::EndGroup();
 }
 
-void AnimationEditor::Setup(const std::string& animation, const std::string& graphics)
+void AnimationEditor::Setup(const AnimationHandle animation, const GraphicsHandle graphics)
 {
     m_SelectedAnimation = animation;
     m_SelectedGraphics = graphics;
@@ -56,13 +64,14 @@ void AnimationEditor::Setup(const std::string& animation, const std::string& gra
 
 void AnimationEditor::DrawAnimationSelector()
 {
-    if (!ImGui::BeginCombo("Animation", m_SelectedAnimation.c_str()))
+    if (!ImGui::BeginCombo("Animation", Parser::animations.GetName(m_SelectedAnimation).c_str()))
         return;
 
-    for (const std::string& s : Parser::animations | std::ranges::views::keys)
+    // Listed by name, the order of the handles is the order the files were parsed in
+    for (const std::string& symbolName : Parser::symbols.GetSymbols(SymbolType::Animation))
     {
-        if (ImGui::MenuItem(s.c_str()))
-            m_SelectedAnimation = s;
+        if (ImGui::MenuItem(symbolName.c_str()))
+            m_SelectedAnimation = Parser::animations.Find(symbolName);
     }
 
     ImGui::EndCombo();
@@ -70,17 +79,17 @@ void AnimationEditor::DrawAnimationSelector()
 
 void AnimationEditor::DrawGraphicsSelector()
 {
-    if (!ImGui::BeginCombo("Graphics", m_SelectedGraphics.c_str()))
+    if (!ImGui::BeginCombo("Graphics", Parser::graphics.GetName(m_SelectedGraphics).c_str()))
         return;
 
-    for (const std::string& s : Parser::graphics | std::ranges::views::keys)
+    for (const std::string& symbolName : Parser::symbols.GetSymbols(SymbolType::Graphics))
     {
-        if (ImGui::MenuItem(s.c_str()))
+        if (ImGui::MenuItem(symbolName.c_str()))
         {
-            m_SelectedGraphics = s;
+            m_SelectedGraphics = Parser::graphics.Find(symbolName);
             
-            const Graphics& gfx = Parser::graphics[s];
-            const size_t tileMax = gfx.size() / 16;
+            const Graphics& gfx = Parser::graphics.Get(m_SelectedGraphics);
+            const size_t tileMax = gfx.size();
             m_GraphicsRenderTarget.SetSize(16 * 8, static_cast<int32_t>((1 + tileMax / 16) * 8));
         }
     }
@@ -97,6 +106,8 @@ void AnimationEditor::DrawPlaybackControls()
         renderTarget.scale = m_OamPixelSize;
     
     ImGui::Checkbox("Draw origin", &m_DrawOrigin);
+    ImGui::SameLine();
+    ImGui::Checkbox("Scanline heatmap", &m_DrawScanlines);
 
     if (ImGui::Button(m_Playing ? "Stop" : "Play"))
     {
@@ -113,7 +124,7 @@ void AnimationEditor::DrawFrameInfo()
     ImGui::PushID("Frame");
 
     constexpr uint8_t zero = 0;
-    Animation& animation = Parser::animations[m_SelectedAnimation];
+    Animation& animation = *Parser::animations.GetMutable(m_SelectedAnimation);
     const uint8_t nbrFrames = static_cast<uint8_t>(animation.size() - 1);
 
     ImGui::SliderScalar("Current frame", ImGuiDataType_U8, &m_CurrentFrame, &zero, &nbrFrames);
@@ -122,6 +133,7 @@ void AnimationEditor::DrawFrameInfo()
     if (ImGui::Button("+"))
     {
         animation.insert(animation.begin() + m_CurrentFrame, AnimationFrame{})->oam.emplace_back();
+        OnAnimationEdited();
     }
     ImGui::EndDisabled();
 
@@ -131,13 +143,15 @@ void AnimationEditor::DrawFrameInfo()
     if (ImGui::Button("-"))
     {
         animation.erase(animation.begin() + m_CurrentFrame);
+        OnAnimationEdited();
 
         if (m_CurrentFrame == nbrFrames)
             m_CurrentFrame--;
     }
     ImGui::EndDisabled();
 
-    ImGui::InputScalar("Duration", ImGuiDataType_U8, &animation[m_CurrentFrame].duration);
+    if (ImGui::InputScalar("Duration", ImGuiDataType_U8, &animation[m_CurrentFrame].duration))
+        OnAnimationEdited();
     ImGui::PopID();
 }
 
@@ -147,12 +161,15 @@ void AnimationEditor::DrawPartInfo()
     ImGui::PushID("Part");
 
     constexpr uint8_t zero = 0;
-    Animation& animation = Parser::animations[m_SelectedAnimation];
+    Animation& animation = *Parser::animations.GetMutable(m_SelectedAnimation);
     std::vector<OamEntry>& entries = animation[m_CurrentFrame].oam;
 
     ImGui::BeginDisabled(entries.size() == 10);
     if (ImGui::Button("+"))
+    {
         entries.insert(entries.begin() + m_SelectedPart, OamEntry{});
+        OnAnimationEdited();
+    }
     ImGui::EndDisabled();
 
     ImGui::SameLine();
@@ -160,6 +177,7 @@ void AnimationEditor::DrawPartInfo()
     if (ImGui::Button("-"))
     {
         entries.erase(entries.begin() + m_SelectedPart);
+        OnAnimationEdited();
 
         if (m_SelectedPart == entries.size())
             m_SelectedPart--;
@@ -173,14 +191,14 @@ void AnimationEditor::DrawPartInfo()
     
     OamEntry& entry = entries[m_SelectedPart];
 
-    ImGui::DragScalar("Y", ImGuiDataType_S8, &entry.y);
-    ImGui::DragScalar("X", ImGuiDataType_S8, &entry.x);
-    ImGui::DragScalar("Tile", ImGuiDataType_U8, &entry.tileIndex);
+    bool_t changed = ImGui::DragScalar("Y", ImGuiDataType_S8, &entry.y);
+    changed |= ImGui::DragScalar("X", ImGuiDataType_S8, &entry.x);
+    changed |= ImGui::DragScalar("Tile", ImGuiDataType_U8, &entry.tileIndex);
 
-    const std::function<void(const char_t*, uint8_t)> editField = [&entry](const char_t* const label, const uint8_t flag) -> void
+    const std::function<void(const char_t*, uint8_t)> editField = [&entry, &changed](const char_t* const label, const uint8_t flag) -> void
     {
         bool_t value = entry.properties & flag; 
-        ImGui::Checkbox(label, &value);
+        changed |= ImGui::Checkbox(label, &value);
         if (value)
             entry.properties |= flag;
         else
@@ -195,23 +213,31 @@ void AnimationEditor::DrawPartInfo()
     ImGui::SameLine();
     editField("Palette", 1u << 4);
 
+    if (changed)
+        OnAnimationEdited();
+
     ImGui::PopID();
 }
 
-void AnimationEditor::DrawGraphics()
+void AnimationEditor::OnAnimationEdited() const
 {
-    const Graphics& graphics = Parser::graphics[m_SelectedGraphics];
+    ReferenceIndex::SetAnimationGraphics(m_SelectedAnimation, m_SelectedGraphics);
+    ReferenceIndex::UpdateAnimation(m_SelectedAnimation);
+    ChangeBus::Publish(ChangeEvent::Animation(m_SelectedAnimation));
+}
 
+void AnimationEditor::DrawGraphics()
+{
     Ui::CreateSubWindow("graphics", ImGuiChildFlags_ResizeX | ImGuiChildFlags_ResizeY);
     ImGui::SliderFloat("Zoom", &m_GraphicsRenderTarget.scale, 4, 16);
-    Ui::DrawGraphics(m_GraphicsRenderTarget, graphics, m_ColorPalette, &m_SelectedTile);
+    Ui::DrawGraphics(m_GraphicsRenderTarget, m_SelectedGraphics, m_ColorPalette, &m_SelectedTile);
     ImGui::EndChild();
 }
 
 void AnimationEditor::DrawOam()
 {
-    const Graphics& graphics = Parser::graphics[m_SelectedGraphics];
-    const Animation& animation = Parser::animations[m_SelectedAnimation];
+    const Graphics& graphics = Parser::graphics.Get(m_SelectedGraphics);
+    const Animation& animation = Parser::animations.Get(m_SelectedAnimation);
 
     Ui::CreateSubWindow("oam", ImGuiChildFlags_ResizeX | ImGuiChildFlags_ResizeY);
 
@@ -229,10 +255,10 @@ void AnimationEditor::DrawOam()
         const OamEntry& entry = animation[m_CurrentFrame].oam[i];
         const ImVec2 position = ImVec2(entry.x * m_OamPixelSize, entry.y * m_OamPixelSize);
 
-        if (entry.tileIndex < graphics.size() / 16)
+        if (entry.tileIndex < graphics.size())
         {
             ImGui::SetCursorPos(ImVec2(middle.x + position.x, middle.y + position.y));
-            Ui::DrawTile(m_SpriteRenderTargets[i], graphics, entry.tileIndex, m_ColorPalette, entry.properties & 1u << 5, entry.properties & 1u << 6);
+            Ui::DrawTile(m_SpriteRenderTargets[i], m_SelectedGraphics, entry.tileIndex, m_ColorPalette, entry.properties & 1u << 5, entry.properties & 1u << 6);
 
             if (ImGui::IsItemClicked())
                 m_SelectedPart = i;
@@ -248,15 +274,44 @@ void AnimationEditor::DrawOam()
     const ImVec2 p2 = ImVec2(p1.x + 8 * m_OamPixelSize, p1.y + 8 * m_OamPixelSize);
     ImGui::GetWindowDrawList()->AddRect(p1, p2, IM_COL32(0xFF, 0x00, 0x00, 0xFF));
 
+    if (m_DrawScanlines)
+        DrawScanlineHeatmap(middleAbs);
+
     ImGui::EndChild();
 }
 
+void AnimationEditor::DrawScanlineHeatmap(const ImVec2 origin) const
+{
+    const ScanlineProfile profile = OamProfiler::ProfileFrame(Parser::animations.Get(m_SelectedAnimation)[m_CurrentFrame]);
+
+    ImDrawList* const dl = ImGui::GetWindowDrawList();
+    const float_t left = ImGui::GetWindowPos().x;
+    const float_t right = left + ImGui::GetWindowWidth();
+
+    for (size_t i = 0; i < profile.counts.size(); i++)
+    {
+        const size_t count = profile.counts[i];
+        const float_t y = origin.y + static_cast<float_t>(profile.top + static_cast<int32_t>(i)) * m_OamPixelSize;
+        dl->AddRectFilled(ImVec2(left, y), ImVec2(left + 2 * m_OamPixelSize, y + m_OamPixelSize), OamProfiler::GetHeatColor(count));
+
+        // Highlight the whole line when it would flicker
+        if (count > OamProfiler::MaxObjectsPerLine)
+            dl->AddRectFilled(ImVec2(left, y), ImVec2(right, y + m_OamPixelSize), IM_COL32(0xFF, 0x00, 0x00, 0x40));
+    }
+
+    const bool_t overLimit = profile.GetPeak() > OamProfiler::MaxObjectsPerLine || profile.objects > OamProfiler::MaxObjects;
+
+    ImGui::SetCursorPos(ImVec2(ImGui::GetScrollX(), ImGui::GetScrollY()));
+    const ImVec4 color = overLimit ? ImVec4(1, 0, 0, 1) : ImGui::GetStyleColorVec4(ImGuiCol_Text);
+    ImGui::TextColored(color, "%zu / %zu objects per line, %zu objects", profile.GetPeak(), OamProfiler::MaxObjectsPerLine, profile.objects);
+}
+
 void AnimationEditor::UpdatePlayback()
 {
     if (!m_Playing)
         return;
 
-    const Animation& animation = Parser::animations[m_SelectedAnimation];
+    const Animation& animation = Parser::animations.Get(m_SelectedAnimation);
 
     m_AnimationTimer++;
 
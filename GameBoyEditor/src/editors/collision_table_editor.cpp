@@ -1,8 +1,12 @@
 ﻿#include "editors/collision_table_editor.hpp"
 
+#include <algorithm>
 #include <ranges>
 
+#include "change_bus.hpp"
+#include "collision_grid.hpp"
 #include "parser.hpp"
+#include "reference_index.hpp"
 #include "ui.hpp"
 
 CollisionTableEditor::CollisionTableEditor()
@@ -13,6 +17,11 @@ CollisionTableEditor::CollisionTableEditor()
     m_TilesetRenderTarget.scale = 4;
 }
 
+void CollisionTableEditor::GetView(std::vector<AssetTag>& view) const
+{
+    view.emplace_back(ChangeType::CollisionTable, m_SelectedCollisionTable.index);
+}
+
 void CollisionTableEditor::Update()
 {
     DrawTilesetSelector();
@@ -20,7 +29,7 @@ void CollisionTableEditor::Update()
     Ui::DrawPalette(m_ColorPalette, 30.f, nullptr);
     DrawCollisionInfo();
 
-    if (m_SelectedTileset != "<None>")
+    if (Parser::graphics.IsValid(m_SelectedTileset))
     {
         ImGui::SameLine();
         DrawTileset();
@@ -29,16 +38,16 @@ void CollisionTableEditor::Update()
 
 void CollisionTableEditor::DrawTilesetSelector()
 {
-    if (ImGui::BeginCombo("Tileset", m_SelectedTileset.c_str()))
+    if (ImGui::BeginCombo("Tileset", Parser::graphics.GetName(m_SelectedTileset).c_str()))
     {
-        for (const std::string& tileset : Parser::tilesets)
+        for (const GraphicsHandle tileset : Parser::tilesets)
         {
-            if (ImGui::MenuItem(tileset.c_str()))
+            if (ImGui::MenuItem(Parser::graphics.GetName(tileset).c_str()))
             {
                 m_SelectedTileset = tileset;
 
-                const Graphics& gfx = Parser::graphics[tileset];
-                const size_t tileMax = gfx.size() / 16;
+                const Graphics& gfx = Parser::graphics.Get(m_SelectedTileset);
+                const size_t tileMax = gfx.size();
                 m_TilesetRenderTarget.SetSize(16 * 8, static_cast<int32_t>((1 + tileMax / 16) * 8));
             }
         }
@@ -53,9 +62,9 @@ void CollisionTableEditor::DrawCollisionInfo()
 
     DrawCollisionTableSelector();
 
-    if (m_SelectedCollisionTable != "<None>")
+    if (Parser::collisionTables.IsValid(m_SelectedCollisionTable))
     {
-        CollisionTable& colTable = Parser::collisionTables[m_SelectedCollisionTable];
+        const CollisionTable& colTable = Parser::collisionTables.Get(m_SelectedCollisionTable);
         for (size_t i = 0; i < colTable.size(); i++)
         {
             ImGui::PushID(&i + i);
@@ -64,7 +73,13 @@ void CollisionTableEditor::DrawCollisionInfo()
             else
                 ImGui::Text("%02zu : ", i);
             ImGui::SameLine();
-            DrawClipdataSelector(colTable[i]);
+            const std::string* const clipdata = DrawClipdataSelector(colTable[i]);
+            if (clipdata != nullptr)
+            {
+                (*Parser::collisionTables.GetMutable(m_SelectedCollisionTable))[i] = *clipdata;
+                CollisionGridCache::InvalidateCollisionTable(m_SelectedCollisionTable);
+                ChangeBus::Publish(ChangeEvent::CollisionTable(m_SelectedCollisionTable));
+            }
 
             ImGui::SameLine();
             ImGui::TextColored(m_SelectedTile == i ? ImVec4(1, 0, 0, 1) : ImVec4(0, 1, 0, 1), "X");
@@ -79,55 +94,80 @@ void CollisionTableEditor::DrawCollisionInfo()
 
 void CollisionTableEditor::DrawCollisionTableSelector()
 {
-    if (ImGui::BeginCombo("Collision table", m_SelectedCollisionTable.c_str()))
+    if (ImGui::BeginCombo("Collision table", Parser::collisionTables.GetName(m_SelectedCollisionTable).c_str()))
     {
-        for (const std::string& collisionTable : Parser::collisionTableArray)
+        for (const CollisionTableHandle collisionTable : Parser::collisionTableArray)
         {
-            if (ImGui::MenuItem(collisionTable.c_str()))
+            if (ImGui::MenuItem(Parser::collisionTables.GetName(collisionTable).c_str()))
                 m_SelectedCollisionTable = collisionTable;
         }
 
         ImGui::EndCombo();
     }
+
+    const std::vector<CollisionTableHandle>::const_iterator it = std::ranges::find(Parser::collisionTableArray, m_SelectedCollisionTable);
+    if (it == Parser::collisionTableArray.end())
+        return;
+
+    const std::vector<uint8_t>& rooms = ReferenceIndex::GetRoomsUsingCollisionTable(it - Parser::collisionTableArray.begin());
+    if (rooms.empty())
+    {
+        ImGui::TextDisabled("Not used by any room");
+        return;
+    }
+
+    std::string list;
+    for (const uint8_t roomId : rooms)
+        list += (list.empty() ? "" : ", ") + std::to_string(roomId);
+
+    ImGui::TextWrapped("Used by rooms : %s", list.c_str());
 }
 
 void CollisionTableEditor::DrawTileset()
 {
-    const Graphics& graphics = Parser::graphics[m_SelectedTileset];
+    const Graphics& graphics = Parser::graphics.Get(m_SelectedTileset);
 
     Ui::CreateSubWindow("graphicsWindow", ImGuiChildFlags_ResizeX);
 
     ImGui::SliderFloat("Zoom", &m_TilesetRenderTarget.scale, 4, 16);
 
-    const size_t tileCount = graphics.size() / 16;
-    CollisionTable& collisionTable = Parser::collisionTables[m_SelectedCollisionTable];
-    const size_t previousSize = collisionTable.size();
+    const size_t tileCount = graphics.size();
+    const bool_t validTable = Parser::collisionTables.IsValid(m_SelectedCollisionTable);
+    const size_t previousSize = validTable ? Parser::collisionTables.Get(m_SelectedCollisionTable).size() : 0;
 
-    ImGui::BeginDisabled(m_SelectedCollisionTable == "<None>" || tileCount == previousSize);
+    ImGui::BeginDisabled(!validTable || tileCount == previousSize);
     if (ImGui::Button("Resize table to fit graphics"))
     {
+        CollisionTable& collisionTable = *Parser::collisionTables.GetMutable(m_SelectedCollisionTable);
         collisionTable.resize(tileCount);
 
         for (size_t i = previousSize; i < tileCount; i++)
             collisionTable[i] = "CLIPDATA_AIR";
+
+        CollisionGridCache::InvalidateCollisionTable(m_SelectedCollisionTable);
+        ChangeBus::Publish(ChangeEvent::CollisionTable(m_SelectedCollisionTable));
     }
     ImGui::EndDisabled();
 
-    Ui::DrawGraphics(m_TilesetRenderTarget, graphics, m_ColorPalette, &m_SelectedTile);
+    Ui::DrawGraphics(m_TilesetRenderTarget, m_SelectedTileset, m_ColorPalette, &m_SelectedTile);
 
     ImGui::EndChild();
 }
 
-void CollisionTableEditor::DrawClipdataSelector(std::string& clipdata)
+const std::string* CollisionTableEditor::DrawClipdataSelector(const std::string& clipdata)
 {
+    const std::string* picked = nullptr;
+
     if (ImGui::BeginCombo("##clipdata", clipdata.c_str()))
     {
         for (const std::string& c : Parser::clipdataNames)
         {
-            if (ImGui::MenuItem(c.c_str()))
-                clipdata = c;
+            if (ImGui::MenuItem(c.c_str()) && clipdata != c)
+                picked = &c;
         }
 
         ImGui::EndCombo();
     }
+
+    return picked;
 }
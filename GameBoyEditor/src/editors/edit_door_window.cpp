@@ -1,50 +1,77 @@
 ﻿#include "editors/edit_door_window.hpp"
 
+#include "change_bus.hpp"
 #include "parser.hpp"
 
-void EditDoorWindow::Setup(Door* const door)
+void EditDoorWindow::Setup(const DoorHandle door)
 {
     m_Door = door;
 }
 
+void EditDoorWindow::GetView(std::vector<AssetTag>& view) const
+{
+    view.emplace_back(ChangeType::Door, static_cast<uint32_t>(Parser::GetDoorId(m_Door)));
+}
+
 void EditDoorWindow::Update()
 {
-    const size_t doorId = Parser::GetDoorId(*m_Door);
+    Door* const door = Parser::GetDoor(m_Door);
+    if (door == nullptr)
+    {
+        ImGui::Text("This door was deleted");
+        return;
+    }
+
+    const size_t doorId = Parser::GetDoorId(m_Door);
     ImGui::Text("Door id : %zu", doorId);
-    ImGui::Text("Owner room : %d", m_Door->ownerRoom);
+    ImGui::Text("Owner room : %d", door->ownerRoom);
 
     constexpr uint8_t minDoor = 0;
     const uint8_t maxDoor = Parser::doors.size() - 1;
-    ImGui::SliderScalar("Destination door", ImGuiDataType_U8, &m_Door->targetDoor, &minDoor, &maxDoor);
+    uint8_t targetDoor = door->targetDoor;
+    if (ImGui::SliderScalar("Destination door", ImGuiDataType_U8, &targetDoor, &minDoor, &maxDoor))
+        Parser::SetDoorTarget(m_Door, targetDoor);
+
+    const std::vector<uint8_t>& targeting = Parser::GetDoorsTargeting(doorId);
+    ImGui::Text("Doors leading here : %zu", targeting.size());
 
     constexpr uint8_t minSize = 1;
     constexpr uint8_t maxSize = 10;
-    ImGui::SliderScalar("Width", ImGuiDataType_U8, &m_Door->width, &minSize, &maxSize);
-    ImGui::SliderScalar("Height", ImGuiDataType_U8, &m_Door->height, &minSize, &maxSize);
+    bool_t changed = ImGui::SliderScalar("Width", ImGuiDataType_U8, &door->width, &minSize, &maxSize);
+    changed |= ImGui::SliderScalar("Height", ImGuiDataType_U8, &door->height, &minSize, &maxSize);
 
-    bool_t loadsTileset = m_Door->tileset != 255;
+    bool_t loadsTileset = door->tileset != 255;
     if (ImGui::Checkbox("Loads tileset", &loadsTileset))
     {
+        changed = true;
+
         if (loadsTileset)
-            m_Door->tileset = 0;
+            door->tileset = 0;
         else
-            m_Door->tileset = 255;
+            door->tileset = 255;
     }
 
     if (loadsTileset)
     {
-        if (ImGui::BeginCombo("Tileset to load", Parser::tilesets[m_Door->tileset].c_str()))
+        const GraphicsHandle tileset = door->tileset < Parser::tilesets.size() ? Parser::tilesets[door->tileset] : GraphicsHandle();
+        if (ImGui::BeginCombo("Tileset to load", Parser::graphics.GetName(tileset).c_str()))
         {
             for (size_t i = 0; i < Parser::tilesets.size(); i++)
             {
-                if (ImGui::MenuItem(Parser::tilesets[i].c_str()))
-                    m_Door->tileset = i;
+                if (ImGui::MenuItem(Parser::graphics.GetName(Parser::tilesets[i]).c_str()))
+                {
+                    door->tileset = i;
+                    changed = true;
+                }
             }
 
             ImGui::EndCombo();
         }
     }
 
-    if (m_Door->targetDoor == doorId)
+    if (changed)
+        ChangeBus::Publish(ChangeEvent::Door(doorId));
+
+    if (door->targetDoor == doorId)
         ImGui::TextColored(ImVec4(1, 0, 0, 1), "WARNING : Destination door is the same as self");
 }
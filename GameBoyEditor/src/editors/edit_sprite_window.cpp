@@ -1,27 +1,41 @@
 ﻿#include "editors/edit_sprite_window.hpp"
 
+#include "change_bus.hpp"
 #include "parser.hpp"
 
-void EditSpriteWindow::Setup(SpriteData* sprite)
+void EditSpriteWindow::Setup(const SpriteDataHandle spriteData, const size_t index)
 {
-    m_Sprite = sprite;
+    m_SpriteData = spriteData;
+    m_Index = index;
+}
+
+void EditSpriteWindow::GetView(std::vector<AssetTag>& view) const
+{
+    view.emplace_back(ChangeType::SpriteData, m_SpriteData.index);
 }
 
 void EditSpriteWindow::Update()
 {
-    if (!m_Sprite)
+    // The sprite is looked up every frame, the data may have been copied or resized since the last one
+    if (!Parser::sprites.IsValid(m_SpriteData) || m_Index >= Parser::sprites.Get(m_SpriteData).size())
         return;
 
-    if (ImGui::BeginCombo("Sprite ID", m_Sprite->id.c_str()))
+    SpriteData& sprite = (*Parser::sprites.GetMutable(m_SpriteData))[m_Index];
+
+    if (ImGui::BeginCombo("Sprite ID", sprite.id.c_str()))
     {
         for (const std::string& id : Parser::spriteIds)
         {
-            if (ImGui::Selectable(id.c_str(), id == m_Sprite->id))
-                m_Sprite->id = id;
+            if (ImGui::Selectable(id.c_str(), id == sprite.id))
+            {
+                sprite.id = id;
+                ChangeBus::Publish(ChangeEvent::SpriteData(m_SpriteData));
+            }
         }
 
         ImGui::EndCombo();
     }
 
-    ImGui::InputScalar("Part ID", ImGuiDataType_U8, &m_Sprite->part);
+    if (ImGui::InputScalar("Part ID", ImGuiDataType_U8, &sprite.part))
+        ChangeBus::Publish(ChangeEvent::SpriteData(m_SpriteData));
 }
@@ -1,12 +1,16 @@
 ﻿#include "editors/graphics_editor.hpp"
 
-#include <functional>
+#include <array>
 #include <ranges>
 
+#include "change_bus.hpp"
 #include "parser.hpp"
+#include "reference_index.hpp"
 #include "ui.hpp"
 #include "actions/graphics_add_tile_action.hpp"
 #include "actions/graphics_delete_tile_action.hpp"
+#include "actions/graphics_move_tile_action.hpp"
+#include "actions/replace_tile_action.hpp"
 #include "imgui/imgui.h"
 #include "imgui/imgui_internal.h"
 
@@ -26,27 +30,34 @@ void GraphicsEditor::Update()
     DrawGraphicsSelector();
     DrawPalette();
 
-    if (m_SelectedGraphics != "<None>")
+    if (Parser::graphics.IsValid(m_SelectedGraphics))
     {
         DrawCurrentTile();
         ImGui::SameLine();
         DrawGraphics();
+        DrawTileUsages();
     }
 }
 
+void GraphicsEditor::GetView(std::vector<AssetTag>& view) const
+{
+    view.emplace_back(ChangeType::Graphics, m_SelectedGraphics.index);
+}
+
 void GraphicsEditor::DrawGraphicsSelector()
 {
-    if (!ImGui::BeginCombo("Graphics", m_SelectedGraphics.c_str()))
+    if (!ImGui::BeginCombo("Graphics", Parser::graphics.GetName(m_SelectedGraphics).c_str()))
         return;
 
-    for (const std::string& s : Parser::graphics | std::ranges::views::keys)
+    // Listed by name, the order of the handles is the order the files were parsed in
+    for (const std::string& symbolName : Parser::symbols.GetSymbols(SymbolType::Graphics))
     {
-        if (ImGui::MenuItem(s.c_str()))
+        if (ImGui::MenuItem(symbolName.c_str()))
         {
-            m_SelectedGraphics = s;
+            m_SelectedGraphics = Parser::graphics.Find(symbolName);
 
-            const Graphics& gfx = Parser::graphics[s];
-            const size_t tileMax = gfx.size() / 16;
+            const Graphics& gfx = Parser::graphics.Get(m_SelectedGraphics);
+            const size_t tileMax = gfx.size();
             m_GraphicsRenderTarget.SetSize(16 * 8, static_cast<int32_t>((1 + tileMax / 16) * 8));
         }
     }
@@ -61,41 +72,64 @@ void GraphicsEditor::DrawPalette()
 
 void GraphicsEditor::DrawGraphics()
 {
-    Graphics& graphics = Parser::graphics[m_SelectedGraphics];
+    const Graphics& graphics = Parser::graphics.Get(m_SelectedGraphics);
 
     Ui::CreateSubWindow("graphicsWindow", ImGuiChildFlags_ResizeX);
 
-    const size_t tileAmount = graphics.size() / 16;
+    const size_t tileAmount = graphics.size();
     if (ImGui::Button("Add tile"))
-    {
-        for (size_t i = 0; i < 16; i++)
-            graphics.push_back(0);
-
-        m_ActionQueue.Push(new GraphicsAddTileAction(&graphics, tileAmount));
-    }
+        m_ActionQueue.Push(m_ActionQueue.Create<GraphicsAddTileAction>(m_SelectedGraphics, tileAmount, Tile()), true);
 
     ImGui::BeginDisabled(tileAmount == 1);
     if (ImGui::Button("Delete tile"))
     {
-        m_ActionQueue.Push(new GraphicsDeleteTileAction(&graphics, m_SelectedTile));
-
-        graphics.erase(graphics.begin() + static_cast<int64_t>(m_SelectedTile) * 16, graphics.begin() + static_cast<int64_t>(m_SelectedTile + 1) * 16);
+        m_ActionQueue.Push(m_ActionQueue.Create<GraphicsDeleteTileAction>(m_SelectedGraphics, m_SelectedTile), true);
 
         if (m_SelectedTile == tileAmount - 1)
             m_SelectedTile--;
     }
+    else if (m_SelectedTile <= std::numeric_limits<uint8_t>::max())
+    {
+        const uint8_t tile = static_cast<uint8_t>(m_SelectedTile);
+        const size_t tilemapCount = ReferenceIndex::GetTilemapsUsingTile(m_SelectedGraphics, tile).size();
+        const size_t oamCount = ReferenceIndex::GetOamUsingTile(m_SelectedGraphics, tile).size();
+
+        if (tilemapCount != 0 || oamCount != 0)
+            ImGui::SetItemTooltip("This tile is still used by %zu tilemaps and %zu sprite parts, they will use tile 0 instead", tilemapCount, oamCount);
+    }
     ImGui::EndDisabled();
 
+    // References to the moved tiles follow them
+    ImGui::BeginDisabled(m_SelectedTile == 0);
+    if (ImGui::ArrowButton("moveLeft", ImGuiDir_Left))
+    {
+        m_ActionQueue.Push(m_ActionQueue.Create<GraphicsMoveTileAction>(m_SelectedGraphics, m_SelectedTile, m_SelectedTile - 1), true);
+        m_SelectedTile--;
+    }
+    ImGui::EndDisabled();
+
+    ImGui::SameLine();
+    ImGui::BeginDisabled(m_SelectedTile == tileAmount - 1);
+    if (ImGui::ArrowButton("moveRight", ImGuiDir_Right))
+    {
+        m_ActionQueue.Push(m_ActionQueue.Create<GraphicsMoveTileAction>(m_SelectedGraphics, m_SelectedTile, m_SelectedTile + 1), true);
+        m_SelectedTile++;
+    }
+    ImGui::EndDisabled();
+
+    ImGui::SameLine();
+    ImGui::Text("Move tile");
+
     ImGui::SliderFloat("Zoom", &m_GraphicsRenderTarget.scale, 4, 16);
-    Ui::DrawGraphics(m_GraphicsRenderTarget, graphics, m_ColorPalette, &m_SelectedTile);
+    Ui::DrawGraphics(m_GraphicsRenderTarget, m_SelectedGraphics, m_ColorPalette, &m_SelectedTile);
 
     ImGui::EndChild();
 }
 
 void GraphicsEditor::DrawCurrentTile()
 {
-    Graphics& graphics = Parser::graphics[m_SelectedGraphics];
-    const size_t tileAmount = graphics.size() / 16;
+    const Graphics& graphics = Parser::graphics.Get(m_SelectedGraphics);
+    const size_t tileAmount = graphics.size();
 
     Ui::CreateSubWindow("tileWindow", ImGuiChildFlags_ResizeX);
 
@@ -106,7 +140,7 @@ void GraphicsEditor::DrawCurrentTile()
 
     const ImVec2 position = ImVec2(ImGui::GetWindowPos().x, ImGui::GetWindowPos().y + ImGui::GetCursorPosY());
 
-    Ui::DrawTile(m_TileRenderTarget, graphics, m_SelectedTile, m_ColorPalette);
+    Ui::DrawTile(m_TileRenderTarget, m_SelectedGraphics, m_SelectedTile, m_ColorPalette);
     const size_t pixelIndex = Ui::DrawSelectSquare(position, ImVec2(8.f, 8.f), m_TileRenderTarget.scale);
 
     if (ImGui::IsMouseDown(ImGuiMouseButton_Left) && pixelIndex != std::numeric_limits<size_t>::max())
@@ -118,85 +152,106 @@ void GraphicsEditor::DrawCurrentTile()
         else
         {
             if (m_PlotPixelAction == nullptr)
-                m_PlotPixelAction = new PlotPixelAction(&graphics);
-
-            const Color color = m_ColorPalette[m_SelectedColor];
-            const size_t bitIndex = 7 - pixelIndex % 8;
+                m_PlotPixelAction = m_ActionQueue.Create<PlotPixelAction>(m_SelectedGraphics);
 
+            Tile& tile = (*Parser::graphics.GetMutable(m_SelectedGraphics))[m_SelectedTile];
             const size_t row = pixelIndex / 8;
-            uint8_t& plane0 = graphics[m_SelectedTile * 16 + row * 2 + 0];
-            uint8_t& plane1 = graphics[m_SelectedTile * 16 + row * 2 + 1];
-
-            const uint8_t newPlane0 = static_cast<uint8_t>((plane0 & ~(1 << bitIndex)) | (color >> 0 & 1) << bitIndex);
-            const uint8_t newPlane1 = static_cast<uint8_t>((plane1 & ~(1 << bitIndex)) | (color >> 1 & 1) << bitIndex);
+            const uint8_t plane0 = tile.GetPlane(row, 0);
+            const uint8_t plane1 = tile.GetPlane(row, 1);
 
-            m_PlotPixelAction->AddEdit(static_cast<uint8_t>(m_SelectedTile), static_cast<uint8_t>(row), plane0, plane1, newPlane0, newPlane1);
+            tile.SetPixel(pixelIndex % 8, row, m_ColorPalette[m_SelectedColor]);
 
-            plane0 = newPlane0;
-            plane1 = newPlane1;
+            m_PlotPixelAction->AddEdit(static_cast<uint8_t>(m_SelectedTile), static_cast<uint8_t>(row), plane0, plane1);
+            ChangeBus::Publish(ChangeEvent::GraphicsTiles(m_SelectedGraphics, m_SelectedTile, m_SelectedTile));
         }
     }
 
     if (!ImGui::IsMouseDown(ImGuiMouseButton_Left))
     {
         if (m_PlotPixelAction)
-        {
-            m_ActionQueue.Push(m_PlotPixelAction);
-            m_PlotPixelAction = nullptr;
-        }
+            m_ActionQueue.Push(std::move(m_PlotPixelAction));
     }
 
     ImGui::EndChild();
 }
 
-void GraphicsEditor::PerformFill(const size_t pixelIndex)
+void GraphicsEditor::DrawTileUsages()
 {
-    Graphics& graphics = Parser::graphics[m_SelectedGraphics];
+    ImGui::SeparatorText("Usages");
 
-    const size_t bitIndex = 7 - pixelIndex % 8;
+    if (m_SelectedTile > std::numeric_limits<uint8_t>::max())
+    {
+        ImGui::TextDisabled("Tiles past 255 can't be referenced");
+        return;
+    }
 
-    const size_t row = pixelIndex / 8;
-    const uint8_t plane0 = graphics[m_SelectedTile * 16 + row * 2 + 0] >> bitIndex & 1;
-    const uint8_t plane1 = graphics[m_SelectedTile * 16 + row * 2 + 1] >> bitIndex & 1;
+    const uint8_t tile = static_cast<uint8_t>(m_SelectedTile);
+    const std::vector<TilemapHandle> tilemaps = ReferenceIndex::GetTilemapsUsingTile(m_SelectedGraphics, tile);
+    const std::vector<OamReference> oam = ReferenceIndex::GetOamUsingTile(m_SelectedGraphics, tile);
 
-    const Color oldColor = static_cast<Color>(plane0 | plane1 << 1);
-    const Color newColor = m_ColorPalette[m_SelectedColor];
+    if (tilemaps.empty() && oam.empty())
+        ImGui::TextDisabled("This tile isn't used");
 
-    if (oldColor == newColor)
-        return;
+    for (const TilemapHandle tilemap : tilemaps)
+        ImGui::BulletText("%s : %zu tiles", Parser::tilemaps.GetName(tilemap).c_str(), ReferenceIndex::GetTileCells(tilemap, tile).size());
 
-    PlotPixelAction* action = new PlotPixelAction(&graphics);
+    for (const OamReference& reference : oam)
+        ImGui::BulletText("%s : frame %d, part %d", Parser::animations.GetName(reference.animation).c_str(), reference.frame, reference.entry);
 
-    // https://www.geeksforgeeks.org/dsa/flood-fill-algorithm/
-    const std::function<void(Graphics&, int32_t, int32_t)> dfs = [&dfs, this, oldColor, newColor, action]
-        (Graphics& gfx, const int32_t x, const int32_t y)
-    {
-        if (x < 0 || x >= 8 || y < 0 || y >= 8)
-            return;
+    const size_t tileAmount = Parser::graphics.Get(m_SelectedGraphics).size();
+
+    ImGui::InputScalar("Replace with", ImGuiDataType_U8, &m_ReplacementTile);
+
+    ImGui::BeginDisabled((tilemaps.empty() && oam.empty()) || m_ReplacementTile == tile || m_ReplacementTile >= tileAmount);
+    if (ImGui::Button("Replace everywhere"))
+        m_ActionQueue.Push(m_ActionQueue.Create<ReplaceTileAction>(m_SelectedGraphics, tile, m_ReplacementTile), true);
+    ImGui::EndDisabled();
+}
 
-        const size_t index = m_SelectedTile * 16 + static_cast<size_t>(y) * 2;
+void GraphicsEditor::PerformFill(const size_t pixelIndex)
+{
+    Tile& tile = (*Parser::graphics.GetMutable(m_SelectedGraphics))[m_SelectedTile];
 
-        const uint8_t p0 = gfx[index + 0];
-        const uint8_t p1 = gfx[index + 1];
+    const size_t row = pixelIndex / 8;
+    const Color oldColor = tile.GetPixel(pixelIndex % 8, row);
+    const Color newColor = m_ColorPalette[m_SelectedColor];
 
-        const Color pixelColor = static_cast<Color>((p0 >> x & 1) | (p1 >> x & 1) << 1);
-        if (pixelColor != oldColor)
-            return;
+    if (oldColor == newColor)
+        return;
 
-        const uint8_t newPlane0 = static_cast<uint8_t>((p0 & ~(1 << x)) | (newColor >> 0 & 1) << x);
-        const uint8_t newPlane1 = static_cast<uint8_t>((p1 & ~(1 << x)) | (newColor >> 1 & 1) << x);
-        gfx[index + 0] = newPlane0;
-        gfx[index + 1] = newPlane1;
+    ActionHandle<PlotPixelAction> action = m_ActionQueue.Create<PlotPixelAction>(m_SelectedGraphics);
 
-        action->AddEdit(m_SelectedTile, y, p0, p1, newPlane0, newPlane1);
+    // https://www.geeksforgeeks.org/dsa/flood-fill-algorithm/
+    // Pixels are painted when pushed, so the stack never holds more than the 64 pixels of the tile
+    std::array<uint8_t, 64> stack {};
+    size_t stackSize = 0;
 
-        dfs(gfx, x + 1, y);
-        dfs(gfx, x - 1, y);
-        dfs(gfx, x, y + 1);
-        dfs(gfx, x, y - 1);
+    const auto paint = [this, &tile, &stack, &stackSize, &action, newColor](const size_t x, const size_t y)
+    {
+        action->AddEdit(static_cast<uint8_t>(m_SelectedTile), static_cast<uint8_t>(y), tile.GetPlane(y, 0), tile.GetPlane(y, 1));
+        tile.SetPixel(x, y, newColor);
+        stack[stackSize++] = static_cast<uint8_t>(y * 8 + x);
     };
 
-    dfs(graphics, static_cast<uint8_t>(bitIndex), static_cast<uint8_t>(row));
+    paint(pixelIndex % 8, row);
+
+    while (stackSize > 0)
+    {
+        stackSize--;
+        const size_t x = stack[stackSize] % 8;
+        const size_t y = stack[stackSize] / 8;
+
+        if (x > 0 && tile.GetPixel(x - 1, y) == oldColor)
+            paint(x - 1, y);
+        if (x < 7 && tile.GetPixel(x + 1, y) == oldColor)
+            paint(x + 1, y);
+        if (y > 0 && tile.GetPixel(x, y - 1) == oldColor)
+            paint(x, y - 1);
+        if (y < 7 && tile.GetPixel(x, y + 1) == oldColor)
+            paint(x, y + 1);
+    }
+
+    ChangeBus::Publish(ChangeEvent::GraphicsTiles(m_SelectedGraphics, m_SelectedTile, m_SelectedTile));
 
-    m_ActionQueue.Push(action);
+    m_ActionQueue.Push(std::move(action));
 }
@@ -0,0 +1,49 @@
+﻿#include "editors/oam_profiler_window.hpp"
+
+#include "application.hpp"
+#include "oam_profiler.hpp"
+
+void OamProfilerWindow::Update()
+{
+    if (!Application::IsProjectLoaded())
+        return;
+
+    // Only computed again after the animations or sprites changed, so the list follows the edits
+    OamProfiler::UpdateWorstCases();
+
+    ImGui::Checkbox("Only show flickering", &m_OnlyOverLimit);
+
+    if (!ImGui::BeginTable("worstCases", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY))
+        return;
+
+    ImGui::TableSetupColumn("Source");
+    ImGui::TableSetupColumn("Objects per line");
+    ImGui::TableSetupColumn("Worst line");
+    ImGui::TableSetupColumn("Screen x");
+    ImGui::TableSetupColumn("Objects");
+    ImGui::TableHeadersRow();
+
+    for (const OamWorstCase& worstCase : OamProfiler::worstCases)
+    {
+        const bool_t lineOverLimit = worstCase.peak > OamProfiler::MaxObjectsPerLine;
+        const bool_t totalOverLimit = worstCase.objects > OamProfiler::MaxObjects;
+
+        if (m_OnlyOverLimit && !lineOverLimit && !totalOverLimit)
+            continue;
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("%s", worstCase.name.c_str());
+        ImGui::TableNextColumn();
+        ImGui::TextColored(lineOverLimit ? ImVec4(1, 0, 0, 1) : ImVec4(0, 1, 0, 1), "%zu / %zu", worstCase.peak, OamProfiler::MaxObjectsPerLine);
+        ImGui::TableNextColumn();
+        ImGui::Text("%d", worstCase.line);
+        ImGui::TableNextColumn();
+        if (worstCase.scroll >= 0)
+            ImGui::Text("%d", worstCase.scroll);
+        ImGui::TableNextColumn();
+        ImGui::TextColored(totalOverLimit ? ImVec4(1, 0, 0, 1) : ImVec4(0, 1, 0, 1), "%zu / %zu", worstCase.objects, OamProfiler::MaxObjects);
+    }
+
+    ImGui::EndTable();
+}
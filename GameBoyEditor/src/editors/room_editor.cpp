@@ -1,11 +1,17 @@
 ﻿#include "editors/room_editor.hpp"
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <ranges>
 
 #include "application.hpp"
+#include "change_bus.hpp"
+#include "collision_grid.hpp"
+#include "oam_profiler.hpp"
 #include "parser.hpp"
+#include "reference_index.hpp"
+#include "transaction.hpp"
 #include "ui.hpp"
 #include "editors/edit_door_window.hpp"
 #include "editors/edit_sprite_window.hpp"
@@ -20,18 +26,30 @@ RoomEditor::RoomEditor()
 
     m_TilemapRenderTarget.Create(8, 8);
     m_TilemapRenderTarget.scale = 4;
+
+    m_MetatileRenderTarget.Create(16 * 8, 16);
+    m_MetatileRenderTarget.scale = 4;
 }
 
 void RoomEditor::Update()
 {
-    if (!Application::IsProjectLoaded())
+    if (!Application::IsProjectLoaded() || Parser::rooms.empty())
         return;
 
+    // Undoing the creation of a room removes it
+    if (m_RoomId >= Parser::rooms.size())
+    {
+        m_RoomId = Parser::rooms.size() - 1;
+        m_SelectedSprite = NoSprite;
+        m_HoveredSprite = NoSprite;
+        LoadRoom();
+    }
+
     const float_t y = ImGui::GetCursorPosY();
     DrawOptions();
     DrawTileset();
 
-    if (m_SelectedGraphics == "<None>")
+    if (!Parser::graphics.IsValid(m_SelectedGraphics))
         return;
 
     ImGui::SameLine();
@@ -47,14 +65,36 @@ void RoomEditor::OnProjectLoaded()
     LoadRoom();
 }
 
+void RoomEditor::GetView(std::vector<AssetTag>& view) const
+{
+    if (m_RoomId >= Parser::rooms.size())
+        return;
+
+    const Room& room = Parser::rooms[m_RoomId];
+    view.emplace_back(ChangeType::Tilemap, room.tilemap.index);
+    view.emplace_back(ChangeType::SpriteData, room.spriteData.index);
+    view.emplace_back(ChangeType::RoomPalette, static_cast<uint32_t>(m_RoomId));
+    view.emplace_back(ChangeType::Door, AssetTag::AnyTarget);
+
+    for (const uint8_t doorId : Parser::roomsDoorData.Get(room.doorData))
+        view.emplace_back(ChangeType::Door, doorId);
+}
+
 void RoomEditor::DrawOptions()
 {
     Ui::CreateSubWindow("roomOptions", ImGuiChildFlags_ResizeY, ImVec2(4 * 8 * 16, 0));
     DrawRoomId();
+    DrawIncomingDoors();
     DrawEditingMode();
-    
+    ImGui::Checkbox("Scanline heatmap", &m_DrawScanlines);
+    ImGui::SetItemTooltip("Objects per scanline of the sprites of the room, using the worst frame of each of their animations");
+    DrawCollisionGrid();
+
     DrawResize();
+    const Palette previousPalette = Parser::rooms[m_RoomId].colorPalette;
     Ui::DrawPalette(Parser::rooms[m_RoomId].colorPalette, 30.f, nullptr);
+    if (Parser::rooms[m_RoomId].colorPalette != previousPalette)
+        ChangeBus::Publish(ChangeEvent::RoomPalette(m_RoomId));
 
     ImGui::EndChild();
 }
@@ -78,6 +118,22 @@ void RoomEditor::DrawRoomId()
     }
 }
 
+void RoomEditor::DrawIncomingDoors() const
+{
+    const std::vector<uint8_t> doors = ReferenceIndex::GetDoorsTargetingRoom(m_RoomId);
+    if (doors.empty())
+    {
+        ImGui::TextDisabled("No door leads here");
+        return;
+    }
+
+    std::string list;
+    for (const uint8_t doorId : doors)
+        list += (list.empty() ? "" : ", ") + std::to_string(doorId) + " (room " + std::to_string(Parser::doors[doorId].ownerRoom) + ")";
+
+    ImGui::TextWrapped("Doors leading here : %s", list.c_str());
+}
+
 void RoomEditor::DrawEditingMode()
 {
     bool_t changed = ImGui::RadioButton("Tile mode", reinterpret_cast<int*>(&m_EditingMode), 0);
@@ -88,6 +144,23 @@ void RoomEditor::DrawEditingMode()
         ChangeEditingMode(m_EditingMode);
 }
 
+void RoomEditor::DrawCollisionGrid()
+{
+    bool_t exported = CollisionGridCache::IsExported();
+    if (ImGui::Checkbox("Export packed collision", &exported))
+        CollisionGridCache::SetExport(exported);
+    ImGui::SetItemTooltip("Saves a packed collision grid next to each room, the clipdata of every tile is looked up in a deduplicated value table");
+
+    if (!exported)
+        return;
+
+    const CollisionGrid& grid = CollisionGridCache::Get(m_RoomId);
+    const size_t valueCount = grid.GetUsedValues().size();
+    const size_t bits = CollisionGrid::GetBitsPerTile(valueCount);
+
+    ImGui::Text("%zu values, %zu bits per tile, %zu bytes", valueCount, bits, (grid.cells.size() * bits + 7) / 8);
+}
+
 void RoomEditor::DrawResize()
 {
     constexpr uint8_t maxWidth = 32;
@@ -108,16 +181,16 @@ void RoomEditor::DrawTileset()
 {
     Ui::CreateSubWindow("roomTileset", ImGuiChildFlags_ResizeY, ImVec2(4 * 8 * 16, 0));
 
-    if (ImGui::BeginCombo("Graphics", m_SelectedGraphics.c_str()))
+    if (ImGui::BeginCombo("Graphics", Parser::graphics.GetName(m_SelectedGraphics).c_str()))
     {
-        for (const std::string& s : Parser::tilesets)
+        for (const GraphicsHandle tileset : Parser::tilesets)
         {
-            if (ImGui::MenuItem(s.c_str()))
+            if (ImGui::MenuItem(Parser::graphics.GetName(tileset).c_str()))
             {
-                m_SelectedGraphics = s;
+                m_SelectedGraphics = tileset;
 
-                const Graphics& gfx = Parser::graphics[s];
-                const size_t tileMax = gfx.size() / 16;
+                const Graphics& gfx = Parser::graphics.Get(m_SelectedGraphics);
+                const size_t tileMax = gfx.size();
                 m_GraphicsRenderTarget.SetSize(16 * 8, static_cast<int32_t>((1 + tileMax / 16) * 8));
             }
         }
@@ -125,58 +198,182 @@ void RoomEditor::DrawTileset()
         ImGui::EndCombo();
     }
 
-    if (m_SelectedGraphics != "<None>")
+    if (Parser::graphics.IsValid(m_SelectedGraphics))
     {
-        const Graphics& graphics = Parser::graphics[m_SelectedGraphics];
+        const Graphics& graphics = Parser::graphics.Get(m_SelectedGraphics);
 
         ImGui::SliderFloat("Zoom", &m_GraphicsRenderTarget.scale, 4, 20);
 
         const ImVec2 position = Ui::GetPosition();
-        const size_t index = Ui::DrawGraphics(m_GraphicsRenderTarget, graphics, Parser::rooms[m_RoomId].colorPalette, nullptr);
+        const size_t index = Ui::DrawGraphics(m_GraphicsRenderTarget, m_SelectedGraphics, Parser::rooms[m_RoomId].colorPalette, nullptr);
 
-        const bool_t inBounds = index != std::numeric_limits<size_t>::max() && index < graphics.size() / 16;
+        const bool_t inBounds = index != std::numeric_limits<size_t>::max() && index < graphics.size();
 
-        UpdateSelection(position, inBounds, index % 16, index / 16, true);
+        if (!m_PaintMetatiles)
+            UpdateSelection(position, inBounds, index % 16, index / 16, true);
+
+        DrawMetatiles();
     }
 
     ImGui::EndChild();
 }
 
+void RoomEditor::DrawMetatiles()
+{
+    ImGui::SeparatorText("Metatiles");
+
+    const std::string& tilemapName = Parser::tilemaps.GetName(Parser::rooms[m_RoomId].tilemap);
+    const std::string& graphicsName = Parser::graphics.GetName(m_SelectedGraphics);
+    const std::unordered_map<std::string, std::string>::const_iterator usage = Parser::metatileTilemaps.find(tilemapName);
+
+    if (usage != Parser::metatileTilemaps.end() && usage->second == graphicsName)
+    {
+        if (ImGui::Button("Save as tiles"))
+            Parser::metatileTilemaps.erase(usage);
+        ImGui::SetItemTooltip("The room is saved as metatile indices, click to save it as a regular tilemap again");
+    }
+    else
+    {
+        ImGui::BeginDisabled(m_Width % 2 != 0 || m_Height % 2 != 0);
+        if (ImGui::Button("Save as metatiles"))
+            (void)Parser::BuildMetatiles(tilemapName, graphicsName);
+        ImGui::SetItemTooltip("Adds the 2x2 blocks of the room to the metatiles of the tileset, the room is then saved as metatile indices");
+        ImGui::EndDisabled();
+    }
+
+    const std::unordered_map<std::string, Metatiles>::const_iterator it = Parser::metatiles.find(graphicsName);
+    if (it == Parser::metatiles.end() || it->second.empty())
+    {
+        m_PaintMetatiles = false;
+        return;
+    }
+
+    const Metatiles& dictionary = it->second;
+
+    ImGui::Checkbox("Paint metatiles", &m_PaintMetatiles);
+    ImGui::SameLine();
+    ImGui::Text("%zu / %zu", dictionary.size(), Parser::MaxMetatiles);
+
+    // Lay the metatiles out 8 per row, so that they can be drawn as a tilemap
+    const size_t rows = (dictionary.size() + 7) / 8;
+    if (dictionary != m_MetatileLayoutSource)
+    {
+        m_MetatileLayoutSource = dictionary;
+        m_MetatileLayout = Tilemap(16, rows * 2, 0xFF);
+        m_MetatileLayoutVersion++;
+
+        for (size_t i = 0; i < dictionary.size(); i++)
+        {
+            const size_t x = i % 8 * 2;
+            const size_t y = i / 8 * 2;
+
+            m_MetatileLayout[y + 0][x + 0] = dictionary[i][0];
+            m_MetatileLayout[y + 0][x + 1] = dictionary[i][1];
+            m_MetatileLayout[y + 1][x + 0] = dictionary[i][2];
+            m_MetatileLayout[y + 1][x + 1] = dictionary[i][3];
+        }
+    }
+
+    if (m_MetatileRows != rows)
+    {
+        m_MetatileRows = rows;
+        m_MetatileRenderTarget.SetSize(16 * 8, static_cast<int32_t>(rows * 16));
+    }
+
+    m_MetatileRenderTarget.scale = m_GraphicsRenderTarget.scale;
+
+    const ImVec2 position = Ui::GetPosition();
+    const float_t metatileSize = m_MetatileRenderTarget.scale * 16;
+
+    Ui::DrawTilemap(m_MetatileRenderTarget, m_SelectedGraphics, m_MetatileLayout, m_MetatileLayoutVersion, Parser::rooms[m_RoomId].colorPalette);
+    const size_t index = Ui::DrawSelectSquare(position, ImVec2(8, static_cast<float_t>(rows)), metatileSize);
+
+    if (index < dictionary.size() && ImGui::IsItemHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+    {
+        m_SelectedMetatile = index;
+        m_PaintMetatiles = true;
+    }
+
+    if (!m_PaintMetatiles)
+        return;
+
+    m_SelectedMetatile = std::min(m_SelectedMetatile, dictionary.size() - 1);
+
+    // Paint the selected metatile as a 2x2 selection
+    m_Selection.active = false;
+    m_Selection.width = 1;
+    m_Selection.height = 1;
+    m_Selection.data.assign(dictionary[m_SelectedMetatile].begin(), dictionary[m_SelectedMetatile].end());
+
+    const ImVec2 p1 = ImVec2(
+        position.x + static_cast<float_t>(m_SelectedMetatile % 8) * metatileSize,
+        position.y + static_cast<float_t>(m_SelectedMetatile / 8) * metatileSize  // NOLINT(bugprone-integer-division)
+    );
+    ImGui::GetWindowDrawList()->AddRect(p1, ImVec2(p1.x + metatileSize, p1.y + metatileSize), IM_COL32(0x00, 0xFF, 0x00, 0xFF));
+}
+
 void RoomEditor::DrawRoom()
 {
-    const Graphics& graphics = Parser::graphics[m_SelectedGraphics];
-    Tilemap& tilemap = Parser::tilemaps[Parser::rooms[m_RoomId].tilemap];
+    const Tilemap& tilemap = Parser::tilemaps.Get(Parser::rooms[m_RoomId].tilemap);
     const Palette palette = Parser::rooms[m_RoomId].colorPalette;
 
-    const size_t height = tilemap.size();
-    const size_t width = tilemap[0].size();
+    const size_t height = tilemap.GetHeight();
+    const size_t width = tilemap.GetWidth();
 
     Ui::CreateSubWindow("room", ImGuiChildFlags_ResizeX);
 
-    ImGui::Text("Tilemap : %s", Parser::rooms[m_RoomId].tilemap.c_str());
+    ImGui::Text("Tilemap : %s", Parser::tilemaps.GetName(Parser::rooms[m_RoomId].tilemap).c_str());
     ImGui::SliderFloat("Zoom", &m_TilemapRenderTarget.scale, 4, 20);
 
     const ImVec2 position = Ui::GetPosition();
 
-    Ui::DrawTilemap(m_TilemapRenderTarget, graphics, tilemap, palette);
+    Ui::DrawTilemap(m_TilemapRenderTarget, m_SelectedGraphics, Parser::rooms[m_RoomId].tilemap, palette);
 
-    const ImVec2 selectSize = m_Selection.active || m_EditingMode == EditingMode::Object ? ImVec2(1, 1) :
-        ImVec2(static_cast<float_t>(std::abs(m_Selection.width) + 1), static_cast<float_t>(std::abs(m_Selection.height) + 1));
-    const size_t index = Ui::DrawSelectSquare(position, ImVec2(static_cast<float_t>(width), static_cast<float_t>(height)),
-        m_TilemapRenderTarget.scale * 8, selectSize);
-    const bool_t inBounds = index != std::numeric_limits<size_t>::max();
+    const bool_t paintMetatiles = m_PaintMetatiles && m_EditingMode == EditingMode::Tile && width >= 2 && height >= 2;
 
-    const size_t x = index % width;
-    const size_t y = index / width;
+    size_t index;
+    size_t x;
+    size_t y;
+
+    if (paintMetatiles)
+    {
+        // Metatiles snap to the 2x2 grid
+        const size_t metatileWidth = width / 2;
+        index = Ui::DrawSelectSquare(position, ImVec2(static_cast<float_t>(metatileWidth), static_cast<float_t>(height / 2)),
+            m_TilemapRenderTarget.scale * 16);
+
+        x = index % metatileWidth * 2;
+        y = index / metatileWidth * 2;
+    }
+    else
+    {
+        const ImVec2 selectSize = m_Selection.active || m_EditingMode == EditingMode::Object ? ImVec2(1, 1) :
+            ImVec2(static_cast<float_t>(std::abs(m_Selection.width) + 1), static_cast<float_t>(std::abs(m_Selection.height) + 1));
+        index = Ui::DrawSelectSquare(position, ImVec2(static_cast<float_t>(width), static_cast<float_t>(height)),
+            m_TilemapRenderTarget.scale * 8, selectSize);
+
+        x = index % width;
+        y = index / width;
+    }
+
+    const bool_t inBounds = index != std::numeric_limits<size_t>::max();
 
     if (m_EditingMode == EditingMode::Tile && !m_Selection.data.empty() && ImGui::IsMouseDown(ImGuiMouseButton_Left) && inBounds && ImGui::IsItemHovered())
     {        
         if (!m_EditTilemapAction)
-            m_EditTilemapAction = new EditTilemapAction(&tilemap);
+        {
+            m_EditTilemapAction = m_ActionQueue.Create<EditTilemapAction>(Parser::rooms[m_RoomId].tilemap);
+
+            // The graphics set used to paint the room is the best guess of its tileset
+            ReferenceIndex::SetTilemapGraphics(Parser::rooms[m_RoomId].tilemap, m_SelectedGraphics);
+        }
 
         const size_t selectionWidth = std::abs(m_Selection.width) + 1;
         const size_t selectionHeight = std::abs(m_Selection.height) + 1;
 
+        // Being in bounds, the tilemap exists
+        Tilemap& target = *Parser::tilemaps.GetMutable(Parser::rooms[m_RoomId].tilemap);
+
         for (size_t j = 0; j < selectionHeight; j++)
         {
             for (size_t i = 0; i < selectionWidth; i++)
@@ -191,9 +388,11 @@ void RoomEditor::DrawRoom()
     
                 const uint8_t tile = m_Selection.data[j * selectionWidth + i];
 
-                m_EditTilemapAction->AddEdit(static_cast<uint8_t>(localX), static_cast<uint8_t>(localY),
-                    tilemap[localY][localX], tile);
-                tilemap[localY][localX] = tile;
+                m_EditTilemapAction->AddEdit(static_cast<uint8_t>(localX), static_cast<uint8_t>(localY), target[localY][localX]);
+                target[localY][localX] = tile;
+                CollisionGridCache::UpdateTile(Parser::rooms[m_RoomId].tilemap, localX, localY);
+                ReferenceIndex::UpdateTile(Parser::rooms[m_RoomId].tilemap, localX, localY);
+                ChangeBus::Publish(ChangeEvent::TilemapRect(Parser::rooms[m_RoomId].tilemap, localX, localY, localX, localY));
             }
         }
     }
@@ -201,16 +400,17 @@ void RoomEditor::DrawRoom()
     if (m_EditingMode == EditingMode::Tile && !ImGui::IsMouseDown(ImGuiMouseButton_Left))
     {
         if (m_EditTilemapAction)
-        {
-            m_ActionQueue.Push(m_EditTilemapAction);
-            m_EditTilemapAction = nullptr;
-        }
+            m_ActionQueue.Push(std::move(m_EditTilemapAction));
     }
 
     DrawSprites(position, inBounds, x, y);
     DrawDoors(position, inBounds, x, y);
+    if (m_DrawScanlines)
+        DrawScanlineHeatmap(position);
     DrawObjectContextMenu(x, y);
-    UpdateSelection(position, inBounds, x, y, false);
+
+    if (!paintMetatiles)
+        UpdateSelection(position, inBounds, x, y, false);
 
     ImGui::EndChild();
 }
@@ -245,7 +445,7 @@ void RoomEditor::UpdateSelection(const ImVec2 position, const bool_t inBounds, c
             const size_t width = std::abs(m_Selection.width) + 1;
             const size_t height = std::abs(m_Selection.height) + 1;
 
-            const Tilemap& tilemap = Parser::tilemaps[Parser::rooms[m_RoomId].tilemap];
+            const Tilemap& tilemap = Parser::tilemaps.Get(Parser::rooms[m_RoomId].tilemap);
 
             for (size_t y = 0; y < height; y++)
             {
@@ -295,41 +495,45 @@ void RoomEditor::UpdateSelection(const ImVec2 position, const bool_t inBounds, c
 
 void RoomEditor::DrawSprites(const ImVec2 position, const bool_t inBounds, const size_t cursorX, const size_t cursorY)
 {
-    std::vector<SpriteData>& spriteData = Parser::sprites[Parser::rooms[m_RoomId].spriteData];
+    const std::vector<SpriteData>& spriteData = Parser::sprites.Get(Parser::rooms[m_RoomId].spriteData);
 
     ImDrawList* const dl = ImGui::GetWindowDrawList();
 
     if (!m_IsObjectEditPopupOpen)
-        m_HoveredSprite = nullptr;
+        m_HoveredSprite = NoSprite;
 
-    for (SpriteData& sprite : spriteData)
+    for (size_t i = 0; i < spriteData.size(); i++)
     {
+        const SpriteData& sprite = spriteData[i];
+
         if (m_EditingMode == EditingMode::Object)
         {
-            if (m_SelectedSprite == &sprite)
+            if (m_SelectedSprite == i)
             {
-                if (inBounds)
+                if (inBounds && (sprite.x != cursorX || sprite.y != cursorY + 1))
                 {
-                    m_SelectedSprite->x = static_cast<uint8_t>(cursorX);
-                    m_SelectedSprite->y = static_cast<uint8_t>(cursorY + 1);
+                    SpriteData& moved = (*Parser::sprites.GetMutable(Parser::rooms[m_RoomId].spriteData))[i];
+                    moved.x = static_cast<uint8_t>(cursorX);
+                    moved.y = static_cast<uint8_t>(cursorY + 1);
+                    ChangeBus::Publish(ChangeEvent::SpriteData(Parser::rooms[m_RoomId].spriteData));
                 }
 
                 if (!ImGui::IsMouseDown(ImGuiMouseButton_Left))
-                    m_SelectedSprite = nullptr;
+                    m_SelectedSprite = NoSprite;
             }
 
             if (inBounds && cursorX == sprite.x && cursorY + 1 == sprite.y)
             {
                 if (!m_IsObjectEditPopupOpen)
-                    m_HoveredSprite = &sprite;
+                    m_HoveredSprite = i;
 
-                if (m_SelectedSprite == nullptr && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
-                    m_SelectedSprite = &sprite;
+                if (m_SelectedSprite == NoSprite && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+                    m_SelectedSprite = i;
             }
         }
         else
         {
-            m_SelectedSprite = nullptr;
+            m_SelectedSprite = NoSprite;
         }
 
         const ImVec2 p1 = ImVec2(
@@ -344,29 +548,37 @@ void RoomEditor::DrawSprites(const ImVec2 position, const bool_t inBounds, const
 
 void RoomEditor::DrawDoors(const ImVec2 position, const bool_t inBounds, const size_t cursorX, const size_t cursorY)
 {
-    const DoorData& doorData = Parser::roomsDoorData[Parser::rooms[m_RoomId].doorData];
+    const DoorData& doorData = Parser::roomsDoorData.Get(Parser::rooms[m_RoomId].doorData);
 
     ImDrawList* const dl = ImGui::GetWindowDrawList();
 
     if (!m_IsObjectEditPopupOpen)
-        m_HoveredDoor = nullptr;
+        m_HoveredDoor = {};
 
     for (const uint8_t doorId : doorData)
     {
         Door& door = Parser::doors[doorId];
+        const DoorHandle handle = Parser::GetDoorHandle(doorId);
 
         if (m_EditingMode == EditingMode::Object)
         {
-            if (m_SelectedDoor == &door)
+            if (m_SelectedDoor == handle)
             {
                 if (inBounds)
                 {
-                    m_SelectedDoor->x = static_cast<uint8_t>(cursorX - m_SelectedDoorAnchorX);
-                    m_SelectedDoor->y = static_cast<uint8_t>(cursorY - m_SelectedDoorAnchorY);
+                    const uint8_t newX = static_cast<uint8_t>(cursorX - m_SelectedDoorAnchorX);
+                    const uint8_t newY = static_cast<uint8_t>(cursorY - m_SelectedDoorAnchorY);
+
+                    if (door.x != newX || door.y != newY)
+                    {
+                        door.x = newX;
+                        door.y = newY;
+                        ChangeBus::Publish(ChangeEvent::Door(doorId));
+                    }
                 }
 
                 if (!ImGui::IsMouseDown(ImGuiMouseButton_Left))
-                    m_SelectedDoor = nullptr;
+                    m_SelectedDoor = {};
             }
 
             if (inBounds &&
@@ -374,11 +586,11 @@ void RoomEditor::DrawDoors(const ImVec2 position, const bool_t inBounds, const s
                 cursorY >= door.y && cursorY < static_cast<uint8_t>(door.y + door.height))
             {
                 if (!m_IsObjectEditPopupOpen)
-                    m_HoveredDoor = &door;
+                    m_HoveredDoor = handle;
 
-                if (m_SelectedDoor == nullptr && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+                if (m_SelectedDoor.IsNull() && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
                 {
-                    m_SelectedDoor = &door;
+                    m_SelectedDoor = handle;
                     m_SelectedDoorAnchorX = cursorX - door.x;
                     m_SelectedDoorAnchorY = cursorY - door.y;
                 }
@@ -386,7 +598,7 @@ void RoomEditor::DrawDoors(const ImVec2 position, const bool_t inBounds, const s
         }
         else
         {
-            m_SelectedDoor = nullptr;
+            m_SelectedDoor = {};
         }
 
         const ImVec2 p1 = ImVec2(
@@ -403,6 +615,38 @@ void RoomEditor::DrawDoors(const ImVec2 position, const bool_t inBounds, const s
     }
 }
 
+void RoomEditor::DrawScanlineHeatmap(const ImVec2 position) const
+{
+    const ScanlineProfile profile = OamProfiler::ProfileRoom(m_RoomId);
+
+    ImDrawList* const dl = ImGui::GetWindowDrawList();
+    const float_t scale = m_TilemapRenderTarget.scale;
+
+    // The profile is the one of the worst screen, the lines are only drawn over it
+    const float_t left = position.x + static_cast<float_t>(profile.scroll) * scale;
+    const float_t right = std::min(left + static_cast<float_t>(OamProfiler::ScreenWidth) * scale, position.x + m_TilemapRenderTarget.GetSize().x);
+    const float_t bottom = position.y + m_TilemapRenderTarget.GetSize().y;
+
+    for (size_t i = 0; i < profile.counts.size(); i++)
+    {
+        const size_t count = profile.counts[i];
+        if (count == 0)
+            continue;
+
+        const float_t y = position.y + static_cast<float_t>(profile.top + static_cast<int32_t>(i)) * scale;
+        const uint32_t color = OamProfiler::GetHeatColor(count);
+
+        dl->AddRectFilled(ImVec2(left, y), ImVec2(left + 2 * scale, y + scale), color);
+
+        // Highlight the whole line when it would flicker
+        if (count > OamProfiler::MaxObjectsPerLine)
+            dl->AddRectFilled(ImVec2(left, y), ImVec2(right, y + scale), IM_COL32(0xFF, 0x00, 0x00, 0x40));
+    }
+
+    const bool_t overLimit = profile.GetPeak() > OamProfiler::MaxObjectsPerLine || profile.objects > OamProfiler::MaxObjects;
+    dl->AddRect(ImVec2(left, position.y), ImVec2(right, bottom), overLimit ? IM_COL32(0xFF, 0x00, 0xFF, 0xFF) : IM_COL32(0xFF, 0xFF, 0xFF, 0x80), 0, 0, overLimit ? 4.f : 1.f);
+}
+
 void RoomEditor::DrawObjectContextMenu(const size_t cursorX, const size_t cursorY)
 {
     if (m_EditingMode != EditingMode::Object)
@@ -410,8 +654,8 @@ void RoomEditor::DrawObjectContextMenu(const size_t cursorX, const size_t cursor
 
     if (ImGui::BeginPopupContextItem("objectEditPopup"))
     {
-        std::vector<SpriteData>& spriteData = Parser::sprites[Parser::rooms[m_RoomId].spriteData];
-        DoorData& doorData = Parser::roomsDoorData[Parser::rooms[m_RoomId].doorData];
+        const std::vector<SpriteData>& spriteData = Parser::sprites.Get(Parser::rooms[m_RoomId].spriteData);
+        const DoorData& doorData = Parser::roomsDoorData.Get(Parser::rooms[m_RoomId].doorData);
 
         if (!m_IsObjectEditPopupOpen)
         {
@@ -427,17 +671,18 @@ void RoomEditor::DrawObjectContextMenu(const size_t cursorX, const size_t cursor
         ImGui::BeginDisabled(spriteData.size() == 20);
         if (ImGui::Button("Add sprite"))
         {
-            spriteData.emplace_back(m_BackupCursorX, m_BackupCursorY, "STYPE_NONE", 0);
+            Parser::sprites.GetMutable(Parser::rooms[m_RoomId].spriteData)->emplace_back(m_BackupCursorX, m_BackupCursorY, "STYPE_NONE", 0);
+            ChangeBus::Publish(ChangeEvent::SpriteData(Parser::rooms[m_RoomId].spriteData));
 
             ImGui::CloseCurrentPopup();
             m_IsObjectEditPopupOpen = false;
         }
         ImGui::EndDisabled();
 
-        ImGui::BeginDisabled(m_HoveredSprite == nullptr);
+        ImGui::BeginDisabled(m_HoveredSprite >= spriteData.size());
         if (ImGui::Button("Edit sprite"))
         {
-            Ui::ShowWindow<EditSpriteWindow>()->Setup(m_HoveredSprite);
+            Ui::ShowWindow<EditSpriteWindow>()->Setup(Parser::rooms[m_RoomId].spriteData, m_HoveredSprite);
 
             ImGui::CloseCurrentPopup();
             m_IsObjectEditPopupOpen = false;
@@ -445,8 +690,10 @@ void RoomEditor::DrawObjectContextMenu(const size_t cursorX, const size_t cursor
 
         if (ImGui::Button("Remove sprite"))
         {
-            std::erase(spriteData, *m_HoveredSprite);
-            m_HoveredSprite = nullptr;
+            std::vector<SpriteData>& sprites = *Parser::sprites.GetMutable(Parser::rooms[m_RoomId].spriteData);
+            sprites.erase(sprites.begin() + static_cast<int64_t>(m_HoveredSprite));
+            ChangeBus::Publish(ChangeEvent::SpriteData(Parser::rooms[m_RoomId].spriteData));
+            m_HoveredSprite = NoSprite;
 
             ImGui::CloseCurrentPopup();
             m_IsObjectEditPopupOpen = false;
@@ -458,15 +705,16 @@ void RoomEditor::DrawObjectContextMenu(const size_t cursorX, const size_t cursor
         ImGui::BeginDisabled(doorData.size() == 4 || Parser::doors.size() == 255);
         if (ImGui::Button("Add door"))
         {
-            doorData.push_back(static_cast<uint8_t>(Parser::doors.size()));
-            Parser::doors.emplace_back(m_BackupCursorX, m_BackupCursorY, m_RoomId, 1, 1, 0, 0, 0, 0xFF);
+            Transaction transaction("Add door");
+            Parser::AddDoor(Door(m_BackupCursorX, m_BackupCursorY, m_RoomId, 1, 1, 0, 0, 0, 0xFF));
+            transaction.Commit(m_ActionQueue);
 
             ImGui::CloseCurrentPopup();
             m_IsObjectEditPopupOpen = false;
         }
         ImGui::EndDisabled();
 
-        ImGui::BeginDisabled(m_HoveredDoor == nullptr);
+        ImGui::BeginDisabled(m_HoveredDoor.IsNull());
         if (ImGui::Button("Edit door"))
         {
             Ui::ShowWindow<EditDoorWindow>()->Setup(m_HoveredDoor);
@@ -477,10 +725,12 @@ void RoomEditor::DrawObjectContextMenu(const size_t cursorX, const size_t cursor
 
         if (ImGui::Button("Remove door"))
         {
-            std::erase(doorData, std::ranges::find(Parser::doors, *m_HoveredDoor) - Parser::doors.begin());
-            Parser::DeleteDoor(*m_HoveredDoor);
+            // Renumbers the doors and the door data of the rooms, undone as a single step
+            Transaction transaction("Remove door");
+            Parser::DeleteDoor(m_HoveredDoor);
+            transaction.Commit(m_ActionQueue);
 
-            m_HoveredDoor = nullptr;
+            m_HoveredDoor = {};
 
             ImGui::CloseCurrentPopup();
             m_IsObjectEditPopupOpen = false;
@@ -496,21 +746,24 @@ void RoomEditor::DrawObjectContextMenu(const size_t cursorX, const size_t cursor
 
 void RoomEditor::LoadRoom()
 {
-    const Tilemap& tilemap = Parser::tilemaps[Parser::rooms[m_RoomId].tilemap];
+    const Tilemap& tilemap = Parser::tilemaps.Get(Parser::rooms[m_RoomId].tilemap);
 
-    m_Height = static_cast<uint8_t>(tilemap.size());
-    m_Width = static_cast<uint8_t>(tilemap[0].size());
+    m_Height = static_cast<uint8_t>(tilemap.GetHeight());
+    m_Width = static_cast<uint8_t>(tilemap.GetWidth());
     m_TilemapRenderTarget.SetSize(m_Width * 8, m_Height * 8);
 }
 
 void RoomEditor::ResizeRoom()
 {
-    Tilemap& tilemap = Parser::tilemaps[Parser::rooms[m_RoomId].tilemap];
+    Tilemap* const tilemap = Parser::tilemaps.GetMutable(Parser::rooms[m_RoomId].tilemap);
+    if (tilemap == nullptr)
+        return;
 
-    tilemap.resize(m_Height);
+    tilemap->Resize(m_Width, m_Height);
 
-    for (std::vector<uint8_t>& v : tilemap)
-        v.resize(m_Width);
+    CollisionGridCache::InvalidateTilemap(Parser::rooms[m_RoomId].tilemap);
+    ReferenceIndex::InvalidateTilemap(Parser::rooms[m_RoomId].tilemap);
+    ChangeBus::Publish(ChangeEvent::TilemapRect(Parser::rooms[m_RoomId].tilemap));
 
     m_TilemapRenderTarget.SetSize(m_Width * 8, m_Height * 8);
 }
@@ -522,9 +775,6 @@ void RoomEditor::ChangeEditingMode(const EditingMode newMode)
     if (m_EditingMode == EditingMode::Object)
     {
         if (m_EditTilemapAction)
-        {
-            m_ActionQueue.Push(m_EditTilemapAction);
-            m_EditTilemapAction = nullptr;
-        }
+            m_ActionQueue.Push(std::move(m_EditTilemapAction));
     }
 }
@@ -0,0 +1,105 @@
+﻿#include "editors/sprite_vram_window.hpp"
+
+#include <algorithm>
+#include <ranges>
+
+#include "application.hpp"
+#include "parser.hpp"
+#include "sprite_vram_planner.hpp"
+
+void SpriteVramWindow::Update()
+{
+    if (!Application::IsProjectLoaded())
+        return;
+
+    ImGui::Checkbox("Export on save", &SpriteVramPlanner::exportOnSave);
+    ImGui::SetItemTooltip("Writes sSpriteTileSlots and sRoomSpriteTiles to src/data/sprite_vram.c");
+
+    DrawGraphicsSelector();
+    DrawSpriteAnimations();
+    DrawRoomUsage();
+}
+
+void SpriteVramWindow::OnProjectLoaded()
+{
+    SpriteVramPlanner::GuessSpriteAnimations();
+}
+
+void SpriteVramWindow::DrawGraphicsSelector()
+{
+    if (!ImGui::BeginCombo("Graphics", Parser::graphics.GetName(SpriteVramPlanner::graphics).c_str()))
+        return;
+
+    for (const std::string& symbolName : Parser::symbols.GetSymbols(SymbolType::Graphics))
+    {
+        if (ImGui::MenuItem(symbolName.c_str()))
+            SpriteVramPlanner::graphics = Parser::graphics.Find(symbolName);
+    }
+
+    ImGui::EndCombo();
+}
+
+void SpriteVramWindow::DrawSpriteAnimations()
+{
+    ImGui::SeparatorText("Sprite animations");
+
+    for (const std::string& id : Parser::spriteIds)
+    {
+        if (id == "STYPE_NONE")
+            continue;
+
+        std::vector<AnimationHandle>& animations = SpriteVramPlanner::spriteAnimations[id];
+
+        if (!ImGui::TreeNode(id.c_str(), "%s (%zu)", id.c_str(), animations.size()))
+            continue;
+
+        for (const AnimationHandle animation : Parser::animations.GetHandles())
+        {
+            bool_t used = std::ranges::contains(animations, animation);
+            if (ImGui::Checkbox(Parser::animations.GetName(animation).c_str(), &used))
+            {
+                if (used)
+                    animations.push_back(animation);
+                else
+                    std::erase(animations, animation);
+            }
+        }
+
+        ImGui::TreePop();
+    }
+}
+
+void SpriteVramWindow::DrawRoomUsage()
+{
+    ImGui::SeparatorText("VRAM usage");
+
+    if (ImGui::Button("Compute"))
+        SpriteVramPlanner::Compute();
+
+    if (SpriteVramPlanner::roomTiles.size() != Parser::rooms.size())
+        return;
+
+    if (!ImGui::BeginTable("vramUsage", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        return;
+
+    ImGui::TableSetupColumn("Room");
+    ImGui::TableSetupColumn("Tiles");
+    ImGui::TableSetupColumn("Peak VRAM");
+    ImGui::TableHeadersRow();
+
+    for (size_t i = 0; i < SpriteVramPlanner::roomTiles.size(); i++)
+    {
+        const std::vector<uint8_t>& tiles = SpriteVramPlanner::roomTiles[i];
+        const size_t used = static_cast<size_t>(std::ranges::count_if(tiles, [](const uint8_t tile) { return tile != 0xFF; }));
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("%zu", i);
+        ImGui::TableNextColumn();
+        ImGui::Text("%zu", used);
+        ImGui::TableNextColumn();
+        ImGui::Text("%zu slots (%zu bytes)", tiles.size(), tiles.size() * 16);
+    }
+
+    ImGui::EndTable();
+}
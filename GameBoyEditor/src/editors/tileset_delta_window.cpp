@@ -0,0 +1,89 @@
+﻿#include "editors/tileset_delta_window.hpp"
+
+#include "application.hpp"
+#include "parser.hpp"
+#include "tileset_delta_planner.hpp"
+
+void TilesetDeltaWindow::Update()
+{
+    if (!Application::IsProjectLoaded())
+        return;
+
+    ImGui::Checkbox("Export deltas on save", &TilesetDeltaPlanner::exportOnSave);
+    ImGui::SetItemTooltip("Writes sDoorTilesetDeltas to src/data/door_tileset_deltas.c, doors without a delta reload the whole tileset");
+
+    DrawDeltas();
+    DrawOrdering();
+}
+
+void TilesetDeltaWindow::DrawDeltas()
+{
+    ImGui::SeparatorText("Door deltas");
+
+    if (ImGui::Button("Compute deltas"))
+        TilesetDeltaPlanner::ComputeDeltas();
+
+    // Only computed again after a door or tileset changed, so the table follows the edits
+    TilesetDeltaPlanner::UpdateDeltas();
+
+    if (!ImGui::BeginTable("deltas", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        return;
+
+    ImGui::TableSetupColumn("Door");
+    ImGui::TableSetupColumn("Owner room");
+    ImGui::TableSetupColumn("Tileset");
+    ImGui::TableSetupColumn("Tiles to upload");
+    ImGui::TableHeadersRow();
+
+    for (const DoorTilesetDelta& delta : TilesetDeltaPlanner::deltas)
+    {
+        // The deltas are only marked out of date once the bus is flushed, the door or tileset may be gone until then
+        if (delta.doorId >= Parser::doors.size() || delta.targetTileset >= Parser::tilesets.size())
+            continue;
+
+        const size_t tileCount = Parser::graphics.Get(Parser::tilesets[delta.targetTileset]).size();
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("%zu", delta.doorId);
+        ImGui::TableNextColumn();
+        ImGui::Text("%d", Parser::doors[delta.doorId].ownerRoom);
+        ImGui::TableNextColumn();
+        ImGui::Text("%s", Parser::graphics.GetName(Parser::tilesets[delta.targetTileset]).c_str());
+        ImGui::TableNextColumn();
+
+        if (delta.sourceTilesets.empty())
+            ImGui::TextColored(ImVec4(1, 1, 0, 1), "%zu / %zu (unknown source)", delta.tiles.size(), tileCount);
+        else
+            ImGui::Text("%zu / %zu", delta.tiles.size(), tileCount);
+    }
+
+    ImGui::EndTable();
+}
+
+void TilesetDeltaWindow::DrawOrdering()
+{
+    ImGui::SeparatorText("Tile ordering");
+
+    if (ImGui::Button("Propose ordering"))
+        TilesetDeltaPlanner::ComputeOrdering();
+
+    if (TilesetDeltaPlanner::ordering.size() != Parser::tilesets.size())
+        return;
+
+    ImGui::Text("Shared slots : %zu -> %zu", TilesetDeltaPlanner::sharedSlotsBefore, TilesetDeltaPlanner::sharedSlotsAfter);
+
+    for (size_t i = 0; i < Parser::tilesets.size(); i++)
+    {
+        const std::vector<uint8_t>& order = TilesetDeltaPlanner::ordering[i];
+
+        size_t moved = 0;
+        for (size_t slot = 0; slot < order.size(); slot++)
+        {
+            if (order[slot] != slot)
+                moved++;
+        }
+
+        ImGui::Text("%02zu : %s, %zu tiles moved", i, Parser::graphics.GetName(Parser::tilesets[i]).c_str(), moved);
+    }
+}
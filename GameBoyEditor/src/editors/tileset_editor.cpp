@@ -1,29 +1,29 @@
 ﻿#include "editors/tileset_editor.hpp"
 
-#include <ranges>
-
 #include "parser.hpp"
+#include "reference_index.hpp"
 
 void TilesetEditor::Update()
 {
-    ImGui::BeginDisabled(m_SelectedGraphics == "<None>");
+    ImGui::BeginDisabled(!Parser::graphics.IsValid(m_SelectedGraphics));
     if (ImGui::Button("Add"))
     {
-        Parser::tilesets.push_back(m_SelectedGraphics);
-        m_SelectedGraphics = "<None>";
+        Parser::AddTileset(m_SelectedGraphics);
+        m_SelectedGraphics = {};
     }
     ImGui::EndDisabled();
 
     ImGui::SameLine();
-    if (ImGui::BeginCombo("Graphics", m_SelectedGraphics.c_str()))
+    if (ImGui::BeginCombo("Graphics", Parser::graphics.GetName(m_SelectedGraphics).c_str()))
     {
-        for (const std::string& s : Parser::graphics | std::ranges::views::keys)
+        for (const std::string& symbolName : Parser::symbols.GetSymbols(SymbolType::Graphics))
         {
-            if (std::ranges::contains(Parser::tilesets, s))
+            const GraphicsHandle handle = Parser::graphics.Find(symbolName);
+            if (Parser::IsTileset(handle))
                 continue;
 
-            if (ImGui::MenuItem(s.c_str()))
-                m_SelectedGraphics = s;
+            if (ImGui::MenuItem(symbolName.c_str()))
+                m_SelectedGraphics = handle;
         }
 
         ImGui::EndCombo();
@@ -32,16 +32,65 @@ void TilesetEditor::Update()
     for (size_t i = 0; i < Parser::tilesets.size(); i++)
     {
         ImGui::PushID(&i + i);
+        // The tileset itself is always among the usages
+        const GraphicsUsages usages = ReferenceIndex::GetGraphicsUsages(Parser::tilesets[i]);
+        const bool_t used = !usages.tilemaps.empty() || !usages.animations.empty();
         if (ImGui::Button("-"))
         {
-            Parser::DeleteTileset(i);
-            ImGui::PopID();
-            break;
+            if (!used)
+            {
+                Parser::DeleteTileset(i);
+                ImGui::PopID();
+                break;
+            }
+
+            ImGui::OpenPopup("deleteTileset");
+        }
+
+        if (used && ImGui::BeginItemTooltip())
+        {
+            DrawUsages(Parser::tilesets[i]);
+            ImGui::EndTooltip();
+        }
+
+        if (ImGui::BeginPopup("deleteTileset"))
+        {
+            DrawUsages(Parser::tilesets[i]);
+            ImGui::Text("The doors loading it won't load any tileset anymore");
+
+            const bool_t confirmed = ImGui::Button("Delete");
+            ImGui::SameLine();
+            if (confirmed || ImGui::Button("Cancel"))
+                ImGui::CloseCurrentPopup();
+            ImGui::EndPopup();
+
+            if (confirmed)
+            {
+                Parser::DeleteTileset(i);
+                ImGui::PopID();
+                break;
+            }
         }
 
         ImGui::SameLine();
 
-        ImGui::Text("%02zu : %s", i, Parser::tilesets[i].c_str());
+        ImGui::Text("%02zu : %s", i, Parser::graphics.GetName(Parser::tilesets[i]).c_str());
         ImGui::PopID();
     }
 }
+
+void TilesetEditor::DrawUsages(const GraphicsHandle tileset)
+{
+    const GraphicsUsages usages = ReferenceIndex::GetGraphicsUsages(tileset);
+
+    for (const TilemapHandle tilemap : usages.tilemaps)
+    {
+        if (ReferenceIndex::IsTilemapGraphicsGuessed(tilemap))
+            ImGui::BulletText("%s (guessed from the doors leading to it)", Parser::tilemaps.GetName(tilemap).c_str());
+        else
+            ImGui::BulletText("%s", Parser::tilemaps.GetName(tilemap).c_str());
+    }
+
+    for (const AnimationHandle animation : usages.animations)
+        ImGui::BulletText("%s", Parser::animations.GetName(animation).c_str());
+}
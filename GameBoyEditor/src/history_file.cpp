@@ -0,0 +1,301 @@
+﻿#include "history_file.hpp"
+
+#include <utility>
+
+#include "asset_hashes.hpp"
+#include "parser.hpp"
+
+std::vector<HistoryRecord> HistoryFile::Open(const std::filesystem::path& path)
+{
+    Close();
+
+    std::vector<HistoryRecord> records;
+    std::vector<std::vector<uint8_t>> payloads;
+    std::vector<AssetTag> assets;
+
+    if (std::filesystem::exists(path))
+    {
+        m_File.open(path, std::ios::in | std::ios::out | std::ios::binary);
+
+        uint32_t header[2] = {};
+        m_File.read(reinterpret_cast<char*>(header), sizeof(header));
+
+        std::vector<uint8_t> checkpoint;
+        if (m_File && header[0] == Magic && header[1] == Version)
+        {
+            RecordType type;
+            std::vector<uint8_t> data;
+
+            uint64_t offset = HeaderSize;
+            while (ReadRecord(offset, type, data))
+            {
+                if (type == RecordType::Checkpoint)
+                    checkpoint = data;
+
+                offset += RecordHeaderSize + data.size();
+            }
+        }
+
+        ArchiveReader reader(checkpoint);
+        std::vector<uint64_t> offsets;
+        reader.ReadSpan(offsets);
+
+        // The saved project is the state the actions of the checkpoint lead to, any other content means the history doesn't apply
+        bool_t valid = !checkpoint.empty();
+        const size_t assetCount = reader.Read<uint32_t>();
+        for (size_t i = 0; i < assetCount && valid; i++)
+        {
+            const ChangeType type = reader.Read<ChangeType>();
+            const std::string name = reader.ReadString();
+            const ContentHash savedHash = reader.Read<ContentHash>();
+
+            AssetTag asset;
+            std::string currentName;
+            ContentHash currentHash;
+            valid = !reader.HasFailed() && ResolveAsset(type, name, asset) && DescribeAsset(asset, currentName, currentHash) && currentHash == savedHash;
+
+            assets.push_back(asset);
+        }
+
+        for (size_t i = 0; i < offsets.size() && valid; i++)
+        {
+            RecordType type;
+            // Only the record is kept, it is written again as is
+            std::vector<uint8_t> data;
+            HistoryRecord& record = records.emplace_back();
+            valid = ReadRecord(offsets[i], type, payloads.emplace_back()) && type == RecordType::Action && ParseAction(payloads.back(), record, data);
+        }
+
+        if (!valid)
+        {
+            records.clear();
+            payloads.clear();
+            assets.clear();
+        }
+
+        m_File.close();
+    }
+
+    Create(path);
+
+    for (size_t i = 0; i < records.size(); i++)
+        records[i].offset = AppendRecord(RecordType::Action, payloads[i]);
+
+    if (!records.empty())
+    {
+        std::vector<uint64_t> offsets(records.size());
+        for (size_t i = 0; i < records.size(); i++)
+            offsets[i] = records[i].offset;
+
+        AppendCheckpoint(offsets, assets);
+    }
+
+    return records;
+}
+
+void HistoryFile::Close()
+{
+    if (m_File.is_open())
+        m_File.close();
+
+    m_End = 0;
+}
+
+uint64_t HistoryFile::Append(const Action& action)
+{
+    if (!IsOpen() || action.GetKind() == ActionKind::None)
+        return NoOffset;
+
+    m_Buffer.clear();
+    ArchiveWriter writer(m_Buffer);
+
+    // The name follows from the kind
+    writer.Write(action.GetKind());
+
+    writer.Write<uint32_t>(static_cast<uint32_t>(action.GetAssets().size()));
+    for (const AssetTag& asset : action.GetAssets())
+    {
+        std::string name;
+        ContentHash hash;
+        if (!DescribeAsset(asset, name, hash))
+            return NoOffset;
+
+        writer.Write(asset.type);
+        writer.WriteString(name);
+    }
+
+    action.Serialize(writer);
+
+    return AppendRecord(RecordType::Action, m_Buffer);
+}
+
+void HistoryFile::AppendCheckpoint(const std::span<const uint64_t> offsets, const std::span<const AssetTag> assets)
+{
+    if (!IsOpen())
+        return;
+
+    m_Buffer.clear();
+    ArchiveWriter writer(m_Buffer);
+
+    std::vector<std::pair<std::string, ContentHash>> descriptions(assets.size());
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        if (!DescribeAsset(assets[i], descriptions[i].first, descriptions[i].second))
+            return;
+    }
+
+    writer.WriteSpan(offsets);
+
+    writer.Write<uint32_t>(static_cast<uint32_t>(assets.size()));
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        writer.Write(assets[i].type);
+        writer.WriteString(descriptions[i].first);
+        writer.Write(descriptions[i].second);
+    }
+
+    AppendRecord(RecordType::Checkpoint, m_Buffer);
+    // The checkpoint is what makes the history usable after a restart
+    m_File.flush();
+}
+
+ActionKind HistoryFile::Read(const uint64_t offset, std::vector<uint8_t>& data)
+{
+    RecordType type;
+    HistoryRecord record;
+
+    if (!ReadRecord(offset, type, m_Buffer) || type != RecordType::Action || !ParseAction(m_Buffer, record, data))
+        return ActionKind::None;
+
+    return record.kind;
+}
+
+bool_t HistoryFile::DescribeAsset(const AssetTag& asset, std::string& name, ContentHash& hash)
+{
+    switch (asset.type)
+    {
+        case ChangeType::Graphics: return DescribeAsset(Parser::graphics, asset.target, name, hash);
+        case ChangeType::Tilemap: return DescribeAsset(Parser::tilemaps, asset.target, name, hash);
+        case ChangeType::SpriteData: return DescribeAsset(Parser::sprites, asset.target, name, hash);
+        case ChangeType::Animation: return DescribeAsset(Parser::animations, asset.target, name, hash);
+        case ChangeType::CollisionTable: return DescribeAsset(Parser::collisionTables, asset.target, name, hash);
+
+        // Identified by their position, which doesn't mean anything once the project is reloaded
+        case ChangeType::Door:
+        case ChangeType::RoomPalette:
+            return false;
+    }
+
+    return false;
+}
+
+void HistoryFile::Create(const std::filesystem::path& path)
+{
+    m_File.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+
+    const uint32_t header[2] = { Magic, Version };
+    m_File.write(reinterpret_cast<const char*>(header), sizeof(header));
+    m_End = HeaderSize;
+}
+
+uint64_t HistoryFile::AppendRecord(const RecordType type, const std::span<const uint8_t> data)
+{
+    const uint64_t offset = m_End;
+    const uint32_t size = static_cast<uint32_t>(data.size());
+
+    m_File.clear();
+    m_File.seekp(static_cast<std::streamoff>(offset));
+    m_File.write(reinterpret_cast<const char*>(&type), sizeof(type));
+    m_File.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    m_File.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+    if (!m_File)
+        return NoOffset;
+
+    m_End = offset + RecordHeaderSize + data.size();
+    return offset;
+}
+
+bool_t HistoryFile::ReadRecord(const uint64_t offset, RecordType& type, std::vector<uint8_t>& data)
+{
+    m_File.clear();
+    m_File.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(m_File.tellg());
+
+    if (offset + RecordHeaderSize > fileSize)
+        return false;
+
+    uint32_t size = 0;
+    m_File.seekg(static_cast<std::streamoff>(offset));
+    m_File.read(reinterpret_cast<char*>(&type), sizeof(type));
+    m_File.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+    // A record cut short by a crash ends the file
+    if (!m_File || (type != RecordType::Action && type != RecordType::Checkpoint) || offset + RecordHeaderSize + size > fileSize)
+        return false;
+
+    data.resize(size);
+    m_File.read(reinterpret_cast<char*>(data.data()), size);
+
+    return static_cast<bool_t>(m_File);
+}
+
+bool_t HistoryFile::ParseAction(const std::span<const uint8_t> record, HistoryRecord& info, std::vector<uint8_t>& data)
+{
+    ArchiveReader reader(record);
+
+    info.kind = reader.Read<ActionKind>();
+
+    info.assets.clear();
+    const size_t assetCount = reader.Read<uint32_t>();
+    for (size_t i = 0; i < assetCount && !reader.HasFailed(); i++)
+    {
+        const ChangeType type = reader.Read<ChangeType>();
+        const std::string name = reader.ReadString();
+
+        if (!ResolveAsset(type, name, info.assets.emplace_back()))
+            return false;
+    }
+
+    if (reader.HasFailed() || info.kind == ActionKind::None)
+        return false;
+
+    data.assign(record.begin() + static_cast<int64_t>(reader.GetPosition()), record.end());
+    return true;
+}
+
+bool_t HistoryFile::ResolveAsset(const ChangeType type, const std::string& name, AssetTag& asset)
+{
+    asset.type = type;
+
+    switch (type)
+    {
+        case ChangeType::Graphics: asset.target = Parser::graphics.Find(name).index; break;
+        case ChangeType::Tilemap: asset.target = Parser::tilemaps.Find(name).index; break;
+        case ChangeType::SpriteData: asset.target = Parser::sprites.Find(name).index; break;
+        case ChangeType::Animation: asset.target = Parser::animations.Find(name).index; break;
+        case ChangeType::CollisionTable: asset.target = Parser::collisionTables.Find(name).index; break;
+
+        case ChangeType::Door:
+        case ChangeType::RoomPalette:
+            return false;
+    }
+
+    return asset.target != GraphicsHandle::InvalidIndex;
+}
+
+template <typename T>
+bool_t HistoryFile::DescribeAsset(const AssetStore<T>& store, const uint32_t index, std::string& name, ContentHash& hash)
+{
+    for (const AssetHandle<T> handle : store.GetHandles())
+    {
+        if (handle.index != index)
+            continue;
+
+        name = store.GetName(handle);
+        hash = AssetHashes::Get(handle);
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,210 @@
+﻿#include "oam_profiler.hpp"
+
+#include <algorithm>
+#include <ranges>
+
+#include "parser.hpp"
+#include "sprite_vram_planner.hpp"
+#include "imgui/imgui.h"
+
+size_t ScanlineProfile::GetPeak() const
+{
+    return counts.empty() ? 0 : std::ranges::max(counts);
+}
+
+int32_t ScanlineProfile::GetPeakLine() const
+{
+    return top + static_cast<int32_t>(std::ranges::max_element(counts) - counts.begin());
+}
+
+ScanlineProfile OamProfiler::ProfileFrame(const AnimationFrame& frame)
+{
+    ScanlineProfile profile;
+
+    if (frame.oam.empty())
+        return profile;
+
+    const int8_t top = std::ranges::min(frame.oam, {}, &OamEntry::y).y;
+    const int8_t bottom = std::ranges::max(frame.oam, {}, &OamEntry::y).y;
+
+    profile.top = top;
+    profile.counts.resize(bottom - top + 8);
+    profile.objects = frame.oam.size();
+
+    // Objects are 8x8 pixels
+    profile.left = std::ranges::min(frame.oam, {}, &OamEntry::x).x;
+    profile.right = std::ranges::max(frame.oam, {}, &OamEntry::x).x + 8;
+
+    for (const OamEntry& entry : frame.oam)
+    {
+        for (int32_t i = 0; i < 8; i++)
+            profile.counts[entry.y - top + i]++;
+    }
+
+    return profile;
+}
+
+ScanlineProfile OamProfiler::ProfileSprite(const std::string& spriteId)
+{
+    ScanlineProfile profile;
+
+    // A sprite can show any frame of any of its animations, keep the worst case for each line
+    for (const AnimationHandle animation : SpriteVramPlanner::spriteAnimations[spriteId])
+    {
+        for (const AnimationFrame& frame : Parser::animations.Get(animation))
+            Merge(profile, ProfileFrame(frame), 0, 0, false);
+    }
+
+    return profile;
+}
+
+ScanlineProfile OamProfiler::ProfileRoom(const size_t roomId)
+{
+    const Room& room = Parser::rooms[roomId];
+    const std::vector<SpriteData>& spriteData = Parser::sprites.Get(room.spriteData);
+
+    std::vector<ScanlineProfile> sprites;
+    sprites.reserve(spriteData.size());
+    for (const SpriteData& sprite : spriteData)
+        sprites.push_back(ProfileSprite(sprite.id));
+
+    // The sprites seen at a scroll position are still all seen when scrolling right until one of them leaves the screen,
+    // so the worst screen is found by only trying the positions right before a sprite leaves
+    const int32_t roomWidth = static_cast<int32_t>(Parser::tilemaps.Get(room.tilemap).GetWidth()) * 8;
+    const int32_t maxScroll = std::max(roomWidth - ScreenWidth, 0);
+
+    std::vector<int32_t> scrolls = { 0 };
+    for (size_t i = 0; i < spriteData.size(); i++)
+    {
+        if (!sprites[i].counts.empty())
+            scrolls.push_back(std::clamp(spriteData[i].x * 8 + sprites[i].right - 1, 0, maxScroll));
+    }
+
+    ScanlineProfile worst;
+
+    for (const int32_t scroll : scrolls)
+    {
+        ScanlineProfile profile;
+        profile.scroll = scroll;
+
+        for (size_t i = 0; i < spriteData.size(); i++)
+        {
+            const int32_t x = spriteData[i].x * 8;
+            if (x + sprites[i].left < scroll + ScreenWidth && x + sprites[i].right > scroll)
+                Merge(profile, sprites[i], x, spriteData[i].y * 8, true);
+        }
+
+        if (worst.counts.empty() || IsWorse(profile, worst))
+            worst = std::move(profile);
+    }
+
+    return worst;
+}
+
+void OamProfiler::Reset()
+{
+    worstCases.clear();
+    m_WorstCasesDirty = true;
+
+    const uint32_t mask = ChangeBus::MaskOf(ChangeType::Animation) | ChangeBus::MaskOf(ChangeType::SpriteData);
+    if (m_Subscription == NoSubscription)
+        m_Subscription = ChangeBus::Subscribe([](const ChangeEvent&) { m_WorstCasesDirty = true; }, mask);
+}
+
+void OamProfiler::ComputeWorstCases()
+{
+    worstCases.clear();
+    m_WorstCasesDirty = false;
+
+    for (const AnimationHandle handle : Parser::animations.GetHandles())
+    {
+        const Animation& animation = Parser::animations.Get(handle);
+
+        for (size_t i = 0; i < animation.size(); i++)
+        {
+            const ScanlineProfile profile = ProfileFrame(animation[i]);
+            if (profile.counts.empty())
+                continue;
+
+            worstCases.emplace_back(Parser::animations.GetName(handle) + " frame " + std::to_string(i), profile.GetPeak(), profile.GetPeakLine(), profile.objects);
+        }
+    }
+
+    for (size_t i = 0; i < Parser::rooms.size(); i++)
+    {
+        const ScanlineProfile profile = ProfileRoom(i);
+        if (profile.counts.empty())
+            continue;
+
+        worstCases.emplace_back("Room " + std::to_string(i), profile.GetPeak(), profile.GetPeakLine(), profile.objects, profile.scroll);
+    }
+
+    std::ranges::stable_sort(worstCases, [](const OamWorstCase& a, const OamWorstCase& b)
+    {
+        if (a.peak != b.peak)
+            return a.peak > b.peak;
+
+        return a.objects > b.objects;
+    });
+}
+
+void OamProfiler::UpdateWorstCases()
+{
+    if (m_WorstCasesDirty)
+        ComputeWorstCases();
+}
+
+uint32_t OamProfiler::GetHeatColor(const size_t count)
+{
+    if (count > MaxObjectsPerLine)
+        return IM_COL32(0xFF, 0x00, 0xFF, 0xA0);
+
+    // Green when the line is almost empty, red when it's at the limit
+    const float_t t = static_cast<float_t>(count) / MaxObjectsPerLine;
+    return IM_COL32(static_cast<uint8_t>(t * 0xFF), static_cast<uint8_t>((1.f - t) * 0xFF), 0x00, 0xA0);
+}
+
+void OamProfiler::Merge(ScanlineProfile& profile, const ScanlineProfile& other, const int32_t offsetX, const int32_t offsetY, const bool_t accumulate)
+{
+    if (other.counts.empty())
+        return;
+
+    const int32_t otherTop = other.top + offsetY;
+
+    if (profile.counts.empty())
+    {
+        profile.top = otherTop;
+        profile.left = other.left + offsetX;
+        profile.right = other.right + offsetX;
+    }
+    else if (otherTop < profile.top)
+    {
+        profile.counts.insert(profile.counts.begin(), profile.top - otherTop, 0);
+        profile.top = otherTop;
+    }
+
+    const size_t end = static_cast<size_t>(otherTop - profile.top) + other.counts.size();
+    if (profile.counts.size() < end)
+        profile.counts.resize(end);
+
+    for (size_t i = 0; i < other.counts.size(); i++)
+    {
+        size_t& count = profile.counts[otherTop - profile.top + i];
+        count = accumulate ? count + other.counts[i] : std::max(count, other.counts[i]);
+    }
+
+    profile.objects = accumulate ? profile.objects + other.objects : std::max(profile.objects, other.objects);
+    profile.left = std::min(profile.left, other.left + offsetX);
+    profile.right = std::max(profile.right, other.right + offsetX);
+}
+
+bool_t OamProfiler::IsWorse(const ScanlineProfile& profile, const ScanlineProfile& other)
+{
+    const size_t peak = profile.GetPeak();
+    const size_t otherPeak = other.GetPeak();
+
+    if (peak != otherPeak)
+        return peak > otherPeak;
+
+    return profile.objects > other.objects;
+}
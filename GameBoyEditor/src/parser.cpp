@@ -3,9 +3,18 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <numeric>
 #include <ranges>
 
 #include "application.hpp"
+#include "asset_hashes.hpp"
+#include "change_bus.hpp"
+#include "collision_grid.hpp"
+#include "oam_profiler.hpp"
+#include "reference_index.hpp"
+#include "sprite_vram_planner.hpp"
+#include "tileset_delta_planner.hpp"
 
 #define TAB "    "
 
@@ -14,6 +23,11 @@ bool_t Parser::ParseProject()
     const std::filesystem::path path = Application::projectPath;
     const std::filesystem::path srcPath = path / "src";
 
+    warnings.clear();
+    AssetHashes::Reset();
+    TilesetDeltaPlanner::Reset();
+    OamProfiler::Reset();
+
     for (const std::filesystem::directory_entry& dirEntry : std::filesystem::recursive_directory_iterator(srcPath))
     {
         // Skip folders
@@ -29,15 +43,40 @@ bool_t Parser::ParseProject()
             return false;
     }
 
+    // Metatiles and tilesets may be parsed after the tilemaps using them
+    if (!ExpandMetatileTilemaps())
+        return false;
+
+    BuildDoorIndex();
     ParseEnums();
+    ReferenceIndex::Rebuild();
+
+    // Rooms added since the last export don't have a grid yet
+    CollisionGridCache::InvalidateAll();
+    if (CollisionGridCache::IsExported())
+        CollisionGridCache::SetExport(true);
+
+    m_SavedFileHashes.clear();
+    for (const std::pair<const std::string, std::vector<SymbolInfo>>& association : symbols.GetFiles())
+        m_SavedFileHashes.emplace(association.first, HashFile(association.second));
 
     return true;
 }
 
 bool_t Parser::Save()
 {
-    for (const std::pair<const std::string, std::vector<SymbolInfo>>& association : fileAssociations)
+    // The hashes only see the edits once they have been delivered
+    ChangeBus::Flush();
+    SyncMetatiles();
+
+    for (const std::pair<const std::string, std::vector<SymbolInfo>>& association : symbols.GetFiles())
     {
+        // Rewriting a file that didn't change would only make the game rebuild it
+        const ContentHash hash = HashFile(association.second);
+        const std::unordered_map<std::string, ContentHash>::const_iterator saved = m_SavedFileHashes.find(association.first);
+        if (saved != m_SavedFileHashes.end() && saved->second == hash)
+            continue;
+
         std::fstream file;
         const std::filesystem::path filePath = association.first;
         file.open(filePath, std::ifstream::out | std::ifstream::in | std::ifstream::app);
@@ -78,49 +117,152 @@ bool_t Parser::Save()
                 case SymbolType::Tilesets: SaveTilesets(file, symbolInfo.second); break;
                 case SymbolType::CollisionTable: SaveCollisionTable(file, symbolInfo.second); break;
                 case SymbolType::CollisionTableArray: SaveCollisionTableArray(file, symbolInfo.second); break;
+                case SymbolType::Metatiles: SaveMetatiles(file, symbolInfo.second); break;
+                case SymbolType::CollisionGrid: SaveCollisionGrid(file, symbolInfo.second); break;
             }
         }
 
         RemoveDuplicateIncludes(file, filePath);
 
         file.close();
+
+        m_SavedFileHashes[association.first] = hash;
     }
 
+    if (TilesetDeltaPlanner::exportOnSave)
+        TilesetDeltaPlanner::Export();
+
+    if (SpriteVramPlanner::exportOnSave)
+        SpriteVramPlanner::Export();
+
+    m_UnsavedChanges = false;
+
     return true;
 }
 
 void Parser::RegisterSymbol(const std::string& file, const std::string& symbolName, const SymbolType type)
 {
-    fileAssociations[file].emplace_back(type, symbolName);
-    existingSymbols.push_back(symbolName);
+    symbols.Add(file, symbolName, type);
 }
 
-size_t Parser::GetDoorId(const Door& door)
+DoorHandle Parser::AddDoor(const Door& door)
 {
-    return std::ranges::find(doors, door) - doors.begin();
+    const uint8_t doorId = static_cast<uint8_t>(doors.size());
+    const uint32_t handleId = static_cast<uint32_t>(m_DoorIds.size());
+
+    doors.push_back(door);
+    m_DoorHandleIds.push_back(handleId);
+    m_DoorIds.push_back(doorId);
+    m_DoorTargeters.emplace_back();
+
+    if (door.targetDoor < doors.size())
+        m_DoorTargeters[door.targetDoor].push_back(doorId);
+
+    GetOwnerDoorData(door).push_back(doorId);
+
+    ChangeBus::Publish(ChangeEvent::Door(doorId));
+    return DoorHandle(handleId);
 }
 
-void Parser::DeleteDoor(const Door& door)
+void Parser::DeleteDoor(const DoorHandle handle)
 {
-    const size_t index = GetDoorId(door);
-    std::erase(doors, door);
+    const size_t index = GetDoorId(handle);
+    if (index == doors.size())
+        return;
+
+    const uint8_t doorId = static_cast<uint8_t>(index);
+    const uint8_t lastId = static_cast<uint8_t>(doors.size() - 1);
+
+    if (doors[doorId].targetDoor < doors.size())
+        std::erase(m_DoorTargeters[doors[doorId].targetDoor], doorId);
+
+    for (const uint8_t d : m_DoorTargeters[doorId])
+        doors[d].targetDoor = 0xFF; // TODO Maybe print a warning or something?
+
+    std::erase(GetOwnerDoorData(doors[doorId]), doorId);
 
-    for (DoorData& doorData : roomsDoorData | std::ranges::views::values)
+    // Move the last door in the freed slot, so only the references to these two doors have to change
+    if (doorId != lastId)
     {
-        for (size_t i = 0; i < doorData.size(); i++)  // NOLINT(modernize-loop-convert)
+        Door& last = doors[lastId];
+
+        std::ranges::replace(GetOwnerDoorData(last), lastId, doorId);
+
+        if (last.targetDoor < doors.size())
+            std::ranges::replace(m_DoorTargeters[last.targetDoor], lastId, doorId);
+
+        for (uint8_t& d : m_DoorTargeters[lastId])
         {
-            if (doorData[i] > index)
-                doorData[i]--;
+            doors[d].targetDoor = doorId;
+            if (d == lastId)
+                d = doorId;
         }
-    }
 
-    for (Door& d : doors)
-    {
-        if (d.targetDoor > index)
-            d.targetDoor--;
-        else if (d.targetDoor == index)
-            d.targetDoor = 0xFF; // TODO Maybe print a warning or something?
+        doors[doorId] = last;
+        m_DoorTargeters[doorId] = std::move(m_DoorTargeters[lastId]);
+        m_DoorHandleIds[doorId] = m_DoorHandleIds[lastId];
+        m_DoorIds[m_DoorHandleIds[doorId]] = doorId;
     }
+
+    ChangeBus::Publish(ChangeEvent::Door(doorId));
+    ChangeBus::Publish(ChangeEvent::Door(lastId));
+
+    doors.pop_back();
+    m_DoorTargeters.pop_back();
+    m_DoorHandleIds.pop_back();
+    m_DoorIds[handle.id] = DoorHandle::InvalidId;
+}
+
+void Parser::SetDoorTarget(const DoorHandle handle, const uint8_t targetDoor)
+{
+    const size_t index = GetDoorId(handle);
+    if (index == doors.size())
+        return;
+
+    const uint8_t doorId = static_cast<uint8_t>(index);
+    Door& door = doors[doorId];
+
+    if (door.targetDoor < doors.size())
+        std::erase(m_DoorTargeters[door.targetDoor], doorId);
+
+    door.targetDoor = targetDoor;
+    ChangeBus::Publish(ChangeEvent::Door(doorId));
+
+    if (door.targetDoor < doors.size())
+        m_DoorTargeters[door.targetDoor].push_back(doorId);
+}
+
+DoorHandle Parser::GetDoorHandle(const size_t doorId)
+{
+    if (doorId >= m_DoorHandleIds.size())
+        return {};
+
+    return DoorHandle(m_DoorHandleIds[doorId]);
+}
+
+size_t Parser::GetDoorId(const DoorHandle handle)
+{
+    if (handle.id >= m_DoorIds.size() || m_DoorIds[handle.id] == DoorHandle::InvalidId)
+        return doors.size();
+
+    return m_DoorIds[handle.id];
+}
+
+Door* Parser::GetDoor(const DoorHandle handle)
+{
+    const size_t doorId = GetDoorId(handle);
+    return doorId < doors.size() ? &doors[doorId] : nullptr;
+}
+
+const std::vector<uint8_t>& Parser::GetDoorsTargeting(const size_t doorId)
+{
+    static const std::vector<uint8_t> none;
+    return doorId < m_DoorTargeters.size() ? m_DoorTargeters[doorId] : none;
+}
+
+void Parser::AddTileset(const GraphicsHandle graphics)
+{
+    tilesets.push_back(graphics);
 }
 
 void Parser::DeleteTileset(const size_t index)
@@ -139,6 +281,47 @@ void Parser::DeleteTileset(const size_t index)
     }
 }
 
+bool_t Parser::BuildMetatiles(const std::string& tilemap, const std::string& graphics)
+{
+    const Tilemap& t = tilemaps.Get(tilemap);
+
+    if (t.GetHeight() % 2 != 0 || t.GetWidth() % 2 != 0)
+        return false;
+
+    const std::string symbolName = graphics + "_Metatiles";
+    if (!symbols.Contains(symbolName))
+    {
+        // The metatiles are put next to the graphics of the tileset
+        const std::string file = GetSymbolFile(graphics);
+        if (file.empty())
+            return false;
+
+        RegisterSymbol(file, symbolName, SymbolType::Metatiles);
+    }
+
+    m_MetatilesJournal.Record(metatiles, graphics);
+    Metatiles& dictionary = metatiles[graphics];
+
+    for (size_t y = 0; y < t.GetHeight(); y += 2)
+    {
+        for (size_t x = 0; x < t.GetWidth(); x += 2)
+        {
+            const Metatile metatile = GetMetatile(t, x, y);
+            if (std::ranges::contains(dictionary, metatile))
+                continue;
+
+            if (dictionary.size() == MaxMetatiles)
+                return false;
+
+            dictionary.push_back(metatile);
+        }
+    }
+
+    m_MetatileTilemapsJournal.Record(metatileTilemaps, tilemap);
+    metatileTilemaps[tilemap] = graphics;
+    return true;
+}
+
 bool_t Parser::ParseFileContents(const std::filesystem::path& filePath)
 {
     std::ifstream file;
@@ -156,7 +339,17 @@ bool_t Parser::ParseFileContents(const std::filesystem::path& filePath)
         if (line.contains("extern"))
             continue;
 
-        if (line.starts_with("const u8 ") && (line.contains("Graphics") || line.contains("Tilemap")))
+        if (line.starts_with("const u8 ") && line.contains("_Metatiles"))
+        {
+            if (!ParseMetatiles(file, filePath, line))
+                return false;
+        }
+        else if (line.starts_with("const u8 ") && line.contains("_CollisionGrid"))
+        {
+            if (!ParseCollisionGrid(file, filePath, line))
+                return false;
+        }
+        else if (line.starts_with("const u8 ") && (line.contains("Graphics") || line.contains("Tilemap")))
         {
             ParseGraphicsArray(file, filePath, line);
         }
@@ -203,6 +396,7 @@ bool_t Parser::ParseGraphicsArray(std::ifstream& file, const std::filesystem::pa
     SymbolType type;
     int32_t width = 0;
     int32_t height = 0;
+    int32_t metatileTileset = -1;
 
     const size_t idx = line.find('[');
     const std::string symbolName = line.substr(sizeof("const u8"), idx - sizeof("const u8"));
@@ -216,8 +410,11 @@ bool_t Parser::ParseGraphicsArray(std::ifstream& file, const std::filesystem::pa
     else if (symbolName.contains("Tilemap"))
     {
         std::getline(file, line);
-        (void)sscanf_s(line.c_str(), "%d, %d", &width, &height);
-        
+        if (line.contains("METATILEMAP("))
+            (void)sscanf_s(line.c_str(), "    METATILEMAP(%d), %d, %d,", &width, &height, &metatileTileset);
+        else
+            (void)sscanf_s(line.c_str(), "%d, %d", &width, &height);
+
         std::getline(file, line);
         type = SymbolType::Tilemap;
     }
@@ -227,6 +424,7 @@ bool_t Parser::ParseGraphicsArray(std::ifstream& file, const std::filesystem::pa
     }
 
     std::vector<uint8_t> data;
+    Graphics tiles;
 
     while (true)
     {
@@ -243,7 +441,11 @@ bool_t Parser::ParseGraphicsArray(std::ifstream& file, const std::filesystem::pa
                 &buffer[8],  &buffer[9],  &buffer[10], &buffer[11],
                 &buffer[12], &buffer[13], &buffer[14], &buffer[15]
             );
-            data.append_range(buffer);
+
+            // One tile per line
+            Tile& tile = tiles.emplace_back();
+            for (size_t i = 0; i < tile.data.size(); i++)
+                tile.data[i] = static_cast<uint8_t>(buffer[i]);
         }
         else if (type == SymbolType::Tilemap)
         {
@@ -259,18 +461,17 @@ bool_t Parser::ParseGraphicsArray(std::ifstream& file, const std::filesystem::pa
 
     if (type == SymbolType::Graphics)
     {
-        graphics[symbolName] = data;
+        graphics.Add(symbolName, std::move(tiles));
+    }
+    else if (type == SymbolType::Tilemap && metatileTileset != -1)
+    {
+        // Needs the metatiles of the tileset to be expanded, which might not have been parsed yet
+        m_PendingMetatileTilemaps.emplace_back(symbolName, width, height, metatileTileset, std::move(data));
     }
     else if (type == SymbolType::Tilemap)
     {
-        tilemaps[symbolName].resize(height);
-
-        const size_t h = static_cast<size_t>(height);
-        for (size_t i = 0; i < h; i++)
-        {
-            const Tilemap::difference_type index = width * i;
-            tilemaps[symbolName][i] = std::vector(data.begin() + index, data.begin() + index + width);
-        }
+        // The decompressed data already is row-major
+        tilemaps.Add(symbolName, Tilemap(static_cast<size_t>(width), static_cast<size_t>(height), std::move(data)));
     }
 
     RegisterSymbol(filePath.string(), symbolName, type);
@@ -303,7 +504,8 @@ bool_t Parser::ParseRoomInfo(std::ifstream& file, const std::filesystem::path& f
         // Skip the line with },
         std::getline(file, line);
 
-        rooms.emplace_back(tilemap, ParsePalette(palette), spriteData, doorData, collisionTable);
+        // The assets may not have been parsed yet
+        rooms.emplace_back(tilemaps.Acquire(tilemap), ParsePalette(palette), sprites.Acquire(spriteData), roomsDoorData.Acquire(doorData), collisionTable);
     }
 
     RegisterSymbol(filePath.string(), "sRooms", SymbolType::RoomData);
@@ -315,6 +517,7 @@ bool_t Parser::ParseSpriteInfo(std::ifstream& file, const std::filesystem::path&
 {
     const size_t idx = line.find('[');
     const std::string symbolName = line.substr(sizeof("const struct RoomSprite"), idx - sizeof("const struct RoomSprite"));
+    std::vector<SpriteData>& spriteData = *sprites.GetMutable(sprites.Acquire(symbolName));
 
     while (true)
     {
@@ -340,7 +543,7 @@ bool_t Parser::ParseSpriteInfo(std::ifstream& file, const std::filesystem::path&
         // Skip the line with },
         std::getline(file, line);
 
-        sprites[symbolName].emplace_back(x, y, type, part);
+        spriteData.emplace_back(x, y, type, part);
     }
 
     RegisterSymbol(filePath.string(), symbolName, SymbolType::SpriteData);
@@ -415,7 +618,7 @@ bool_t Parser::ParseAnimation(std::ifstream& file, const std::filesystem::path&
         animationFrame++;
     }
 
-    animations[symbolName] = animation;
+    animations.Add(symbolName, std::move(animation));
 
     RegisterSymbol(filePath.string(), symbolName, SymbolType::Animation);
 
@@ -441,7 +644,7 @@ bool_t Parser::ParseDoorData(std::ifstream& file, const std::filesystem::path& f
         doorData.push_back(static_cast<uint8_t>(doorId));
     }
 
-    roomsDoorData[symbolName] = doorData;
+    roomsDoorData.Add(symbolName, std::move(doorData));
     RegisterSymbol(filePath.string(), symbolName, SymbolType::DoorData);
 
     return true;
@@ -504,7 +707,8 @@ bool_t Parser::ParseTilesets(std::ifstream& file, const std::filesystem::path& f
             break;
 
         const std::string gfxName = line.substr(sizeof("    ") - 1, line.find(',') - sizeof("    ") + 1);
-        tilesets.push_back(gfxName);
+        // The graphics may be parsed later, they keep the handle acquired here
+        AddTileset(graphics.Acquire(gfxName));
     }
 
     RegisterSymbol(filePath.string(), "sTilesets", SymbolType::Tilesets);
@@ -515,6 +719,7 @@ bool_t Parser::ParseCollisionTable(std::ifstream& file, const std::filesystem::p
 {
     const size_t idx = line.find('[');
     const std::string symbolName = line.substr(sizeof("const u8"), idx - sizeof("const u8"));
+    CollisionTable& collisionTable = *collisionTables.GetMutable(collisionTables.Acquire(symbolName));
 
     while (true)
     {
@@ -524,7 +729,7 @@ bool_t Parser::ParseCollisionTable(std::ifstream& file, const std::filesystem::p
             break;
 
         const std::string clipdata = line.substr(sizeof("    ") - 1, line.find(',') - sizeof("    ") + 1);
-        collisionTables[symbolName].push_back(clipdata);
+        collisionTable.push_back(clipdata);
     }
 
     RegisterSymbol(filePath.string(), symbolName, SymbolType::CollisionTable);
@@ -540,14 +745,436 @@ bool_t Parser::ParseCollisionTableArray(std::ifstream& file, const std::filesyst
         if (line[0] == '}')
             break;
 
-        const std::string clipdata = line.substr(sizeof("    ") - 1, line.find(',') - sizeof("    ") + 1);
-        collisionTableArray.push_back(clipdata);
+        const std::string collisionTable = line.substr(sizeof("    ") - 1, line.find(',') - sizeof("    ") + 1);
+        collisionTableArray.push_back(collisionTables.Acquire(collisionTable));
     }
 
     RegisterSymbol(filePath.string(), "sCollisionTables", SymbolType::CollisionTableArray);
     return true;
 }
 
+bool_t Parser::ParseMetatiles(std::ifstream& file, const std::filesystem::path& filePath, std::string& line)
+{
+    const size_t idx = line.find('[');
+    const std::string symbolName = line.substr(sizeof("const u8"), idx - sizeof("const u8"));
+    const std::string graphicsName = symbolName.substr(0, symbolName.size() - sizeof("_Metatiles") + 1);
+
+    // Skip the count and the empty line
+    std::getline(file, line);
+    std::getline(file, line);
+
+    Metatiles& dictionary = metatiles[graphicsName];
+
+    while (std::getline(file, line) && !line.starts_with('}'))
+    {
+        int32_t buffer[4];
+        (void)sscanf_s(line.c_str(), "%x, %x, %x, %x,", &buffer[0], &buffer[1], &buffer[2], &buffer[3]);
+
+        dictionary.push_back({
+            static_cast<uint8_t>(buffer[0]), static_cast<uint8_t>(buffer[1]),
+            static_cast<uint8_t>(buffer[2]), static_cast<uint8_t>(buffer[3])
+        });
+    }
+
+    if (!file)
+    {
+        warnings.push_back(filePath.string() + " ends before the end of " + symbolName);
+        return false;
+    }
+
+    RegisterSymbol(filePath.string(), symbolName, SymbolType::Metatiles);
+    return true;
+}
+
+bool_t Parser::ParseCollisionGrid(std::ifstream& file, const std::filesystem::path& filePath, std::string& line)
+{
+    const size_t idx = line.find('[');
+    const std::string symbolName = line.substr(sizeof("const u8"), idx - sizeof("const u8"));
+
+    // The grid is generated from the tilemap and the collision table of the room, only remember that it's exported
+    while (std::getline(file, line) && !line.starts_with('}'))
+        continue;
+
+    if (!file)
+    {
+        warnings.push_back(filePath.string() + " ends before the end of " + symbolName);
+        return false;
+    }
+
+    CollisionGridCache::MarkExported();
+    RegisterSymbol(filePath.string(), symbolName, SymbolType::CollisionGrid);
+    return true;
+}
+
+void Parser::BuildDoorIndex()
+{
+    m_DoorHandleIds.resize(doors.size());
+    std::iota(m_DoorHandleIds.begin(), m_DoorHandleIds.end(), 0);
+    m_DoorIds = m_DoorHandleIds;
+
+    m_DoorTargeters.assign(doors.size(), {});
+    for (size_t i = 0; i < doors.size(); i++)
+    {
+        if (doors[i].targetDoor < doors.size())
+            m_DoorTargeters[doors[i].targetDoor].push_back(static_cast<uint8_t>(i));
+    }
+}
+
+DoorData& Parser::GetOwnerDoorData(const Door& door)
+{
+    static DoorData none;
+    DoorData* const doorData = door.ownerRoom < rooms.size() ? roomsDoorData.GetMutable(rooms[door.ownerRoom].doorData) : nullptr;
+
+    return doorData ? *doorData : none;
+}
+
+bool_t Parser::ExpandMetatileTilemaps()
+{
+    for (const PendingMetatileTilemap& pending : m_PendingMetatileTilemaps)
+    {
+        if (pending.tileset < 0 || pending.tileset >= static_cast<int32_t>(tilesets.size()))
+        {
+            warnings.push_back(pending.name + " uses the metatiles of tileset " + std::to_string(pending.tileset) + ", which doesn't exist");
+            m_PendingMetatileTilemaps.clear();
+            return false;
+        }
+
+        const std::string& graphicsName = graphics.GetName(tilesets[pending.tileset]);
+        const Metatiles& dictionary = FindMetatiles(graphicsName);
+
+        if (!std::ranges::all_of(pending.data, [&dictionary](const uint8_t index) { return index < dictionary.size(); }))
+        {
+            warnings.push_back(pending.name + " uses metatiles that " + graphicsName + " doesn't have");
+            m_PendingMetatileTilemaps.clear();
+            return false;
+        }
+
+        Tilemap& tilemap = *tilemaps.GetMutable(tilemaps.Acquire(pending.name));
+        tilemap = Tilemap(static_cast<size_t>(pending.width) * 2, static_cast<size_t>(pending.height) * 2);
+
+        for (size_t i = 0; i < pending.data.size(); i++)
+        {
+            const Metatile& metatile = dictionary[pending.data[i]];
+            const size_t x = i % pending.width * 2;
+            const size_t y = i / pending.width * 2;
+
+            tilemap[y + 0][x + 0] = metatile[0];
+            tilemap[y + 0][x + 1] = metatile[1];
+            tilemap[y + 1][x + 0] = metatile[2];
+            tilemap[y + 1][x + 1] = metatile[3];
+        }
+
+        metatileTilemaps[pending.name] = graphicsName;
+    }
+
+    m_PendingMetatileTilemaps.clear();
+    return true;
+}
+
+void Parser::SyncMetatiles()
+{
+    for (std::unordered_map<std::string, std::string>::iterator it = metatileTilemaps.begin(); it != metatileTilemaps.end();)
+    {
+        const Tilemap& tilemap = tilemaps.Get(it->first);
+        m_MetatilesJournal.Record(metatiles, it->second);
+        Metatiles& dictionary = metatiles[it->second];
+
+        bool_t valid = tilemap.GetHeight() % 2 == 0 && tilemap.GetWidth() % 2 == 0 && IsTileset(graphics.Find(it->second));
+
+        // Blocks painted tile by tile since the metatiles were built have to be added
+        Metatiles missing;
+        for (size_t y = 0; valid && y < tilemap.GetHeight(); y += 2)
+        {
+            for (size_t x = 0; x < tilemap.GetWidth(); x += 2)
+            {
+                const Metatile metatile = GetMetatile(tilemap, x, y);
+                if (!std::ranges::contains(dictionary, metatile) && !std::ranges::contains(missing, metatile))
+                    missing.push_back(metatile);
+            }
+        }
+
+        valid &= dictionary.size() + missing.size() <= MaxMetatiles;
+
+        if (!valid)
+        {
+            // Can't be represented with metatiles anymore, fall back to a regular tilemap
+            warnings.push_back(it->first + " can't be saved with the metatiles of " + it->second + " anymore, it was saved as a regular tilemap");
+            m_MetatileTilemapsJournal.Record(metatileTilemaps, it->first);
+            it = metatileTilemaps.erase(it);
+            continue;
+        }
+
+        dictionary.append_range(missing);
+        ++it;
+    }
+}
+
+Metatile Parser::GetMetatile(const Tilemap& tilemap, const size_t x, const size_t y)
+{
+    return { tilemap[y][x], tilemap[y][x + 1], tilemap[y + 1][x], tilemap[y + 1][x + 1] };
+}
+
+const Metatiles& Parser::FindMetatiles(const std::string& graphicsName)
+{
+    static const Metatiles none;
+
+    const std::unordered_map<std::string, Metatiles>::const_iterator it = metatiles.find(graphicsName);
+    return it != metatiles.end() ? it->second : none;
+}
+
+std::string Parser::GetSymbolFile(const std::string& symbolName)
+{
+    return symbols.GetFile(symbolName);
+}
+
+void Parser::PublishSnapshot()
+{
+    const std::shared_ptr<const ProjectSnapshot> previous = m_Snapshot.load();
+
+    // Publishing again would make the next edit of each store duplicate what it writes to for nothing
+    if (previous && previous->graphics.IsSharedWith(graphics) && previous->tilemaps.IsSharedWith(tilemaps) && previous->sprites.IsSharedWith(sprites)
+        && previous->roomsDoorData.IsSharedWith(roomsDoorData) && previous->animations.IsSharedWith(animations)
+        && previous->collisionTables.IsSharedWith(collisionTables) && previous->tilesets == tilesets && previous->rooms == rooms
+        && previous->doors == doors && previous->collisionTableArray == collisionTableArray)
+        return;
+
+    // The stores are copy-on-write, so the live data and the snapshot only diverge on the next edit of each asset
+    m_Snapshot.store(std::make_shared<const ProjectSnapshot>(graphics, tilemaps, sprites, roomsDoorData, animations, collisionTables, tilesets, rooms,
+        doors, collisionTableArray));
+}
+
+std::shared_ptr<const ProjectSnapshot> Parser::GetSnapshot()
+{
+    return m_Snapshot.load();
+}
+
+ProjectState Parser::BeginCapture()
+{
+    graphics.OpenJournal();
+    tilemaps.OpenJournal();
+    sprites.OpenJournal();
+    roomsDoorData.OpenJournal();
+    animations.OpenJournal();
+    collisionTables.OpenJournal();
+    symbols.OpenJournal();
+    m_MetatilesJournal.Open();
+    m_MetatileTilemapsJournal.Open();
+
+    return CaptureState();
+}
+
+void Parser::MergeCapture()
+{
+    graphics.MergeJournal();
+    tilemaps.MergeJournal();
+    sprites.MergeJournal();
+    roomsDoorData.MergeJournal();
+    animations.MergeJournal();
+    collisionTables.MergeJournal();
+    symbols.MergeJournal();
+    m_MetatilesJournal.Merge();
+    m_MetatileTilemapsJournal.Merge();
+}
+
+void Parser::EndCapture(const ProjectState& before, ProjectPatch& undo, ProjectPatch& redo)
+{
+    graphics.CloseJournal(undo.graphics, redo.graphics);
+    tilemaps.CloseJournal(undo.tilemaps, redo.tilemaps);
+    sprites.CloseJournal(undo.sprites, redo.sprites);
+    roomsDoorData.CloseJournal(undo.roomsDoorData, redo.roomsDoorData);
+    animations.CloseJournal(undo.animations, redo.animations);
+    collisionTables.CloseJournal(undo.collisionTables, redo.collisionTables);
+    symbols.CloseJournal(undo.symbols, redo.symbols);
+    m_MetatilesJournal.Close(metatiles, undo.metatiles, redo.metatiles);
+    m_MetatileTilemapsJournal.Close(metatileTilemaps, undo.metatileTilemaps, redo.metatileTilemaps);
+
+    undo.tilesets = VectorPatch<GraphicsHandle>::Diff(before.tilesets, tilesets);
+    undo.rooms = VectorPatch<Room>::Diff(before.rooms, rooms);
+    undo.doors = VectorPatch<Door>::Diff(before.doors, doors);
+    undo.collisionTableArray = VectorPatch<CollisionTableHandle>::Diff(before.collisionTableArray, collisionTableArray);
+    undo.doorHandleIds = VectorPatch<uint32_t>::Diff(before.doorHandleIds, m_DoorHandleIds);
+    undo.doorIds = VectorPatch<uint32_t>::Diff(before.doorIds, m_DoorIds);
+    undo.doorTargeters = VectorPatch<std::vector<uint8_t>>::Diff(before.doorTargeters, m_DoorTargeters);
+
+    redo.tilesets = VectorPatch<GraphicsHandle>::Diff(tilesets, before.tilesets);
+    redo.rooms = VectorPatch<Room>::Diff(rooms, before.rooms);
+    redo.doors = VectorPatch<Door>::Diff(doors, before.doors);
+    redo.collisionTableArray = VectorPatch<CollisionTableHandle>::Diff(collisionTableArray, before.collisionTableArray);
+    redo.doorHandleIds = VectorPatch<uint32_t>::Diff(m_DoorHandleIds, before.doorHandleIds);
+    redo.doorIds = VectorPatch<uint32_t>::Diff(m_DoorIds, before.doorIds);
+    redo.doorTargeters = VectorPatch<std::vector<uint8_t>>::Diff(m_DoorTargeters, before.doorTargeters);
+}
+
+void Parser::RollbackCapture(const ProjectState& before)
+{
+    // Put back without being recorded again, the enclosing capture either has these parts already or never saw them written to
+    ProjectPatch patch;
+    patch.graphics = graphics.RollbackJournal();
+    patch.tilemaps = tilemaps.RollbackJournal();
+    patch.sprites = sprites.RollbackJournal();
+    patch.roomsDoorData = roomsDoorData.RollbackJournal();
+    patch.animations = animations.RollbackJournal();
+    patch.collisionTables = collisionTables.RollbackJournal();
+    patch.symbols = symbols.RollbackJournal();
+    patch.metatiles = m_MetatilesJournal.Rollback(metatiles);
+    patch.metatileTilemaps = m_MetatileTilemapsJournal.Rollback(metatileTilemaps);
+
+    patch.tilesets = VectorPatch<GraphicsHandle>::Diff(before.tilesets, tilesets);
+    patch.rooms = VectorPatch<Room>::Diff(before.rooms, rooms);
+    patch.doors = VectorPatch<Door>::Diff(before.doors, doors);
+    patch.collisionTableArray = VectorPatch<CollisionTableHandle>::Diff(before.collisionTableArray, collisionTableArray);
+    patch.doorHandleIds = VectorPatch<uint32_t>::Diff(before.doorHandleIds, m_DoorHandleIds);
+    patch.doorIds = VectorPatch<uint32_t>::Diff(before.doorIds, m_DoorIds);
+    patch.doorTargeters = VectorPatch<std::vector<uint8_t>>::Diff(before.doorTargeters, m_DoorTargeters);
+
+    if (patch.IsEmpty())
+        return;
+
+    patch.tilesets.Apply(tilesets);
+    patch.rooms.Apply(rooms);
+    patch.doors.Apply(doors);
+    patch.collisionTableArray.Apply(collisionTableArray);
+    patch.doorHandleIds.Apply(m_DoorHandleIds);
+    patch.doorIds.Apply(m_DoorIds);
+    patch.doorTargeters.Apply(m_DoorTargeters);
+    OnPatchApplied(patch);
+}
+
+void Parser::ApplyPatch(const ProjectPatch& patch)
+{
+    graphics.Restore(patch.graphics);
+    tilemaps.Restore(patch.tilemaps);
+    sprites.Restore(patch.sprites);
+    roomsDoorData.Restore(patch.roomsDoorData);
+    animations.Restore(patch.animations);
+    collisionTables.Restore(patch.collisionTables);
+    patch.tilesets.Apply(tilesets);
+    patch.rooms.Apply(rooms);
+    patch.doors.Apply(doors);
+    patch.collisionTableArray.Apply(collisionTableArray);
+    symbols.Restore(patch.symbols);
+
+    for (const std::pair<std::string, std::optional<Metatiles>>& entry : patch.metatiles.entries)
+        m_MetatilesJournal.Record(metatiles, entry.first);
+    for (const std::pair<std::string, std::optional<std::string>>& entry : patch.metatileTilemaps.entries)
+        m_MetatileTilemapsJournal.Record(metatileTilemaps, entry.first);
+    patch.metatiles.Apply(metatiles);
+    patch.metatileTilemaps.Apply(metatileTilemaps);
+    patch.doorHandleIds.Apply(m_DoorHandleIds);
+    patch.doorIds.Apply(m_DoorIds);
+    patch.doorTargeters.Apply(m_DoorTargeters);
+
+    OnPatchApplied(patch);
+}
+
+ProjectState Parser::CaptureState()
+{
+    return { tilesets, rooms, doors, collisionTableArray, m_DoorHandleIds, m_DoorIds, m_DoorTargeters };
+}
+
+void Parser::OnPatchApplied(const ProjectPatch& patch)
+{
+    // Covers the assets that were added or removed, which the events of the edits don't
+    for (const AssetStore<Graphics>::SlotState& state : patch.graphics)
+        ChangeBus::Publish(ChangeEvent(ChangeType::Graphics, state.index));
+    for (const AssetStore<Tilemap>::SlotState& state : patch.tilemaps)
+        ChangeBus::Publish(ChangeEvent(ChangeType::Tilemap, state.index));
+    for (const AssetStore<std::vector<SpriteData>>::SlotState& state : patch.sprites)
+        ChangeBus::Publish(ChangeEvent(ChangeType::SpriteData, state.index));
+    for (const AssetStore<Animation>::SlotState& state : patch.animations)
+        ChangeBus::Publish(ChangeEvent(ChangeType::Animation, state.index));
+    for (const AssetStore<CollisionTable>::SlotState& state : patch.collisionTables)
+        ChangeBus::Publish(ChangeEvent(ChangeType::CollisionTable, state.index));
+    // The door data has no event of its own, the doors it lists stand for it
+    for (const AssetStore<DoorData>::SlotState& state : patch.roomsDoorData)
+    {
+        if (state.asset)
+        {
+            for (const uint8_t doorId : *state.asset)
+                ChangeBus::Publish(ChangeEvent::Door(doorId));
+        }
+    }
+    for (const std::pair<size_t, Room>& entry : patch.rooms.entries)
+        ChangeBus::Publish(ChangeEvent::RoomPalette(entry.first));
+    for (const std::pair<size_t, Door>& entry : patch.doors.entries)
+        ChangeBus::Publish(ChangeEvent::Door(entry.first));
+
+    ReferenceIndex::Rebuild();
+    CollisionGridCache::InvalidateAll();
+}
+
+bool_t ProjectPatch::IsEmpty() const
+{
+    return graphics.empty() && tilemaps.empty() && sprites.empty() && roomsDoorData.empty() && animations.empty() && collisionTables.empty()
+        && tilesets.IsEmpty() && rooms.IsEmpty() && doors.IsEmpty() && collisionTableArray.IsEmpty() && symbols.empty() && metatiles.IsEmpty()
+        && metatileTilemaps.IsEmpty() && doorHandleIds.IsEmpty() && doorIds.IsEmpty() && doorTargeters.IsEmpty();
+}
+
+size_t ProjectPatch::GetMemoryFootprint() const
+{
+    size_t bytes = sizeof(*this);
+
+    for (const AssetStore<Graphics>::SlotState& state : graphics)
+        bytes += sizeof(state) + state.name.capacity() + (state.asset ? state.asset->capacity() * sizeof(Tile) : 0);
+    for (const AssetStore<Tilemap>::SlotState& state : tilemaps)
+        bytes += sizeof(state) + state.name.capacity() + (state.asset ? sizeof(Tilemap) + state.asset->GetTiles().capacity() : 0);
+    for (const AssetStore<std::vector<SpriteData>>::SlotState& state : sprites)
+    {
+        bytes += sizeof(state) + state.name.capacity();
+        if (!state.asset)
+            continue;
+
+        for (const SpriteData& sprite : *state.asset)
+            bytes += sizeof(SpriteData) + sprite.id.capacity();
+    }
+    for (const AssetStore<DoorData>::SlotState& state : roomsDoorData)
+        bytes += sizeof(state) + state.name.capacity() + (state.asset ? state.asset->capacity() : 0);
+    for (const AssetStore<Animation>::SlotState& state : animations)
+    {
+        bytes += sizeof(state) + state.name.capacity();
+        if (!state.asset)
+            continue;
+
+        for (const AnimationFrame& frame : *state.asset)
+            bytes += sizeof(AnimationFrame) + frame.oam.capacity() * sizeof(OamEntry);
+    }
+    for (const AssetStore<CollisionTable>::SlotState& state : collisionTables)
+    {
+        bytes += sizeof(state) + state.name.capacity();
+        if (!state.asset)
+            continue;
+
+        for (const std::string& clipdata : *state.asset)
+            bytes += sizeof(std::string) + clipdata.capacity();
+    }
+
+    bytes += tilesets.entries.capacity() * sizeof(tilesets.entries[0]) + rooms.entries.capacity() * sizeof(rooms.entries[0])
+        + doors.entries.capacity() * sizeof(doors.entries[0]) + collisionTableArray.entries.capacity() * sizeof(collisionTableArray.entries[0])
+        + doorHandleIds.entries.capacity() * sizeof(doorHandleIds.entries[0]) + doorIds.entries.capacity() * sizeof(doorIds.entries[0]);
+
+    for (const std::pair<size_t, std::vector<uint8_t>>& entry : doorTargeters.entries)
+        bytes += sizeof(entry) + entry.second.capacity();
+    for (const SymbolRegistry::SymbolState& symbol : symbols)
+        bytes += sizeof(symbol) + symbol.name.capacity() + symbol.file.capacity();
+    for (const std::pair<std::string, std::optional<Metatiles>>& entry : metatiles.entries)
+        bytes += sizeof(entry) + entry.first.capacity() + (entry.second ? entry.second->capacity() * sizeof(Metatile) : 0);
+    for (const std::pair<std::string, std::optional<std::string>>& entry : metatileTilemaps.entries)
+        bytes += sizeof(entry) + entry.first.capacity() + (entry.second ? entry.second->capacity() : 0);
+
+    return bytes;
+}
+
+bool_t Parser::IsTileset(const GraphicsHandle graphics)
+{
+    return GetTilesetIndex(graphics) < tilesets.size();
+}
+
+size_t Parser::GetTilesetIndex(const GraphicsHandle graphics)
+{
+    // There are at most 255 tilesets
+    return std::ranges::find(tilesets, graphics) - tilesets.begin();
+}
+
 void Parser::ParseEnums()
 {
     // Look for specific enums in specific files
@@ -763,22 +1390,131 @@ void Parser::RemoveDuplicateIncludes(std::fstream& file, const std::filesystem::
     (void)rename("temp.txt", fileName.string().c_str());
 }
 
+ContentHash Parser::HashFile(const std::vector<SymbolInfo>& fileSymbols)
+{
+    ContentHash hash = ContentHash::Of(fileSymbols.size());
+
+    for (const SymbolInfo& symbol : fileSymbols)
+        hash = ContentHash::Combine(hash, HashSymbol(symbol));
+
+    return hash;
+}
+
+ContentHash Parser::HashSymbol(const SymbolInfo& symbol)
+{
+    const std::string& symbolName = symbol.second;
+    ContentHash hash = ContentHash::Of(symbolName, ContentHash::Of(static_cast<uint64_t>(symbol.first)));
+
+    // Everything the matching Save function writes has to be part of the hash
+    switch (symbol.first)
+    {
+        case SymbolType::Graphics:
+            return ContentHash::Combine(hash, AssetHashes::Get(graphics.Find(symbolName)));
+
+        case SymbolType::Tilemap:
+        {
+            hash = ContentHash::Combine(hash, AssetHashes::Get(tilemaps.Find(symbolName)));
+
+            const std::unordered_map<std::string, std::string>::const_iterator usage = metatileTilemaps.find(symbolName);
+            if (usage != metatileTilemaps.end())
+            {
+                const std::string& graphicsName = usage->second;
+                const Metatiles& dictionary = FindMetatiles(graphicsName);
+
+                hash = ContentHash::Of(graphicsName, hash);
+                hash = ContentHash::Of(static_cast<uint64_t>(GetTilesetIndex(graphics.Find(graphicsName))), hash);
+                hash = ContentHash::Of(std::span(reinterpret_cast<const uint8_t*>(dictionary.data()), dictionary.size() * sizeof(Metatile)), hash);
+            }
+            return hash;
+        }
+
+        case SymbolType::SpriteData:
+            return ContentHash::Combine(hash, AssetHashes::Get(sprites.Find(symbolName)));
+
+        case SymbolType::DoorData:
+            return ContentHash::Of(roomsDoorData.Get(symbolName), hash);
+
+        case SymbolType::Animation:
+            return ContentHash::Combine(hash, AssetHashes::Get(animations.Find(symbolName)));
+
+        case SymbolType::RoomData:
+            for (const Room& room : rooms)
+            {
+                hash = ContentHash::Of(tilemaps.GetName(room.tilemap), hash);
+                hash = ContentHash::Of(sprites.GetName(room.spriteData), hash);
+                hash = ContentHash::Of(roomsDoorData.GetName(room.doorData), hash);
+                hash = ContentHash::Of(std::span(reinterpret_cast<const uint8_t*>(room.colorPalette.data()), sizeof(Palette)), hash);
+                hash = ContentHash::Of(room.collisionTable, hash);
+            }
+            return hash;
+
+        case SymbolType::Doors:
+            for (const Door& door : doors)
+            {
+                hash = ContentHash::Of(door.x | door.y << 16 | static_cast<uint64_t>(door.ownerRoom) << 32 | static_cast<uint64_t>(door.height) << 40 |
+                    static_cast<uint64_t>(door.width) << 48 | static_cast<uint64_t>(door.targetDoor) << 56, hash);
+                hash = ContentHash::Of(static_cast<uint8_t>(door.exitX) | static_cast<uint8_t>(door.exitY) << 8 | door.tileset << 16, hash);
+            }
+            return hash;
+
+        case SymbolType::Tilesets:
+            for (const GraphicsHandle tileset : tilesets)
+                hash = ContentHash::Of(graphics.GetName(tileset), hash);
+            return hash;
+
+        case SymbolType::CollisionTable:
+            return ContentHash::Combine(hash, AssetHashes::Get(collisionTables.Find(symbolName)));
+
+        case SymbolType::CollisionTableArray:
+            for (const CollisionTableHandle collisionTable : collisionTableArray)
+                hash = ContentHash::Of(collisionTables.GetName(collisionTable), hash);
+            return hash;
+
+        case SymbolType::Metatiles:
+        {
+            const std::string graphicsName = symbolName.substr(0, symbolName.size() - sizeof("_Metatiles") + 1);
+            const Metatiles& dictionary = FindMetatiles(graphicsName);
+            return ContentHash::Of(std::span(reinterpret_cast<const uint8_t*>(dictionary.data()), dictionary.size() * sizeof(Metatile)), hash);
+        }
+
+        case SymbolType::CollisionGrid:
+        {
+            hash = ContentHash::Of(CollisionGridCache::IsExported(), hash);
+            if (!CollisionGridCache::IsExported())
+                return hash;
+
+            size_t roomId = 0;
+            while (roomId < rooms.size() && CollisionGridCache::GetSymbolName(roomId) != symbolName)
+                roomId++;
+
+            if (roomId == rooms.size())
+                return hash;
+
+            const CollisionGrid& grid = CollisionGridCache::Get(roomId);
+            hash = ContentHash::Of(grid.width | grid.height << 8, hash);
+            for (const std::string& clipdata : grid.values)
+                hash = ContentHash::Of(clipdata, hash);
+            return ContentHash::Of(grid.cells, hash);
+        }
+    }
+
+    return hash;
+}
+
 void Parser::SaveGraphics(std::fstream& file, const std::string& symbolName)
 {
     file << "\nconst u8 " << symbolName << "[] = {\n";
 
-    const Graphics& gfx = graphics[symbolName];
-    const size_t tileAmount = gfx.size() / 16;
+    const Graphics& gfx = graphics.Get(symbolName);
+    file << TAB << gfx.size() << ",\n\n";
 
-    file << TAB << tileAmount << ",\n\n";
-
-    for (size_t i = 0; i < tileAmount; i++)
+    for (const Tile& tile : gfx)
     {
         file << TAB;
-        for (size_t j = 0; j < 16; j++)
+        for (size_t j = 0; j < tile.data.size(); j++)
         {
-            file << ToHex(gfx[i * 16 + j]) << ',';
-            file << (j == 15 ? '\n' : ' ');
+            file << ToHex(tile.data[j]) << ',';
+            file << (j == tile.data.size() - 1 ? '\n' : ' ');
         }
     }
 
@@ -789,26 +1525,49 @@ void Parser::SaveTilemap(std::fstream& file, const std::string& symbolName)
 {
     file << "\nconst u8 " << symbolName << "[] = {\n";
 
-    const Tilemap& tilemap = tilemaps[symbolName];
+    const Tilemap& tilemap = tilemaps.Get(symbolName);
 
-    file << TAB << tilemap[0].size() << ", " << tilemap.size() << ",\n\n";
+    std::vector<uint8_t> values;
 
-    uint8_t count = 0;
-    uint8_t value = tilemap[0][0];
-    for (const std::vector<uint8_t>& row : tilemap)
+    const std::unordered_map<std::string, std::string>::const_iterator usage = metatileTilemaps.find(symbolName);
+    if (usage != metatileTilemaps.end())
     {
-        for (const uint8_t v : row)
+        const std::string& graphicsName = usage->second;
+        const Metatiles& dictionary = FindMetatiles(graphicsName);
+        const size_t tileset = GetTilesetIndex(graphics.Find(graphicsName));
+
+        file << TAB "METATILEMAP(" << tilemap.GetWidth() / 2 << "), " << tilemap.GetHeight() / 2 << ", " << tileset << ",\n\n";
+
+        std::map<Metatile, uint8_t> indices;
+        for (size_t i = 0; i < dictionary.size(); i++)
+            indices.emplace(dictionary[i], static_cast<uint8_t>(i));
+
+        for (size_t y = 0; y < tilemap.GetHeight(); y += 2)
         {
-            if (v == value)
-            {
-                count++;
-                continue;
-            }
+            for (size_t x = 0; x < tilemap.GetWidth(); x += 2)
+                values.push_back(indices[GetMetatile(tilemap, x, y)]);
+        }
+    }
+    else
+    {
+        file << TAB << tilemap.GetWidth() << ", " << tilemap.GetHeight() << ",\n\n";
+
+        values = tilemap.GetTiles();
+    }
 
-            file << TAB << ToHex(count) << ", " << ToHex(value) << ",\n";
-            count = 1;
-            value = v;
+    uint8_t count = 0;
+    uint8_t value = values[0];
+    for (const uint8_t v : values)
+    {
+        if (v == value && count != 0xFF)
+        {
+            count++;
+            continue;
         }
+
+        file << TAB << ToHex(count) << ", " << ToHex(value) << ",\n";
+        count = 1;
+        value = v;
     }
 
     file << TAB << ToHex(count) << ", " << ToHex(value) << ",\n" TAB "0x00, 0x00,\n};\n";
@@ -818,7 +1577,7 @@ void Parser::SaveSpriteData(std::fstream& file, const std::string& symbolName)
 {
     file << "\nconst struct RoomSprite " << symbolName << "[] = {\n";
 
-    const std::vector<SpriteData>& spriteData = sprites[symbolName];
+    const std::vector<SpriteData>& spriteData = sprites.Get(symbolName);
 
     for (size_t i = 0; i < spriteData.size(); i++)
     {
@@ -837,7 +1596,7 @@ void Parser::SaveDoorData(std::fstream& file, const std::string& symbolName)
 {
     file << "\nconst u8 " << symbolName << "[] = {\n";
 
-    const DoorData& doorData = roomsDoorData[symbolName];
+    const DoorData& doorData = roomsDoorData.Get(symbolName);
 
     for (const uint8_t doorId : doorData)
         file << TAB << static_cast<size_t>(doorId) << ",\n";
@@ -847,7 +1606,7 @@ void Parser::SaveDoorData(std::fstream& file, const std::string& symbolName)
 
 void Parser::SaveAnimation(std::fstream& file, const std::string& symbolName)
 {
-    const Animation& animation = animations[symbolName];
+    const Animation& animation = animations.Get(symbolName);
 
     for (size_t i = 0; i < animation.size(); i++)
     {
@@ -888,10 +1647,10 @@ void Parser::SaveRoomData(std::fstream& file, const std::string& symbolName)
     for (size_t i = 0; i < rooms.size(); i++)
     {
         file << TAB "[" << i << "] = {\n";
-        file << TAB TAB ".tilemap = " << rooms[i].tilemap << ",\n";
+        file << TAB TAB ".tilemap = " << tilemaps.GetName(rooms[i].tilemap) << ",\n";
         file << TAB TAB ".bgPalette = " << MakePalette(rooms[i].colorPalette) << ",\n";
-        file << TAB TAB ".spriteData = " << rooms[i].spriteData << ",\n";
-        file << TAB TAB ".doorData = " << rooms[i].doorData << ",\n";
+        file << TAB TAB ".spriteData = " << sprites.GetName(rooms[i].spriteData) << ",\n";
+        file << TAB TAB ".doorData = " << roomsDoorData.GetName(rooms[i].doorData) << ",\n";
         file << TAB TAB ".collisionTable = " << static_cast<size_t>(rooms[i].collisionTable) << ",\n";
         file << TAB "},\n";
     }
@@ -925,15 +1684,15 @@ void Parser::SaveTilesets(std::fstream& file, const std::string& symbolName)
 {
     file << "\nconst u8* const " << symbolName << "[] = {\n";
 
-    for (const std::string& tileset : tilesets)
-        file << TAB << tileset << ",\n";
+    for (const GraphicsHandle tileset : tilesets)
+        file << TAB << graphics.GetName(tileset) << ",\n";
 
     file << "};\n";
 }
 
 void Parser::SaveCollisionTable(std::fstream& file, const std::string& symbolName)
 {
-    const CollisionTable& collisionTable = collisionTables[symbolName];
+    const CollisionTable& collisionTable = collisionTables.Get(symbolName);
 
     file << "\nconst u8 " << symbolName << "[] = {\n";
 
@@ -947,8 +1706,61 @@ void Parser::SaveCollisionTableArray(std::fstream& file, const std::string& symb
 {
     file << "\nconst u8* const " << symbolName << "[] = {\n";
 
-    for (const std::string& collisionTable : collisionTableArray)
-        file << TAB << collisionTable << ",\n";
+    for (const CollisionTableHandle collisionTable : collisionTableArray)
+        file << TAB << collisionTables.GetName(collisionTable) << ",\n";
+
+    file << "};\n";
+}
+
+void Parser::SaveMetatiles(std::fstream& file, const std::string& symbolName)
+{
+    file << "\nconst u8 " << symbolName << "[] = {\n";
+
+    const std::string graphicsName = symbolName.substr(0, symbolName.size() - sizeof("_Metatiles") + 1);
+    const Metatiles& dictionary = FindMetatiles(graphicsName);
+
+    file << TAB << dictionary.size() << ",\n\n";
+
+    for (const Metatile& metatile : dictionary)
+        file << TAB << ToHex(metatile[0]) << ", " << ToHex(metatile[1]) << ", " << ToHex(metatile[2]) << ", " << ToHex(metatile[3]) << ",\n";
+
+    file << "};\n";
+}
+
+void Parser::SaveCollisionGrid(std::fstream& file, const std::string& symbolName)
+{
+    // Disabling the export removes the grids from the files
+    if (!CollisionGridCache::IsExported())
+        return;
+
+    size_t roomId = 0;
+    while (roomId < rooms.size() && CollisionGridCache::GetSymbolName(roomId) != symbolName)
+        roomId++;
+
+    if (roomId == rooms.size())
+        return;
+
+    const CollisionGrid& grid = CollisionGridCache::Get(roomId);
+    const std::vector<std::string> values = grid.GetUsedValues();
+    const std::vector<uint8_t> packed = grid.Pack(values);
+
+    file << "\nconst u8 " << symbolName << "[] = {\n";
+    file << TAB << static_cast<size_t>(CollisionGrid::GetBitsPerTile(values.size())) << ", ";
+    file << static_cast<size_t>(grid.width) << ", " << static_cast<size_t>(grid.height) << ", " << values.size() << ",\n";
+
+    for (const std::string& clipdata : values)
+        file << TAB << clipdata << ",\n";
+
+    file << '\n';
+
+    for (size_t i = 0; i < packed.size(); i++)
+    {
+        if (i % 16 == 0)
+            file << TAB;
+
+        file << ToHex(packed[i]) << ',';
+        file << (i % 16 == 15 || i == packed.size() - 1 ? '\n' : ' ');
+    }
 
     file << "};\n";
 }
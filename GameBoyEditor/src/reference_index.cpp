@@ -0,0 +1,327 @@
+﻿#include "reference_index.hpp"
+
+#include <algorithm>
+#include <ranges>
+
+#include "sprite_vram_planner.hpp"
+#include "tileset_delta_planner.hpp"
+
+void ReferenceIndex::Rebuild()
+{
+    m_Tilemaps.clear();
+    m_GraphicsTilemaps.clear();
+
+    for (std::vector<OamReference>& references : m_OamReferences)
+        references.clear();
+    m_Animations.clear();
+
+    m_CollisionTableRooms.clear();
+
+    for (const TilemapHandle handle : Parser::tilemaps.GetHandles())
+        (void)GetUsage(handle);
+
+    // Tilemaps saved as metatiles know their tileset
+    for (const std::pair<const std::string, std::string>& association : Parser::metatileTilemaps)
+        SetTilemapGraphics(Parser::tilemaps.Find(association.first), Parser::graphics.Find(association.second));
+
+    // Otherwise guess from the tilesets loaded by the doors leading to the room, the room editor corrects it when painting
+    const std::vector<std::vector<uint8_t>> roomTilesets = TilesetDeltaPlanner::ComputeRoomTilesets();
+    for (size_t i = 0; i < Parser::rooms.size(); i++)
+    {
+        if (roomTilesets[i].empty() || roomTilesets[i].front() >= Parser::tilesets.size() || !GetTilemapGraphics(Parser::rooms[i].tilemap).IsNull())
+            continue;
+
+        SetTilemapGraphics(Parser::rooms[i].tilemap, Parser::tilesets[roomTilesets[i].front()], true);
+    }
+
+    for (const AnimationHandle handle : Parser::animations.GetHandles())
+        UpdateAnimation(handle);
+
+    for (size_t i = 0; i < Parser::rooms.size(); i++)
+        AddRoom(i);
+}
+
+void ReferenceIndex::UpdateTile(const TilemapHandle tilemap, const size_t x, const size_t y)
+{
+    if (!Parser::tilemaps.IsValid(tilemap))
+        return;
+
+    TilemapUsage& usage = GetUsage(tilemap);
+    const Tilemap& t = Parser::tilemaps.Get(tilemap);
+
+    if (usage.tiles.size() != t.GetSize())
+    {
+        IndexTilemap(usage);
+        return;
+    }
+
+    const uint32_t cell = static_cast<uint32_t>(y * t.GetWidth() + x);
+    const uint8_t tile = t[y][x];
+
+    if (usage.tiles[cell] == tile)
+        return;
+
+    RemoveCell(usage, cell);
+    AddCell(usage, cell, tile);
+}
+
+void ReferenceIndex::InvalidateTilemap(const TilemapHandle tilemap)
+{
+    if (Parser::tilemaps.IsValid(tilemap))
+        IndexTilemap(GetUsage(tilemap));
+}
+
+void ReferenceIndex::SetTilemapGraphics(const TilemapHandle tilemap, const GraphicsHandle graphics, const bool_t guessed)
+{
+    if (!Parser::tilemaps.IsValid(tilemap))
+        return;
+
+    TilemapUsage& usage = GetUsage(tilemap);
+    usage.graphicsGuessed = guessed;
+    if (usage.graphics == graphics)
+        return;
+
+    UnlinkGraphics(tilemap, usage.graphics);
+    usage.graphics = graphics;
+    LinkGraphics(tilemap, graphics);
+}
+
+GraphicsHandle ReferenceIndex::GetTilemapGraphics(const TilemapHandle tilemap)
+{
+    if (tilemap.index >= m_Tilemaps.size() || m_Tilemaps[tilemap.index].tilemap != tilemap)
+        return {};
+
+    return m_Tilemaps[tilemap.index].graphics;
+}
+
+bool_t ReferenceIndex::IsTilemapGraphicsGuessed(const TilemapHandle tilemap)
+{
+    return tilemap.index < m_Tilemaps.size() && m_Tilemaps[tilemap.index].tilemap == tilemap && m_Tilemaps[tilemap.index].graphicsGuessed;
+}
+
+void ReferenceIndex::UpdateAnimation(const AnimationHandle animation)
+{
+    AnimationUsage& usage = m_Animations[animation.index];
+
+    // Only the lists of the tiles the animation used before can contain it
+    for (const uint8_t tile : usage.tiles)
+        std::erase_if(m_OamReferences[tile], [animation](const OamReference& reference) { return reference.animation.index == animation.index; });
+
+    usage.tiles.clear();
+
+    if (!Parser::animations.IsValid(animation))
+    {
+        m_Animations.erase(animation.index);
+        return;
+    }
+
+    if (usage.animation != animation)
+    {
+        usage.animation = animation;
+        usage.graphics = {};
+    }
+
+    const Animation& a = Parser::animations.Get(animation);
+    for (size_t frame = 0; frame < a.size(); frame++)
+    {
+        for (size_t entry = 0; entry < a[frame].oam.size(); entry++)
+        {
+            const uint8_t tile = a[frame].oam[entry].tileIndex;
+
+            m_OamReferences[tile].emplace_back(animation, static_cast<uint16_t>(frame), static_cast<uint8_t>(entry));
+            if (!std::ranges::contains(usage.tiles, tile))
+                usage.tiles.push_back(tile);
+        }
+    }
+}
+
+void ReferenceIndex::SetAnimationGraphics(const AnimationHandle animation, const GraphicsHandle graphics)
+{
+    if (!Parser::animations.IsValid(animation))
+        return;
+
+    AnimationUsage& usage = m_Animations[animation.index];
+    if (usage.animation != animation)
+    {
+        usage.animation = animation;
+        usage.tiles.clear();
+    }
+
+    usage.graphics = graphics;
+}
+
+GraphicsHandle ReferenceIndex::GetAnimationGraphics(const AnimationHandle animation)
+{
+    const std::unordered_map<uint32_t, AnimationUsage>::const_iterator it = m_Animations.find(animation.index);
+    if (it != m_Animations.end() && it->second.animation == animation && Parser::graphics.IsValid(it->second.graphics))
+        return it->second.graphics;
+
+    return SpriteVramPlanner::graphics;
+}
+
+void ReferenceIndex::AddRoom(const size_t roomId)
+{
+    const uint8_t collisionTable = Parser::rooms[roomId].collisionTable;
+
+    if (collisionTable >= m_CollisionTableRooms.size())
+        m_CollisionTableRooms.resize(collisionTable + 1);
+
+    m_CollisionTableRooms[collisionTable].push_back(static_cast<uint8_t>(roomId));
+}
+
+const std::vector<uint32_t>& ReferenceIndex::GetTileCells(const TilemapHandle tilemap, const uint8_t tile)
+{
+    static const std::vector<uint32_t> none;
+
+    if (!Parser::tilemaps.IsValid(tilemap))
+        return none;
+
+    return GetUsage(tilemap).cells[tile];
+}
+
+std::vector<TilemapHandle> ReferenceIndex::GetTilemapsUsingTile(const GraphicsHandle graphics, const uint8_t tile)
+{
+    std::vector<TilemapHandle> result;
+
+    const std::unordered_map<uint32_t, std::vector<TilemapHandle>>::const_iterator it = m_GraphicsTilemaps.find(graphics.index);
+    if (it == m_GraphicsTilemaps.end() || !Parser::graphics.IsValid(graphics))
+        return result;
+
+    for (const TilemapHandle tilemap : it->second)
+    {
+        if (!GetTileCells(tilemap, tile).empty())
+            result.push_back(tilemap);
+    }
+
+    return result;
+}
+
+std::vector<OamReference> ReferenceIndex::GetOamUsingTile(const GraphicsHandle graphics, const uint8_t tile)
+{
+    std::vector<OamReference> result;
+
+    for (const OamReference& reference : m_OamReferences[tile])
+    {
+        if (GetAnimationGraphics(reference.animation) == graphics)
+            result.push_back(reference);
+    }
+
+    return result;
+}
+
+GraphicsUsages ReferenceIndex::GetGraphicsUsages(const GraphicsHandle graphics)
+{
+    GraphicsUsages usages;
+
+    if (!Parser::graphics.IsValid(graphics))
+        return usages;
+
+    for (size_t i = 0; i < Parser::tilesets.size(); i++)
+    {
+        if (Parser::tilesets[i] == graphics)
+            usages.tilesets.push_back(i);
+    }
+
+    const std::unordered_map<uint32_t, std::vector<TilemapHandle>>::const_iterator it = m_GraphicsTilemaps.find(graphics.index);
+    if (it != m_GraphicsTilemaps.end())
+        usages.tilemaps = it->second;
+
+    for (const AnimationUsage& usage : m_Animations | std::views::values)
+    {
+        if (!usage.tiles.empty() && GetAnimationGraphics(usage.animation) == graphics)
+            usages.animations.push_back(usage.animation);
+    }
+
+    return usages;
+}
+
+const std::vector<uint8_t>& ReferenceIndex::GetRoomsUsingCollisionTable(const size_t collisionTable)
+{
+    static const std::vector<uint8_t> none;
+    return collisionTable < m_CollisionTableRooms.size() ? m_CollisionTableRooms[collisionTable] : none;
+}
+
+std::vector<uint8_t> ReferenceIndex::GetDoorsTargetingRoom(const size_t roomId)
+{
+    std::vector<uint8_t> result;
+
+    if (roomId >= Parser::rooms.size())
+        return result;
+
+    // A room has at most a few doors, each knowing which doors lead to it
+    for (const uint8_t doorId : Parser::roomsDoorData.Get(Parser::rooms[roomId].doorData))
+    {
+        const std::vector<uint8_t>& targeting = Parser::GetDoorsTargeting(doorId);
+        result.insert(result.end(), targeting.begin(), targeting.end());
+    }
+
+    return result;
+}
+
+ReferenceIndex::TilemapUsage& ReferenceIndex::GetUsage(const TilemapHandle tilemap)
+{
+    if (tilemap.index >= m_Tilemaps.size())
+        m_Tilemaps.resize(tilemap.index + 1);
+
+    TilemapUsage& usage = m_Tilemaps[tilemap.index];
+
+    // The slot was reused by another tilemap
+    if (usage.tilemap != tilemap)
+    {
+        UnlinkGraphics(usage.tilemap, usage.graphics);
+        usage.tilemap = tilemap;
+        usage.graphics = {};
+        IndexTilemap(usage);
+    }
+
+    return usage;
+}
+
+void ReferenceIndex::IndexTilemap(TilemapUsage& usage)
+{
+    const Tilemap& tilemap = Parser::tilemaps.Get(usage.tilemap);
+
+    usage.tiles = tilemap.GetTiles();
+    usage.slots.resize(usage.tiles.size());
+
+    for (std::vector<uint32_t>& cells : usage.cells)
+        cells.clear();
+
+    for (uint32_t cell = 0; cell < usage.tiles.size(); cell++)
+        AddCell(usage, cell, usage.tiles[cell]);
+}
+
+void ReferenceIndex::RemoveCell(TilemapUsage& usage, const uint32_t cell)
+{
+    std::vector<uint32_t>& cells = usage.cells[usage.tiles[cell]];
+
+    // Swap with the last cell of the list, which takes the slot of the removed one
+    const uint32_t slot = usage.slots[cell];
+    cells[slot] = cells.back();
+    usage.slots[cells[slot]] = slot;
+    cells.pop_back();
+}
+
+void ReferenceIndex::AddCell(TilemapUsage& usage, const uint32_t cell, const uint8_t tile)
+{
+    std::vector<uint32_t>& cells = usage.cells[tile];
+
+    usage.tiles[cell] = tile;
+    usage.slots[cell] = static_cast<uint32_t>(cells.size());
+    cells.push_back(cell);
+}
+
+void ReferenceIndex::LinkGraphics(const TilemapHandle tilemap, const GraphicsHandle graphics)
+{
+    if (!graphics.IsNull())
+        m_GraphicsTilemaps[graphics.index].push_back(tilemap);
+}
+
+void ReferenceIndex::UnlinkGraphics(const TilemapHandle tilemap, const GraphicsHandle graphics)
+{
+    if (graphics.IsNull())
+        return;
+
+    std::vector<TilemapHandle>& tilemaps = m_GraphicsTilemaps[graphics.index];
+    std::erase(tilemaps, tilemap);
+}
@@ -27,6 +27,7 @@ void RenderTarget::SetSize(const int32_t width, const int32_t height)
 {
     m_Width = width;
     m_Height = height;
+    m_HasInputs = false;
 
     // m_Texture.SetData(width, height, nullptr);
 
@@ -51,8 +52,23 @@ void RenderTarget::Unbind() const
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+bool_t RenderTarget::UpdateInputs(const ContentHash& inputs) const
+{
+    if (m_HasInputs && m_Inputs == inputs)
+    {
+        m_PassesSkipped++;
+        return false;
+    }
+
+    m_Inputs = inputs;
+    m_HasInputs = true;
+    return true;
+}
+
 void RenderTarget::Render() const
 {
+    m_PassesExecuted++;
+
     Bind();
     glClearColor(0, 0, 0, 0);
     glClear(GL_COLOR_BUFFER_BIT);
@@ -68,6 +84,14 @@ void RenderTarget::Draw() const
 
 const Texture& RenderTarget::GetTexture() const { return m_Texture; }
 
+void RenderTarget::EndFrame()
+{
+    m_LastPassesExecuted = m_PassesExecuted;
+    m_LastPassesSkipped = m_PassesSkipped;
+    m_PassesExecuted = 0;
+    m_PassesSkipped = 0;
+}
+
 ImVec2 RenderTarget::GetSize() const
 {
     return ImVec2(static_cast<float_t>(m_Width) * scale, static_cast<float_t>(m_Height) * scale); 
@@ -0,0 +1,35 @@
+﻿#include "rle.hpp"
+
+#include <algorithm>
+
+void Rle::Encode(const std::span<const uint8_t> values, std::pmr::vector<uint8_t>& output)
+{
+    size_t i = 0;
+    while (i < values.size())
+    {
+        uint8_t count = 1;
+        while (i + count < values.size() && values[i + count] == values[i] && count != 0xFF)
+            count++;
+
+        output.push_back(count);
+        output.push_back(values[i]);
+        i += count;
+    }
+}
+
+size_t Rle::Decode(const std::span<const uint8_t> input, const std::span<uint8_t> values)
+{
+    size_t read = 0;
+    size_t written = 0;
+
+    while (written < values.size() && read + 1 < input.size())
+    {
+        const size_t count = std::min<size_t>(input[read], values.size() - written);
+        std::fill_n(values.begin() + static_cast<int64_t>(written), count, input[read + 1]);
+
+        written += count;
+        read += 2;
+    }
+
+    return read;
+}
@@ -0,0 +1,211 @@
+﻿#include "sprite_vram_planner.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cctype>
+#include <fstream>
+#include <numeric>
+#include <ranges>
+#include <unordered_map>
+
+#include "application.hpp"
+#include "parser.hpp"
+
+#define TAB "    "
+
+void SpriteVramPlanner::GuessSpriteAnimations()
+{
+    spriteAnimations.clear();
+
+    const auto normalize = [](const std::string_view name) -> std::string
+    {
+        std::string result;
+        for (const char_t c : name)
+        {
+            if (c != '_')
+                result += static_cast<char_t>(std::tolower(static_cast<unsigned char>(c)));
+        }
+
+        return result;
+    };
+
+    // STYPE_GREEN_SLIME is expected to use animations such as sGreenSlime_Idle
+    for (const std::string& id : Parser::spriteIds)
+    {
+        if (id == "STYPE_NONE")
+            continue;
+
+        const std::string key = normalize(std::string_view(id).substr(sizeof("STYPE_") - 1));
+        std::vector<AnimationHandle>& animations = spriteAnimations[id];
+
+        for (const AnimationHandle animation : Parser::animations.GetHandles())
+        {
+            if (normalize(Parser::animations.GetName(animation)).contains(key))
+                animations.push_back(animation);
+        }
+
+        std::ranges::sort(animations, std::less(), [](const AnimationHandle animation) -> const std::string& { return Parser::animations.GetName(animation); });
+    }
+}
+
+void SpriteVramPlanner::Compute()
+{
+    tileSlots.assign(256, 0xFF);
+    roomTiles.assign(Parser::rooms.size(), {});
+
+    const std::vector<uint8_t> canonical = ComputeCanonicalTiles();
+
+    // Tiles each room may have to display at the same time
+    std::vector<std::bitset<256>> roomUsage(Parser::rooms.size());
+    for (size_t i = 0; i < Parser::rooms.size(); i++)
+    {
+        for (const SpriteData& sprite : Parser::sprites.Get(Parser::rooms[i].spriteData))
+        {
+            for (const AnimationHandle animation : spriteAnimations[sprite.id])
+            {
+                for (const AnimationFrame& frame : Parser::animations.Get(animation))
+                {
+                    for (const OamEntry& entry : frame.oam)
+                        roomUsage[i].set(canonical[entry.tileIndex]);
+                }
+            }
+        }
+    }
+
+    // Two tiles conflict if they're needed by the same room, tiles that never meet can share a slot
+    std::array<std::bitset<256>, 256> conflicts {};
+    std::array<size_t, 256> roomCount {};
+    for (const std::bitset<256>& usage : roomUsage)
+    {
+        for (size_t tile = 0; tile < 256; tile++)
+        {
+            if (!usage.test(tile))
+                continue;
+
+            conflicts[tile] |= usage;
+            roomCount[tile]++;
+        }
+    }
+
+    // Greedy coloring, the most shared tiles get the lowest slots
+    std::array<size_t, 256> order;
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(order, std::greater(), [&roomCount](const size_t tile) { return roomCount[tile]; });
+
+    for (const size_t tile : order)
+    {
+        if (roomCount[tile] == 0)
+            break;
+
+        std::bitset<256> taken;
+        for (size_t other = 0; other < 256; other++)
+        {
+            if (other != tile && conflicts[tile].test(other) && tileSlots[other] != 0xFF)
+                taken.set(tileSlots[other]);
+        }
+
+        size_t slot = 0;
+        while (taken.test(slot))
+            slot++;
+
+        tileSlots[tile] = static_cast<uint8_t>(slot);
+    }
+
+    // Duplicated tiles use the slot of their first copy
+    for (size_t tile = 0; tile < 256; tile++)
+        tileSlots[tile] = tileSlots[canonical[tile]];
+
+    for (size_t i = 0; i < roomUsage.size(); i++)
+    {
+        for (size_t tile = 0; tile < 256; tile++)
+        {
+            if (!roomUsage[i].test(tile))
+                continue;
+
+            const uint8_t slot = tileSlots[tile];
+            if (roomTiles[i].size() <= slot)
+                roomTiles[i].resize(slot + 1, 0xFF);
+
+            roomTiles[i][slot] = static_cast<uint8_t>(tile);
+        }
+    }
+}
+
+void SpriteVramPlanner::Export()
+{
+    Compute();
+
+    const std::string headerFile = Application::projectPath + R"(\include\data\sprite_vram.h)";
+    const std::string sourceFile = Application::projectPath + R"(\src\data\sprite_vram.c)";
+
+    std::ofstream file;
+    file.open(headerFile);
+
+    file << "#ifndef SPRITE_VRAM_H\n#define SPRITE_VRAM_H\n\n#include \"types.h\"\n\n";
+    file << "extern const u8 sSpriteTileSlots[];\n";
+    file << "extern const u8* const sRoomSpriteTiles[];\n";
+    file << "\n#endif /* SPRITE_VRAM_H */\n";
+
+    file.close();
+
+    file.open(sourceFile);
+
+    file << "#include \"data/sprite_vram.h\"\n";
+
+    // Maps an OAM tile index to its VRAM slot
+    file << "\nconst u8 sSpriteTileSlots[] = {\n";
+    for (size_t i = 0; i < tileSlots.size(); i++)
+    {
+        if (i % 16 == 0)
+            file << TAB;
+
+        file << static_cast<size_t>(tileSlots[i]) << ',';
+        file << (i % 16 == 15 ? '\n' : ' ');
+    }
+    file << "};\n";
+
+    // Tiles of the graphics set to copy in each VRAM slot when loading a room
+    for (size_t i = 0; i < roomTiles.size(); i++)
+    {
+        file << "\nstatic const u8 sRoom" << i << "_SpriteTiles[] = {\n";
+        file << TAB << roomTiles[i].size() << ",\n";
+
+        for (size_t j = 0; j < roomTiles[i].size(); j++)
+        {
+            if (j % 16 == 0)
+                file << TAB;
+
+            file << static_cast<size_t>(roomTiles[i][j]) << ',';
+            file << (j % 16 == 15 || j == roomTiles[i].size() - 1 ? '\n' : ' ');
+        }
+
+        file << "};\n";
+    }
+
+    file << "\nconst u8* const sRoomSpriteTiles[] = {\n";
+    for (size_t i = 0; i < roomTiles.size(); i++)
+        file << TAB << "sRoom" << i << "_SpriteTiles,\n";
+    file << "};\n";
+
+    file.close();
+}
+
+std::vector<uint8_t> SpriteVramPlanner::ComputeCanonicalTiles()
+{
+    std::vector<uint8_t> canonical(256);
+    std::iota(canonical.begin(), canonical.end(), static_cast<uint8_t>(0));
+
+    if (!Parser::graphics.IsValid(graphics))
+        return canonical;
+
+    const Graphics& gfx = Parser::graphics.Get(graphics);
+    const size_t tileCount = std::min<size_t>(gfx.size(), 256);
+
+    // First occurrence of each distinct tile
+    std::unordered_map<Tile, uint8_t> firstIndices;
+    for (size_t tile = 0; tile < tileCount; tile++)
+        canonical[tile] = firstIndices.try_emplace(gfx[tile], static_cast<uint8_t>(tile)).first->second;
+
+    return canonical;
+}
@@ -0,0 +1,140 @@
+﻿#include "symbol_registry.hpp"
+
+#include <algorithm>
+
+bool_t SymbolRegistry::Add(const std::string& file, const std::string& symbolName, const SymbolType type)
+{
+    Record(symbolName, type);
+    return AddSymbol(file, symbolName, type);
+}
+
+bool_t SymbolRegistry::Remove(const std::string& symbolName)
+{
+    // The type is only recorded for a symbol that doesn't exist, which removing leaves as is
+    Record(symbolName, SymbolType::Graphics);
+    return RemoveSymbol(symbolName);
+}
+
+bool_t SymbolRegistry::AddSymbol(const std::string& file, const std::string& symbolName, const SymbolType type)
+{
+    if (!m_Symbols.try_emplace(symbolName, file, type).second)
+        return false;
+
+    m_Files[file].emplace_back(type, symbolName);
+
+    std::vector<std::string>& sorted = m_SortedSymbols[static_cast<size_t>(type)];
+    sorted.insert(std::ranges::lower_bound(sorted, symbolName), symbolName);
+
+    return true;
+}
+
+bool_t SymbolRegistry::RemoveSymbol(const std::string& symbolName)
+{
+    const std::unordered_map<std::string, Entry>::const_iterator it = m_Symbols.find(symbolName);
+    if (it == m_Symbols.end())
+        return false;
+
+    const Entry& entry = it->second;
+
+    std::vector<SymbolInfo>& fileSymbols = m_Files[entry.file];
+    std::erase(fileSymbols, SymbolInfo(entry.type, symbolName));
+    if (fileSymbols.empty())
+        m_Files.erase(entry.file);
+
+    std::vector<std::string>& sorted = m_SortedSymbols[static_cast<size_t>(entry.type)];
+    sorted.erase(std::ranges::lower_bound(sorted, symbolName));
+
+    m_Symbols.erase(it);
+    return true;
+}
+
+void SymbolRegistry::Clear()
+{
+    m_Symbols.clear();
+    m_Files.clear();
+
+    for (std::vector<std::string>& sorted : m_SortedSymbols)
+        sorted.clear();
+}
+
+bool_t SymbolRegistry::Contains(const std::string& symbolName) const
+{
+    return m_Symbols.contains(symbolName);
+}
+
+const std::string& SymbolRegistry::GetFile(const std::string& symbolName) const
+{
+    static const std::string none;
+
+    const std::unordered_map<std::string, Entry>::const_iterator it = m_Symbols.find(symbolName);
+    return it != m_Symbols.end() ? it->second.file : none;
+}
+
+const std::vector<std::string>& SymbolRegistry::GetSymbols(const SymbolType type) const
+{
+    return m_SortedSymbols[static_cast<size_t>(type)];
+}
+
+const std::unordered_map<std::string, std::vector<SymbolInfo>>& SymbolRegistry::GetFiles() const
+{
+    return m_Files;
+}
+
+size_t SymbolRegistry::GetSize() const
+{
+    return m_Symbols.size();
+}
+
+void SymbolRegistry::Restore(const std::vector<SymbolState>& symbols)
+{
+    for (const SymbolState& symbol : symbols)
+        Record(symbol.name, symbol.type);
+
+    Put(symbols);
+}
+
+void SymbolRegistry::CloseJournal(std::vector<SymbolState>& before, std::vector<SymbolState>& after)
+{
+    for (SymbolState& symbol : m_Journal.Close())
+    {
+        SymbolState current = GetState(symbol.name, symbol.type);
+        if (current.file == symbol.file && (current.file.empty() || current.type == symbol.type))
+            continue;
+
+        before.push_back(std::move(symbol));
+        after.push_back(std::move(current));
+    }
+}
+
+std::vector<SymbolRegistry::SymbolState> SymbolRegistry::RollbackJournal()
+{
+    std::vector<SymbolState> symbols = m_Journal.Close();
+    Put(symbols);
+    return symbols;
+}
+
+void SymbolRegistry::Record(const std::string& symbolName, const SymbolType type)
+{
+    if (m_Journal.ShouldRecord(symbolName))
+        m_Journal.Record(GetState(symbolName, type));
+}
+
+SymbolRegistry::SymbolState SymbolRegistry::GetState(const std::string& symbolName, const SymbolType type) const
+{
+    const std::unordered_map<std::string, Entry>::const_iterator it = m_Symbols.find(symbolName);
+    if (it == m_Symbols.end())
+        return SymbolState(symbolName, std::string(), type);
+
+    return SymbolState(symbolName, it->second.file, it->second.type);
+}
+
+void SymbolRegistry::Put(const std::vector<SymbolState>& symbols)
+{
+    for (const SymbolState& symbol : symbols)
+    {
+        // The symbol may be in another file now
+        (void)RemoveSymbol(symbol.name);
+        if (!symbol.file.empty())
+            (void)AddSymbol(symbol.file, symbol.name, symbol.type);
+    }
+}
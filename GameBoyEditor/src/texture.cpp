@@ -23,6 +23,19 @@ void Texture::SetData(const int32_t internalFormat, const int32_t inputFormat, c
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+void Texture::SetSubData(const int32_t inputFormat, const int32_t x, const int32_t y, const int32_t width, const int32_t height, const void* const data) const
+{
+    glBindTexture(GL_TEXTURE_2D, m_TextureId);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, inputFormat, GL_UNSIGNED_BYTE, data);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::Destroy()
+{
+    glDeleteTextures(1, &m_TextureId);
+    m_TextureId = 0;
+}
+
 void Texture::Bind() const
 {
     glBindTexture(GL_TEXTURE_2D, m_TextureId);
@@ -0,0 +1,206 @@
+﻿#include "texture_cache.hpp"
+
+#include <algorithm>
+
+#include "glad/glad.h"
+
+void TextureCache::Init()
+{
+    m_Empty.Create();
+    m_Empty.SetData(GL_RG8, GL_RG, 1, 1, nullptr);
+
+    glGenBuffers(1, &m_PixelBuffer);
+    ChangeBus::Subscribe(OnChange, ChangeBus::MaskOf(ChangeType::Graphics) | ChangeBus::MaskOf(ChangeType::Tilemap));
+}
+
+void TextureCache::Clear()
+{
+    for (Entry& entry : m_Graphics)
+        Release(entry);
+
+    for (Entry& entry : m_Tilemaps)
+        Release(entry);
+
+    m_Graphics.clear();
+    m_Tilemaps.clear();
+}
+
+const Texture& TextureCache::Get(const GraphicsHandle graphics)
+{
+    if (!Parser::graphics.IsValid(graphics))
+        return m_Empty;
+
+    const Graphics& tiles = Parser::graphics.Get(graphics);
+    const std::span<const uint8_t> data(reinterpret_cast<const uint8_t*>(tiles.data()), tiles.size() * sizeof(Tile));
+
+    return Update(m_Graphics, graphics.index, graphics.generation, static_cast<int32_t>(data.size()), 8, GL_RG8, GL_RG, 2, data);
+}
+
+const Texture& TextureCache::Get(const TilemapHandle tilemap)
+{
+    if (!Parser::tilemaps.IsValid(tilemap))
+        return m_Empty;
+
+    const Tilemap::ConstView view = Parser::tilemaps.Get(tilemap).GetView();
+    const std::span<const uint8_t> data(view.data_handle(), view.size());
+
+    return Update(m_Tilemaps, tilemap.index, tilemap.generation, static_cast<int32_t>(data.size()), view.extent(1), GL_R8, GL_RED, 1, data);
+}
+
+uint64_t TextureCache::GetVersion(const GraphicsHandle graphics)
+{
+    return Parser::graphics.IsValid(graphics) ? GetVersion(m_Graphics, graphics.index) : 0;
+}
+
+uint64_t TextureCache::GetVersion(const TilemapHandle tilemap)
+{
+    return Parser::tilemaps.IsValid(tilemap) ? GetVersion(m_Tilemaps, tilemap.index) : 0;
+}
+
+void TextureCache::SetMemoryBudget(const size_t bytes)
+{
+    m_MemoryBudget = bytes;
+    Evict();
+}
+
+uint64_t TextureCache::GetVersion(const std::vector<Entry>& entries, const uint32_t index)
+{
+    return index < entries.size() ? entries[index].version : 0;
+}
+
+void TextureCache::OnChange(const ChangeEvent& event)
+{
+    // A tile is a row of 8 texels
+    if (event.type == ChangeType::Graphics)
+        MarkDirty(m_Graphics, event.target, event.x0, 0, event.x1, 7);
+    else
+        MarkDirty(m_Tilemaps, event.target, event.y0, event.x0, event.y1, event.x1);
+}
+
+void TextureCache::MarkDirty(std::vector<Entry>& entries, const uint32_t index, const size_t firstRow, const size_t firstColumn, const size_t lastRow,
+    const size_t lastColumn)
+{
+    if (index >= entries.size() || !entries[index].allocated)
+        return;
+
+    Entry& entry = entries[index];
+
+    // The rows in between are uploaded as well, a single contiguous range is enough for the strokes of the editors
+    const size_t first = firstRow * entry.rowLength + std::min(firstColumn, entry.rowLength - 1);
+    const size_t last = lastRow == ChangeEvent::All ? NotDirty - 1 : lastRow * entry.rowLength + std::min(lastColumn, entry.rowLength - 1);
+
+    entry.firstDirty = std::min(entry.firstDirty, first);
+    entry.lastDirty = std::max(entry.lastDirty, last);
+}
+
+const Texture& TextureCache::Update(std::vector<Entry>& entries, const uint32_t index, const uint32_t generation, const int32_t width, const size_t rowLength,
+    const int32_t internalFormat, const int32_t format, const size_t texelSize, const std::span<const uint8_t> data)
+{
+    if (index >= entries.size())
+        entries.resize(index + 1);
+
+    Entry& entry = entries[index];
+    entry.lastUse = m_Frame;
+
+    // Graphics textures are twice as wide as their data, only the texels holding data are uploaded
+    const size_t texelCount = data.size() / texelSize;
+
+    if (!entry.allocated || entry.generation != generation || entry.width != width || entry.rowLength != rowLength)
+    {
+        if (!entry.allocated)
+            entry.texture.Create();
+
+        m_MemoryUsage -= entry.bytes;
+
+        entry.allocated = true;
+        entry.generation = generation;
+        entry.width = width;
+        entry.rowLength = std::max<size_t>(rowLength, 1);
+        entry.bytes = static_cast<size_t>(std::max(width, 1)) * texelSize;
+        entry.texture.SetData(internalFormat, format, std::max(width, 1), 1, nullptr);
+
+        m_MemoryUsage += entry.bytes;
+        entry.version = ++m_VersionCounter;
+
+        entry.firstDirty = 0;
+        entry.lastDirty = NotDirty - 1;
+    }
+
+    if (entry.firstDirty != NotDirty && texelCount > 0)
+    {
+        const size_t first = std::min(entry.firstDirty, texelCount - 1);
+        const size_t last = std::min(entry.lastDirty, texelCount - 1);
+
+        if (first <= last)
+        {
+            Upload(entry.texture, format, texelSize, first, data.subspan(first * texelSize, (last - first + 1) * texelSize));
+            entry.version = ++m_VersionCounter;
+        }
+    }
+
+    entry.firstDirty = NotDirty;
+    entry.lastDirty = 0;
+
+    return entry.texture;
+}
+
+void TextureCache::Upload(const Texture& texture, const int32_t format, const size_t texelSize, const size_t firstTexel, const std::span<const uint8_t> data)
+{
+    const int32_t x = static_cast<int32_t>(firstTexel);
+    const int32_t texels = static_cast<int32_t>(data.size() / texelSize);
+
+    if (data.size() < PixelBufferThreshold)
+    {
+        texture.SetSubData(format, x, 0, texels, 1, data.data());
+        return;
+    }
+
+    // Orphaning the previous storage lets the driver hand out a new one instead of waiting for the previous upload
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(data.size()), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(data.size()), data.data());
+
+    texture.SetSubData(format, x, 0, texels, 1, nullptr);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void TextureCache::Release(Entry& entry)
+{
+    if (!entry.allocated)
+        return;
+
+    entry.texture.Destroy();
+    m_MemoryUsage -= entry.bytes;
+
+    entry = {};
+}
+
+void TextureCache::EndFrame()
+{
+    Evict();
+    m_Frame++;
+}
+
+void TextureCache::Evict()
+{
+    while (m_MemoryUsage > m_MemoryBudget)
+    {
+        Entry* oldest = nullptr;
+
+        for (std::vector<Entry>* const entries : { &m_Graphics, &m_Tilemaps })
+        {
+            for (Entry& entry : *entries)
+            {
+                // The textures of this frame may still be bound by a caller
+                if (entry.allocated && entry.lastUse != m_Frame && (oldest == nullptr || entry.lastUse < oldest->lastUse))
+                    oldest = &entry;
+            }
+        }
+
+        if (oldest == nullptr)
+            return;
+
+        Release(*oldest);
+    }
+}
@@ -0,0 +1,64 @@
+﻿#include "tile.hpp"
+
+#include <bit>
+
+Color Tile::GetPixel(const size_t x, const size_t y) const
+{
+    const size_t bitIndex = 7 - x;
+    return static_cast<Color>((GetPlane(y, 0) >> bitIndex & 1) | (GetPlane(y, 1) >> bitIndex & 1) << 1);
+}
+
+void Tile::SetPixel(const size_t x, const size_t y, const Color color)
+{
+    const size_t bitIndex = 7 - x;
+
+    uint8_t& plane0 = GetPlane(y, 0);
+    uint8_t& plane1 = GetPlane(y, 1);
+
+    plane0 = static_cast<uint8_t>((plane0 & ~(1 << bitIndex)) | (color >> 0 & 1) << bitIndex);
+    plane1 = static_cast<uint8_t>((plane1 & ~(1 << bitIndex)) | (color >> 1 & 1) << bitIndex);
+}
+
+Tile Tile::FlipX() const
+{
+    // Reverses the bits of every byte, 8 bytes at a time
+    Tile result;
+
+    for (size_t i = 0; i < sizeof(data); i += sizeof(uint64_t))
+    {
+        uint64_t v;
+        std::memcpy(&v, data.data() + i, sizeof(v));
+
+        v = (v & 0xF0F0F0F0F0F0F0F0ull) >> 4 | (v & 0x0F0F0F0F0F0F0F0Full) << 4;
+        v = (v & 0xCCCCCCCCCCCCCCCCull) >> 2 | (v & 0x3333333333333333ull) << 2;
+        v = (v & 0xAAAAAAAAAAAAAAAAull) >> 1 | (v & 0x5555555555555555ull) << 1;
+
+        std::memcpy(result.data.data() + i, &v, sizeof(v));
+    }
+
+    return result;
+}
+
+Tile Tile::FlipY() const
+{
+    // Rows are 16 bit wide, so reversing them keeps the planes in order
+    Tile result;
+
+    for (size_t row = 0; row < 8; row++)
+    {
+        result.GetPlane(row, 0) = GetPlane(7 - row, 0);
+        result.GetPlane(row, 1) = GetPlane(7 - row, 1);
+    }
+
+    return result;
+}
+
+size_t Tile::GetHash() const
+{
+    uint64_t low;
+    uint64_t high;
+    std::memcpy(&low, data.data(), sizeof(low));
+    std::memcpy(&high, data.data() + sizeof(low), sizeof(high));
+
+    return static_cast<size_t>(low * 0x9E3779B97F4A7C15ull ^ std::rotl(high, 31));
+}
@@ -0,0 +1,193 @@
+﻿#include "tile_remap.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+#include "archive.hpp"
+#include "change_bus.hpp"
+#include "collision_grid.hpp"
+
+TileMapping TileRemap::Identity()
+{
+    TileMapping mapping;
+    std::iota(mapping.begin(), mapping.end(), static_cast<uint8_t>(0));
+    return mapping;
+}
+
+void TileRemap::Capture(const GraphicsHandle graphics, const TileMapping& mapping)
+{
+    m_Tilemaps.clear();
+    m_Oam.clear();
+
+    for (size_t i = 0; i < mapping.size(); i++)
+    {
+        const uint8_t tile = static_cast<uint8_t>(i);
+        if (mapping[tile] == tile)
+            continue;
+
+        for (const TilemapHandle tilemap : ReferenceIndex::GetTilemapsUsingTile(graphics, tile))
+        {
+            std::vector<TilemapEdits>::iterator it = std::ranges::find(m_Tilemaps, tilemap, &TilemapEdits::tilemap);
+            if (it == m_Tilemaps.end())
+            {
+                m_Tilemaps.emplace_back(tilemap);
+                it = m_Tilemaps.end() - 1;
+            }
+
+            for (const uint32_t cell : ReferenceIndex::GetTileCells(tilemap, tile))
+                it->edits.emplace_back(cell, tile, mapping[tile]);
+        }
+
+        for (const OamReference& reference : ReferenceIndex::GetOamUsingTile(graphics, tile))
+            m_Oam.emplace_back(reference, tile, mapping[tile]);
+    }
+
+    // Keeps the parts of each animation together, so it is indexed again only once
+    std::ranges::stable_sort(m_Oam, {}, [](const OamEdit& edit) { return edit.reference.animation.index; });
+}
+
+void TileRemap::Apply() const
+{
+    Write(false);
+}
+
+void TileRemap::Revert() const
+{
+    Write(true);
+}
+
+size_t TileRemap::GetReferenceCount() const
+{
+    size_t count = m_Oam.size();
+
+    for (const TilemapEdits& tilemapEdits : m_Tilemaps)
+        count += tilemapEdits.edits.size();
+
+    return count;
+}
+
+std::vector<AssetTag> TileRemap::GetAssets() const
+{
+    std::vector<AssetTag> assets;
+
+    for (const TilemapEdits& tilemapEdits : m_Tilemaps)
+        assets.emplace_back(ChangeType::Tilemap, tilemapEdits.tilemap.index);
+
+    // The edits are sorted by animation
+    for (size_t i = 0; i < m_Oam.size(); i++)
+    {
+        if (i == 0 || m_Oam[i].reference.animation != m_Oam[i - 1].reference.animation)
+            assets.emplace_back(ChangeType::Animation, m_Oam[i].reference.animation.index);
+    }
+
+    return assets;
+}
+
+size_t TileRemap::GetMemoryFootprint() const
+{
+    size_t footprint = m_Tilemaps.capacity() * sizeof(TilemapEdits) + m_Oam.capacity() * sizeof(OamEdit);
+
+    for (const TilemapEdits& tilemapEdits : m_Tilemaps)
+        footprint += tilemapEdits.edits.capacity() * sizeof(CellEdit);
+
+    return footprint;
+}
+
+void TileRemap::Serialize(ArchiveWriter& writer) const
+{
+    writer.Write<uint32_t>(static_cast<uint32_t>(m_Tilemaps.size()));
+    for (const TilemapEdits& tilemapEdits : m_Tilemaps)
+    {
+        writer.WriteHandle(Parser::tilemaps, tilemapEdits.tilemap);
+        writer.WriteSpan(std::span<const CellEdit>(tilemapEdits.edits));
+    }
+
+    writer.Write<uint32_t>(static_cast<uint32_t>(m_Oam.size()));
+    for (const OamEdit& edit : m_Oam)
+    {
+        writer.WriteHandle(Parser::animations, edit.reference.animation);
+        writer.Write(edit.reference.frame);
+        writer.Write(edit.reference.entry);
+        writer.Write(edit.oldTile);
+        writer.Write(edit.newTile);
+    }
+}
+
+void TileRemap::Deserialize(ArchiveReader& reader)
+{
+    m_Tilemaps.clear();
+    m_Oam.clear();
+
+    // Write skips the edits of assets that don't exist anymore or are out of bounds, so a partial record is harmless
+    const size_t tilemapCount = reader.Read<uint32_t>();
+    for (size_t i = 0; i < tilemapCount && !reader.HasFailed(); i++)
+    {
+        TilemapEdits& tilemapEdits = m_Tilemaps.emplace_back(reader.ReadHandle(Parser::tilemaps));
+        reader.ReadSpan(tilemapEdits.edits);
+    }
+
+    const size_t oamCount = reader.Read<uint32_t>();
+    for (size_t i = 0; i < oamCount && !reader.HasFailed(); i++)
+    {
+        OamEdit& edit = m_Oam.emplace_back();
+        edit.reference.animation = reader.ReadHandle(Parser::animations);
+        edit.reference.frame = reader.Read<uint16_t>();
+        edit.reference.entry = reader.Read<uint8_t>();
+        edit.oldTile = reader.Read<uint8_t>();
+        edit.newTile = reader.Read<uint8_t>();
+    }
+}
+
+void TileRemap::Write(const bool_t revert) const
+{
+    for (const TilemapEdits& tilemapEdits : m_Tilemaps)
+    {
+        Tilemap* const target = Parser::tilemaps.GetMutable(tilemapEdits.tilemap);
+        if (target == nullptr)
+            continue;
+
+        Tilemap& tilemap = *target;
+
+        for (const CellEdit& edit : tilemapEdits.edits)
+        {
+            if (edit.cell >= tilemap.GetSize())
+                continue;
+
+            const size_t x = edit.cell % tilemap.GetWidth();
+            const size_t y = edit.cell / tilemap.GetWidth();
+
+            tilemap[y][x] = revert ? edit.oldTile : edit.newTile;
+            ReferenceIndex::UpdateTile(tilemapEdits.tilemap, x, y);
+            CollisionGridCache::UpdateTile(tilemapEdits.tilemap, x, y);
+            ChangeBus::Publish(ChangeEvent::TilemapRect(tilemapEdits.tilemap, x, y, x, y));
+        }
+    }
+
+    AnimationHandle previous;
+    for (const OamEdit& edit : m_Oam)
+    {
+        const OamReference& reference = edit.reference;
+        Animation* const target = Parser::animations.GetMutable(reference.animation);
+        if (target == nullptr)
+            continue;
+
+        Animation& animation = *target;
+        if (reference.frame >= animation.size() || reference.entry >= animation[reference.frame].oam.size())
+            continue;
+
+        animation[reference.frame].oam[reference.entry].tileIndex = revert ? edit.oldTile : edit.newTile;
+
+        if (reference.animation != previous)
+        {
+            ChangeBus::Publish(ChangeEvent::Animation(reference.animation));
+
+            if (!previous.IsNull())
+                ReferenceIndex::UpdateAnimation(previous);
+
+            previous = reference.animation;
+        }
+    }
+
+    if (!previous.IsNull())
+        ReferenceIndex::UpdateAnimation(previous);
+}
@@ -0,0 +1,32 @@
+﻿#include "tilemap.hpp"
+
+#include <algorithm>
+
+Tilemap::Tilemap(const size_t width, const size_t height, const uint8_t value)
+    : m_Width(width), m_Height(height), m_Data(width * height, value)
+{
+}
+
+Tilemap::Tilemap(const size_t width, const size_t height, std::vector<uint8_t> data)
+    : m_Width(width), m_Height(height), m_Data(std::move(data))
+{
+    m_Data.resize(width * height);
+}
+
+void Tilemap::Resize(const size_t width, const size_t height, const uint8_t value)
+{
+    if (width == m_Width && height == m_Height)
+        return;
+
+    std::vector<uint8_t> data(width * height, value);
+
+    const size_t copyWidth = std::min(width, m_Width);
+    const size_t copyHeight = std::min(height, m_Height);
+
+    for (size_t y = 0; y < copyHeight; y++)
+        std::ranges::copy_n(m_Data.begin() + static_cast<std::ptrdiff_t>(y * m_Width), static_cast<std::ptrdiff_t>(copyWidth), data.begin() + static_cast<std::ptrdiff_t>(y * width));
+
+    m_Width = width;
+    m_Height = height;
+    m_Data = std::move(data);
+}
@@ -0,0 +1,317 @@
+﻿#include "tileset_delta_planner.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <ranges>
+
+#include "application.hpp"
+#include "parser.hpp"
+
+#define TAB "    "
+
+void TilesetDeltaPlanner::Reset()
+{
+    deltas.clear();
+    ordering.clear();
+    m_DeltasComputed = false;
+    m_DeltasDirty = false;
+
+    if (m_Subscription == NoSubscription)
+        m_Subscription = ChangeBus::Subscribe(OnChange, ChangeBus::MaskOf(ChangeType::Door) | ChangeBus::MaskOf(ChangeType::Graphics));
+}
+
+void TilesetDeltaPlanner::ComputeDeltas()
+{
+    deltas.clear();
+    m_DeltasComputed = true;
+    m_DeltasDirty = false;
+
+    const std::vector<std::vector<uint8_t>> roomTilesets = ComputeRoomTilesets();
+
+    for (size_t i = 0; i < Parser::doors.size(); i++)
+    {
+        const Door& door = Parser::doors[i];
+
+        if (door.tileset == 0xFF || door.tileset >= Parser::tilesets.size())
+            continue;
+
+        DoorTilesetDelta& delta = deltas.emplace_back(i, door.tileset);
+
+        if (door.ownerRoom < roomTilesets.size())
+            delta.sourceTilesets = roomTilesets[door.ownerRoom];
+
+        const size_t tileCount = Parser::graphics.Get(Parser::tilesets[door.tileset]).size();
+        for (size_t tile = 0; tile < tileCount; tile++)
+        {
+            // Without any known source tileset, everything has to be uploaded
+            bool_t upload = delta.sourceTilesets.empty();
+
+            for (const uint8_t source : delta.sourceTilesets)
+                upload |= !TilesMatch(source, tile, door.tileset, tile);
+
+            if (upload)
+                delta.tiles.push_back(static_cast<uint8_t>(tile));
+        }
+    }
+}
+
+void TilesetDeltaPlanner::UpdateDeltas()
+{
+    if (m_DeltasComputed && m_DeltasDirty)
+        ComputeDeltas();
+}
+
+void TilesetDeltaPlanner::ComputeOrdering()
+{
+    const size_t tilesetCount = Parser::tilesets.size();
+
+    std::vector<size_t> sizes(tilesetCount);
+    for (size_t t = 0; t < tilesetCount; t++)
+        sizes[t] = Parser::graphics.Get(Parser::tilesets[t]).size();
+
+    // Group identical tiles across tilesets, only the first copy of a tile inside a tileset can be shared
+    std::map<std::array<uint8_t, 16>, std::vector<std::pair<size_t, size_t>>> groups;
+    for (size_t t = 0; t < tilesetCount; t++)
+    {
+        const Graphics& graphics = Parser::graphics.Get(Parser::tilesets[t]);
+
+        for (size_t tile = 0; tile < sizes[t]; tile++)
+        {
+            std::vector<std::pair<size_t, size_t>>& group = groups[graphics[tile].data];
+            if (!std::ranges::contains(group | std::views::keys, t))
+                group.emplace_back(t, tile);
+        }
+    }
+
+    std::vector<const std::vector<std::pair<size_t, size_t>>*> shared;
+    for (const std::vector<std::pair<size_t, size_t>>& group : groups | std::views::values)
+    {
+        if (group.size() >= 2)
+            shared.push_back(&group);
+    }
+
+    // Place the tiles used by the most tilesets first
+    std::ranges::stable_sort(shared, std::greater(), [](const std::vector<std::pair<size_t, size_t>>* const group) { return group->size(); });
+
+    constexpr int32_t freeSlot = -1;
+
+    std::vector<std::vector<int32_t>> slots(tilesetCount);
+    std::vector<std::vector<bool_t>> placed(tilesetCount);
+    for (size_t t = 0; t < tilesetCount; t++)
+    {
+        slots[t].resize(sizes[t], freeSlot);
+        placed[t].resize(sizes[t], false);
+    }
+
+    for (const std::vector<std::pair<size_t, size_t>>* const group : shared)
+    {
+        size_t limit = std::numeric_limits<size_t>::max();
+        for (const size_t t : *group | std::views::keys)
+            limit = std::min(limit, sizes[t]);
+
+        const auto isFree = [&slots, group](const size_t slot)
+        {
+            return std::ranges::all_of(*group, [&slots, slot](const std::pair<size_t, size_t>& entry) { return slots[entry.first][slot] == freeSlot; });
+        };
+
+        // Try to keep the tile where one of the tilesets already has it, to limit the amount of remapping
+        size_t slot = limit;
+        for (const size_t tile : *group | std::views::values)
+        {
+            if (tile < limit && isFree(tile))
+            {
+                slot = tile;
+                break;
+            }
+        }
+
+        if (slot == limit)
+        {
+            slot = 0;
+            while (slot < limit && !isFree(slot))
+                slot++;
+        }
+
+        if (slot == limit)
+            continue;
+
+        for (const std::pair<size_t, size_t>& entry : *group)
+        {
+            slots[entry.first][slot] = static_cast<int32_t>(entry.second);
+            placed[entry.first][entry.second] = true;
+        }
+    }
+
+    // Fill the remaining slots with the tiles that aren't shared, keeping their relative order
+    ordering.assign(tilesetCount, {});
+    for (size_t t = 0; t < tilesetCount; t++)
+    {
+        size_t next = 0;
+        for (size_t tile = 0; tile < sizes[t]; tile++)
+        {
+            if (placed[t][tile])
+                continue;
+
+            while (slots[t][next] != freeSlot)
+                next++;
+
+            slots[t][next] = static_cast<int32_t>(tile);
+        }
+
+        for (const int32_t tile : slots[t])
+            ordering[t].push_back(static_cast<uint8_t>(tile));
+    }
+
+    std::vector<std::vector<uint8_t>> identity(tilesetCount);
+    for (size_t t = 0; t < tilesetCount; t++)
+    {
+        identity[t].resize(sizes[t]);
+        std::iota(identity[t].begin(), identity[t].end(), static_cast<uint8_t>(0));
+    }
+
+    sharedSlotsBefore = CountSharedSlots(identity);
+    sharedSlotsAfter = CountSharedSlots(ordering);
+}
+
+void TilesetDeltaPlanner::Export()
+{
+    // The edits of the current frame aren't flushed yet when saving, so the deltas can't be trusted to be up to date
+    ComputeDeltas();
+
+    const std::string headerFile = Application::projectPath + R"(\include\data\door_tileset_deltas.h)";
+    const std::string sourceFile = Application::projectPath + R"(\src\data\door_tileset_deltas.c)";
+
+    std::ofstream file;
+    file.open(headerFile);
+
+    file << "#ifndef DOOR_TILESET_DELTAS_H\n#define DOOR_TILESET_DELTAS_H\n\n#include \"types.h\"\n\n";
+    file << "extern const u8* const sDoorTilesetDeltas[];\n";
+    file << "\n#endif /* DOOR_TILESET_DELTAS_H */\n";
+
+    file.close();
+
+    file.open(sourceFile);
+
+    file << "#include \"data/door_tileset_deltas.h\"\n";
+
+    // A door without a delta (NULL) reloads the whole tileset
+    std::vector<std::string> symbols(Parser::doors.size(), "NULL");
+
+    for (const DoorTilesetDelta& delta : deltas)
+    {
+        const size_t tileCount = Parser::graphics.Get(Parser::tilesets[delta.targetTileset]).size();
+        if (delta.tiles.size() == tileCount)
+            continue;
+
+        symbols[delta.doorId] = "sDoor" + std::to_string(delta.doorId) + "_TilesetDelta";
+
+        file << "\nstatic const u8 " << symbols[delta.doorId] << "[] = {\n";
+        file << TAB << delta.tiles.size() << ",\n";
+
+        for (size_t i = 0; i < delta.tiles.size(); i++)
+        {
+            if (i % 16 == 0)
+                file << TAB;
+
+            file << static_cast<size_t>(delta.tiles[i]) << ',';
+            file << (i % 16 == 15 || i == delta.tiles.size() - 1 ? '\n' : ' ');
+        }
+
+        file << "};\n";
+    }
+
+    file << "\nconst u8* const sDoorTilesetDeltas[] = {\n";
+
+    for (const std::string& symbol : symbols)
+        file << TAB << symbol << ",\n";
+
+    file << "};\n";
+
+    file.close();
+}
+
+void TilesetDeltaPlanner::OnChange(const ChangeEvent& event)
+{
+    if (event.type == ChangeType::Graphics)
+    {
+        if (!std::ranges::contains(Parser::tilesets | std::views::transform(&GraphicsHandle::index), event.target))
+            return;
+
+        // The proposed slots may not hold the same tiles anymore
+        ordering.clear();
+    }
+
+    // Computed again when the deltas are shown, the ordering is only proposed again on demand
+    m_DeltasDirty = true;
+}
+
+std::vector<std::vector<uint8_t>> TilesetDeltaPlanner::ComputeRoomTilesets()
+{
+    std::vector<std::vector<uint8_t>> roomTilesets(Parser::rooms.size());
+
+    // Propagate the loaded tilesets through the doors until nothing changes, a door that doesn't load
+    // a tileset carries over the tilesets of its owner room
+    bool_t changed = true;
+    while (changed)
+    {
+        changed = false;
+
+        for (const Door& door : Parser::doors)
+        {
+            if (door.targetDoor >= Parser::doors.size() || door.ownerRoom >= roomTilesets.size())
+                continue;
+
+            const uint8_t targetRoom = Parser::doors[door.targetDoor].ownerRoom;
+            if (targetRoom >= roomTilesets.size())
+                continue;
+
+            const std::vector<uint8_t> incoming = door.tileset != 0xFF ? std::vector{ door.tileset } : roomTilesets[door.ownerRoom];
+
+            for (const uint8_t tileset : incoming)
+            {
+                if (std::ranges::contains(roomTilesets[targetRoom], tileset))
+                    continue;
+
+                roomTilesets[targetRoom].push_back(tileset);
+                changed = true;
+            }
+        }
+    }
+
+    return roomTilesets;
+}
+
+bool_t TilesetDeltaPlanner::TilesMatch(const size_t tilesetA, const size_t tileA, const size_t tilesetB, const size_t tileB)
+{
+    const Graphics& a = Parser::graphics.Get(Parser::tilesets[tilesetA]);
+    const Graphics& b = Parser::graphics.Get(Parser::tilesets[tilesetB]);
+
+    if (tileA >= a.size() || tileB >= b.size())
+        return false;
+
+    return a[tileA] == b[tileB];
+}
+
+size_t TilesetDeltaPlanner::CountSharedSlots(const std::vector<std::vector<uint8_t>>& order)
+{
+    size_t count = 0;
+
+    for (size_t a = 0; a < order.size(); a++)
+    {
+        for (size_t b = a + 1; b < order.size(); b++)
+        {
+            const size_t slotCount = std::min(order[a].size(), order[b].size());
+
+            for (size_t slot = 0; slot < slotCount; slot++)
+            {
+                if (TilesMatch(a, order[a][slot], b, order[b][slot]))
+                    count++;
+            }
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,74 @@
+﻿#include "transaction.hpp"
+
+#include "change_bus.hpp"
+#include "actions/transaction_action.hpp"
+
+Transaction::Transaction(const char* const name)
+    : m_Name(name), m_Before(Parser::BeginCapture()), m_Parent(m_Current)
+{
+    m_Current = this;
+    ChangeBus::BeginBatch();
+}
+
+Transaction::~Transaction()
+{
+    if (m_Open)
+        Rollback();
+}
+
+void Transaction::Defer(std::function<void()> effect)
+{
+    m_Deferred.push_back(std::move(effect));
+}
+
+void Transaction::Commit(ActionQueue& queue)
+{
+    if (!m_Open)
+        return;
+
+    Close();
+
+    // Goes to the batch of the parent if there is one
+    ChangeBus::CommitBatch(m_Events);
+
+    if (m_Parent)
+    {
+        Parser::MergeCapture();
+        m_Parent->m_Deferred.append_range(std::move(m_Deferred));
+        return;
+    }
+
+    // Still captured, the effects may write to the project
+    for (const std::function<void()>& effect : m_Deferred)
+        effect();
+
+    // Only the parts that were written to and changed are kept
+    ProjectPatch undo;
+    ProjectPatch redo;
+    Parser::EndCapture(m_Before, undo, redo);
+
+    if (!undo.IsEmpty())
+    {
+        queue.Push(queue.Create<TransactionAction>(m_Name, std::move(undo), std::move(redo), m_Events, std::move(m_Deferred)));
+        Parser::MarkUnsaved();
+    }
+}
+
+void Transaction::Rollback()
+{
+    if (!m_Open)
+        return;
+
+    Close();
+
+    // The listeners never saw the events, the patch publishes the assets it puts back
+    ChangeBus::DiscardBatch();
+
+    Parser::RollbackCapture(m_Before);
+}
+
+void Transaction::Close()
+{
+    m_Open = false;
+    m_Current = m_Parent;
+}
@@ -3,13 +3,17 @@
 #include <iostream>
 
 #include "application.hpp"
+#include "texture_cache.hpp"
 #include "editors/add_resource.hpp"
 #include "editors/animation_editor.hpp"
 #include "editors/collision_table_editor.hpp"
 #include "editors/edit_door_window.hpp"
 #include "editors/edit_sprite_window.hpp"
 #include "editors/graphics_editor.hpp"
+#include "editors/oam_profiler_window.hpp"
 #include "editors/room_editor.hpp"
+#include "editors/sprite_vram_window.hpp"
+#include "editors/tileset_delta_window.hpp"
 #include "editors/tileset_editor.hpp"
 #include "imgui/imgui.h"
 #include "imgui/imgui_internal.h"
@@ -39,13 +43,13 @@ void Ui::MainMenuBar()
         ImGui::BeginDisabled(!Application::IsProjectLoaded());
         if (ImGui::MenuItem("Build"))
         {
-            Parser::Save();
+            UiWindow::SaveProject();
             Application::BuildRom(true);
         }
 
-        if (ImGui::MenuItem("Save"))
+        if (ImGui::MenuItem(Parser::HasUnsavedChanges() ? "Save *###Save" : "Save###Save"))
         {
-            Parser::Save();
+            UiWindow::SaveProject();
         }
 
         ImGui::EndDisabled();
@@ -67,6 +71,15 @@ void Ui::MainMenuBar()
         if (ImGui::MenuItem("Collision table editor"))
             ShowWindow<CollisionTableEditor>();
 
+        if (ImGui::MenuItem("Tileset delta planner"))
+            ShowWindow<TilesetDeltaWindow>();
+
+        if (ImGui::MenuItem("Sprite VRAM planner"))
+            ShowWindow<SpriteVramWindow>();
+
+        if (ImGui::MenuItem("OAM profiler"))
+            ShowWindow<OamProfilerWindow>();
+
         ImGui::EndMenu();
     }
 
@@ -89,6 +102,33 @@ void Ui::MainMenuBar()
     }
     ImGui::EndDisabled();
 
+    if (ImGui::BeginMenu("Debug"))
+    {
+        ImGui::Text("Render passes: %zu executed, %zu skipped", RenderTarget::GetPassesExecuted(), RenderTarget::GetPassesSkipped());
+        ImGui::Text("Texture cache: %zu / %zu KiB", TextureCache::GetMemoryUsage() / 1024, TextureCache::GetMemoryBudget() / 1024);
+
+        ImGui::EndMenu();
+    }
+
+    if (!Parser::warnings.empty())
+    {
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1, 1, 0, 1));
+        const bool_t warningsOpen = ImGui::BeginMenu("Warnings");
+        ImGui::PopStyleColor();
+
+        if (warningsOpen)
+        {
+            for (const std::string& warning : Parser::warnings)
+                ImGui::TextUnformatted(warning.c_str());
+
+            ImGui::Separator();
+            if (ImGui::MenuItem("Clear"))
+                Parser::warnings.clear();
+
+            ImGui::EndMenu();
+        }
+    }
+
     ImGui::EndMainMenuBar();
 
     if (openPopup)
@@ -102,6 +142,10 @@ void Ui::MainMenuBar()
                 ImGui::CloseCurrentPopup();
         }
 
+        // Why the project couldn't be loaded
+        for (const std::string& warning : Parser::warnings)
+            ImGui::TextColored(ImVec4(1, 0, 0, 1), "%s", warning.c_str());
+
         ImGui::EndPopup();
     }
 
@@ -109,6 +153,8 @@ void Ui::MainMenuBar()
 
 void Ui::DrawWindows()
 {
+    UiWindow::CompactHistory();
+
     for (UiWindow* const w : m_Windows)
     {
         if (!w->open)
@@ -131,6 +177,9 @@ void Ui::DrawWindows()
 
 void Ui::OnProjectLoaded()
 {
+    TextureCache::Clear();
+    UiWindow::OpenHistory();
+
     for (UiWindow* const w : m_Windows)
         w->OnProjectLoaded();
 }
@@ -200,49 +249,62 @@ void Ui::DrawPalette(Palette& palette, const float_t size, size_t* selectedColor
     }
 }
 
-void Ui::DrawTile(const RenderTarget& renderTarget, const std::vector<uint8_t>& graphics, const size_t graphicsIndex, const Palette& palette, const bool_t xFlip, const bool_t yFlip)
+void Ui::DrawTile(const RenderTarget& renderTarget, const GraphicsHandle graphics, const size_t graphicsIndex, const Palette& palette, const bool_t xFlip, const bool_t yFlip)
 {
-    const Graphics::difference_type tileId = static_cast<Graphics::difference_type>(graphicsIndex) * 16;
-    const Graphics tileData{graphics.begin() + tileId, graphics.begin() + tileId + 16};
-
-    m_GraphicsTexture.SetData(GL_RG8, GL_RG, 16, 1, tileData.data());
-    m_GraphicsTexture.BindToActive(0);
-
-    m_GraphicsShader.Use();
-    m_GraphicsShader.SetUniform("graphics", 0);
-    m_GraphicsShader.SetUniform("gfxSize", static_cast<int32_t>(tileData.size()));
-    m_GraphicsShader.SetUniform("colors[0]", GetRgbColorVec(palette[0]));
-    m_GraphicsShader.SetUniform("colors[1]", GetRgbColorVec(palette[1]));
-    m_GraphicsShader.SetUniform("colors[2]", GetRgbColorVec(palette[2]));
-    m_GraphicsShader.SetUniform("colors[3]", GetRgbColorVec(palette[3]));
-    m_GraphicsShader.SetUniform("xFlip", xFlip);
-    m_GraphicsShader.SetUniform("yFlip", yFlip);
-
-    renderTarget.Render();
+    const Texture& graphicsTexture = TextureCache::Get(graphics);
+
+    ContentHash inputs = GetGraphicsInputs(graphics, palette);
+    inputs = ContentHash::Of(graphicsIndex, inputs);
+    inputs = ContentHash::Of(static_cast<uint64_t>(xFlip) | static_cast<uint64_t>(yFlip) << 1, inputs);
+
+    if (renderTarget.UpdateInputs(inputs))
+    {
+        graphicsTexture.BindToActive(0);
+
+        m_GraphicsShader.Use();
+        m_GraphicsShader.SetUniform("graphics", 0);
+        m_GraphicsShader.SetUniform("gfxSize", GetGraphicsSize(graphics));
+        m_GraphicsShader.SetUniform("tileOffset", static_cast<int32_t>(graphicsIndex));
+        m_GraphicsShader.SetUniform("colors[0]", GetRgbColorVec(palette[0]));
+        m_GraphicsShader.SetUniform("colors[1]", GetRgbColorVec(palette[1]));
+        m_GraphicsShader.SetUniform("colors[2]", GetRgbColorVec(palette[2]));
+        m_GraphicsShader.SetUniform("colors[3]", GetRgbColorVec(palette[3]));
+        m_GraphicsShader.SetUniform("xFlip", xFlip);
+        m_GraphicsShader.SetUniform("yFlip", yFlip);
+
+        renderTarget.Render();
+    }
+
     renderTarget.Draw();
 }
 
-size_t Ui::DrawGraphics(const RenderTarget& renderTarget, const std::vector<uint8_t>& graphics, const Palette& palette, size_t* const selectedTile)
+size_t Ui::DrawGraphics(const RenderTarget& renderTarget, const GraphicsHandle graphics, const Palette& palette, size_t* const selectedTile)
 {
-    const size_t tileAmount = graphics.size() / 16;
+    const int32_t tileCount = GetGraphicsSize(graphics);
+    const size_t tileAmount = static_cast<size_t>(tileCount) / sizeof(Tile);
 
     const ImVec2 position = GetPosition();
 
-    const int32_t tileCount = static_cast<int32_t>(graphics.size());
-    m_GraphicsTexture.SetData(GL_RG8, GL_RG, tileCount, 1, graphics.data());
-    m_GraphicsTexture.BindToActive(0);
-
-    m_GraphicsShader.Use();
-    m_GraphicsShader.SetUniform("graphics", 0);
-    m_GraphicsShader.SetUniform("gfxSize", tileCount);
-    m_GraphicsShader.SetUniform("colors[0]", GetRgbColorVec(palette[0]));
-    m_GraphicsShader.SetUniform("colors[1]", GetRgbColorVec(palette[1]));
-    m_GraphicsShader.SetUniform("colors[2]", GetRgbColorVec(palette[2]));
-    m_GraphicsShader.SetUniform("colors[3]", GetRgbColorVec(palette[3]));
-    m_GraphicsShader.SetUniform("xFLip", false);
-    m_GraphicsShader.SetUniform("yFLip", false);
-
-    renderTarget.Render();
+    const Texture& graphicsTexture = TextureCache::Get(graphics);
+
+    if (renderTarget.UpdateInputs(GetGraphicsInputs(graphics, palette)))
+    {
+        graphicsTexture.BindToActive(0);
+
+        m_GraphicsShader.Use();
+        m_GraphicsShader.SetUniform("graphics", 0);
+        m_GraphicsShader.SetUniform("gfxSize", tileCount);
+        m_GraphicsShader.SetUniform("tileOffset", 0);
+        m_GraphicsShader.SetUniform("colors[0]", GetRgbColorVec(palette[0]));
+        m_GraphicsShader.SetUniform("colors[1]", GetRgbColorVec(palette[1]));
+        m_GraphicsShader.SetUniform("colors[2]", GetRgbColorVec(palette[2]));
+        m_GraphicsShader.SetUniform("colors[3]", GetRgbColorVec(palette[3]));
+        m_GraphicsShader.SetUniform("xFlip", false);
+        m_GraphicsShader.SetUniform("yFlip", false);
+
+        renderTarget.Render();
+    }
+
     renderTarget.Draw();
 
     const float_t pixelSize = renderTarget.scale;
@@ -265,34 +327,63 @@ size_t Ui::DrawGraphics(const RenderTarget& renderTarget, const std::vector<uint
     return index;
 }
 
-void Ui::DrawTilemap(const RenderTarget& renderTarget, const Graphics& graphics, const Tilemap& tilemap, const Palette& palette)
+void Ui::DrawTilemap(const RenderTarget& renderTarget, const GraphicsHandle graphics, const TilemapHandle tilemap, const Palette& palette)
 {
-    const int32_t tileCount = static_cast<int32_t>(graphics.size());
-    m_GraphicsTexture.SetData(GL_RG8, GL_RG, tileCount, 1, graphics.data());
-
-    std::vector<uint8_t> compactTilemap;
-    for (const std::vector<uint8_t>& i : tilemap)
-        compactTilemap.append_range(i);
-
-    const int32_t tilemapWidth = static_cast<int32_t>(tilemap[0].size());
-    const int32_t tilemapSize = static_cast<int32_t>(compactTilemap.size());
-    m_TilemapTexture.SetData(GL_R8, GL_RED, tilemapSize, 1, compactTilemap.data());
-
-    m_GraphicsTexture.BindToActive(0);
-    m_TilemapTexture.BindToActive(1);
-
-    m_TilemapShader.Use();
-    m_TilemapShader.SetUniform("graphics", 0);
-    m_TilemapShader.SetUniform("tilemap", 1);
-    m_TilemapShader.SetUniform("gfxSize", tileCount);
-    m_TilemapShader.SetUniform("tilemapSize", tilemapSize);
-    m_TilemapShader.SetUniform("tilemapWidth", tilemapWidth);
-    m_TilemapShader.SetUniform("colors[0]", GetRgbColorVec(palette[0]));
-    m_TilemapShader.SetUniform("colors[1]", GetRgbColorVec(palette[1]));
-    m_TilemapShader.SetUniform("colors[2]", GetRgbColorVec(palette[2]));
-    m_TilemapShader.SetUniform("colors[3]", GetRgbColorVec(palette[3]));
-
-    renderTarget.Render();
+    const Texture& tilemapTexture = TextureCache::Get(tilemap);
+
+    const Tilemap::ConstView view = Parser::tilemaps.IsValid(tilemap) ? Parser::tilemaps.Get(tilemap).GetView() : Tilemap::ConstView();
+    DrawTilemap(renderTarget, graphics, view, &tilemapTexture, ContentHash::Of(TextureCache::GetVersion(tilemap)), palette);
+}
+
+void Ui::DrawTilemap(const RenderTarget& renderTarget, const GraphicsHandle graphics, const Tilemap& tilemap, const Palette& palette)
+{
+    // Without a version from the cache, the content itself tells whether the tilemap changed
+    const Tilemap::ConstView view = tilemap.GetView();
+    const ContentHash tilemapInputs = ContentHash::Of(std::span(view.data_handle(), view.size()), ContentHash::Of(view.extent(1)));
+
+    DrawTilemap(renderTarget, graphics, view, nullptr, tilemapInputs, palette);
+}
+
+void Ui::DrawTilemap(const RenderTarget& renderTarget, const GraphicsHandle graphics, const Tilemap& tilemap, const uint64_t version, const Palette& palette)
+{
+    DrawTilemap(renderTarget, graphics, tilemap.GetView(), nullptr, ContentHash::Of(version), palette);
+}
+
+void Ui::DrawTilemap(const RenderTarget& renderTarget, const GraphicsHandle graphics, const Tilemap::ConstView view, const Texture* tilemap,
+    const ContentHash& tilemapInputs, const Palette& palette)
+{
+    const Texture& graphicsTexture = TextureCache::Get(graphics);
+
+    if (renderTarget.UpdateInputs(ContentHash::Combine(GetGraphicsInputs(graphics, palette), tilemapInputs)))
+    {
+        const int32_t tileCount = GetGraphicsSize(graphics);
+        const int32_t tilemapWidth = static_cast<int32_t>(view.extent(1));
+        const int32_t tilemapSize = static_cast<int32_t>(view.size());
+
+        // The tiles are contiguous, so they can be uploaded as is
+        if (tilemap == nullptr)
+        {
+            m_TilemapTexture.SetData(GL_R8, GL_RED, tilemapSize, 1, view.data_handle());
+            tilemap = &m_TilemapTexture;
+        }
+
+        graphicsTexture.BindToActive(0);
+        tilemap->BindToActive(1);
+
+        m_TilemapShader.Use();
+        m_TilemapShader.SetUniform("graphics", 0);
+        m_TilemapShader.SetUniform("tilemap", 1);
+        m_TilemapShader.SetUniform("gfxSize", tileCount);
+        m_TilemapShader.SetUniform("tilemapSize", tilemapSize);
+        m_TilemapShader.SetUniform("tilemapWidth", tilemapWidth);
+        m_TilemapShader.SetUniform("colors[0]", GetRgbColorVec(palette[0]));
+        m_TilemapShader.SetUniform("colors[1]", GetRgbColorVec(palette[1]));
+        m_TilemapShader.SetUniform("colors[2]", GetRgbColorVec(palette[2]));
+        m_TilemapShader.SetUniform("colors[3]", GetRgbColorVec(palette[3]));
+
+        renderTarget.Render();
+    }
+
     renderTarget.Draw();
 }
 
@@ -345,6 +436,9 @@ void Ui::SetupWindow()
     m_Windows.push_back(new AddResource());
     m_Windows.push_back(new TilesetEditor());
     m_Windows.push_back(new CollisionTableEditor());
+    m_Windows.push_back(new TilesetDeltaWindow());
+    m_Windows.push_back(new SpriteVramWindow());
+    m_Windows.push_back(new OamProfilerWindow());
 
     ShowWindow<RoomEditor>();
 }
@@ -354,8 +448,19 @@ void Ui::SetupRenderer()
     m_TilemapShader.Load("shaders/graphics.vert", "shaders/tilemap.frag");
     m_GraphicsShader.Load("shaders/graphics.vert", "shaders/graphics.frag");
 
-    m_GraphicsTexture.Create();
     m_TilemapTexture.Create();
+    TextureCache::Init();
+}
+
+int32_t Ui::GetGraphicsSize(const GraphicsHandle graphics)
+{
+    return Parser::graphics.IsValid(graphics) ? static_cast<int32_t>(Parser::graphics.Get(graphics).size() * sizeof(Tile)) : 0;
+}
+
+ContentHash Ui::GetGraphicsInputs(const GraphicsHandle graphics, const Palette& palette)
+{
+    const std::span<const uint8_t> colors(reinterpret_cast<const uint8_t*>(palette.data()), sizeof(Palette));
+    return ContentHash::Of(colors, ContentHash::Of(TextureCache::GetVersion(graphics)));
 }
 
 ImVec2 Ui::GetPosition()
@@ -1,17 +1,31 @@
 ﻿#include "ui_window.hpp"
 
+#include "application.hpp"
 #include "parser.hpp"
 
 void UiWindow::ProcessShortcuts()
 {
+    UpdateView();
+
     if (ImGui::Shortcut(ImGuiMod_Ctrl | ImGuiKey_Z))
-        m_ActionQueue.StepBack();
+        m_ActionQueue.StepBack(m_View);
 
     if (ImGui::Shortcut(ImGuiMod_Ctrl | ImGuiKey_Y))
-        m_ActionQueue.StepForward();
+        m_ActionQueue.StepForward(m_View);
 
     if (ImGui::Shortcut(ImGuiMod_Ctrl | ImGuiKey_S))
-        Parser::Save();
+        SaveProject();
+}
+
+void UiWindow::OpenHistory()
+{
+    m_ActionQueue.OpenHistory(Application::projectPath + R"(\GameBoyEditor.history)");
+}
+
+void UiWindow::SaveProject()
+{
+    if (Parser::Save())
+        m_ActionQueue.Checkpoint();
 }
 
 void UiWindow::DrawMenuBar()
@@ -19,17 +33,35 @@ void UiWindow::DrawMenuBar()
     if (!ImGui::BeginMenuBar())
         return;
 
-    ImGui::BeginDisabled(!m_ActionQueue.CanGoBackward());
+    UpdateView();
+
+    ImGui::BeginDisabled(!m_CanUndo);
     if (ImGui::Button("<"))
-        m_ActionQueue.StepBack();
+        m_ActionQueue.StepBack(m_View);
     ImGui::SetItemTooltip("Undo");
     ImGui::EndDisabled();
 
-    ImGui::BeginDisabled(!m_ActionQueue.CanGoForward());
+    ImGui::BeginDisabled(!m_CanRedo);
     if (ImGui::Button(">"))
-        m_ActionQueue.StepForward();
+        m_ActionQueue.StepForward(m_View);
     ImGui::SetItemTooltip("Redo");
     ImGui::EndDisabled();
 
     ImGui::EndMenuBar();
 }
+
+void UiWindow::UpdateView()
+{
+    // The view may list the assets of a room, it is only gathered when the history or the view changed
+    const size_t viewKey = GetViewKey();
+    if (m_HistoryVersion == m_ActionQueue.GetVersion() && m_ViewKey == viewKey)
+        return;
+
+    m_HistoryVersion = m_ActionQueue.GetVersion();
+    m_ViewKey = viewKey;
+
+    m_View.clear();
+    GetView(m_View);
+    m_CanUndo = m_ActionQueue.CanGoBackward(m_View);
+    m_CanRedo = m_ActionQueue.CanGoForward(m_View);
+}